@@ -0,0 +1,434 @@
+/*
+ * Nestopia UE
+ *
+ * Copyright (C) 2012-2018 R. Danbrook
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ *
+ */
+
+// Benchmarks: every scenario in a manifest is run headlessly with no filter
+// and then with each video filter, a few times over. Scenarios run one after
+// the other so they do not compete for the CPU. Sound is rendered as usual
+// and thrown away. Each frame after the warm-up is timed on its own so the
+// report can give percentiles, and the final picture and RAM are hashed to
+// make sure every run emulated the same thing.
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <zlib.h>
+
+#include "nstcommon.h"
+#include "config.h"
+#include "bench.h"
+
+#include "core/api/NstApiCheats.hpp"
+
+extern Emulator emulator;
+
+enum {
+	BENCH_OK,
+	BENCH_ERROR,
+	BENCH_UNSUPPORTED
+};
+
+typedef struct {
+	const char *name;
+	Video::RenderState::Filter filter;
+	int width;
+	int height;
+} bench_filter_t;
+
+static const bench_filter_t filters[] = {
+	{ "none", Video::RenderState::FILTER_NONE, Video::Output::WIDTH, Video::Output::HEIGHT },
+	{ "ntsc", Video::RenderState::FILTER_NTSC, Video::Output::NTSC_WIDTH, Video::Output::HEIGHT },
+	{ "2xbr", Video::RenderState::FILTER_2XBR, Video::Output::WIDTH * 2, Video::Output::HEIGHT * 2 },
+	{ "hq2x", Video::RenderState::FILTER_HQ2X, Video::Output::WIDTH * 2, Video::Output::HEIGHT * 2 },
+	{ "2xsai", Video::RenderState::FILTER_2XSAI, Video::Output::WIDTH * 2, Video::Output::HEIGHT * 2 },
+	{ "scale2x", Video::RenderState::FILTER_SCALE2X, Video::Output::WIDTH * 2, Video::Output::HEIGHT * 2 }
+};
+
+#define BENCH_FILTERS (int)(sizeof(filters) / sizeof(filters[0]))
+
+typedef struct {
+	std::vector<double> times; // Nanoseconds per timed frame
+	double seconds;
+	double instructions;
+	unsigned int framehash;
+	unsigned int ramhash;
+} bench_run_t;
+
+typedef struct {
+	int status;
+	const char *error;
+	unsigned long frames; // Timed frames over all runs
+	double fps; // Median of the runs
+	double mean, p50, p90, p99, max;
+	double ips; // Instructions per second, 0 if the core can't count them
+	unsigned int framehash;
+	unsigned int ramhash;
+	bool deterministic;
+} bench_result_t;
+
+typedef struct {
+	std::string name;
+	std::string romname;
+	std::string moviename;
+	std::string rom;
+	std::string movie; // Empty for none
+	unsigned long frames; // 0 to play the movie to its end
+	bench_result_t results[BENCH_FILTERS];
+} bench_entry_t;
+
+static double nst_bench_time() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000.0 + ts.tv_nsec;
+}
+
+static std::string nst_bench_path(const std::string& dir, const std::string& path) {
+	// Paths in the manifest are relative to the manifest itself
+	if (path.empty() || path[0] == '/') { return path; }
+	return dir + path;
+}
+
+static bool nst_bench_manifest(std::vector<bench_entry_t>& entries, const char *filename) {
+	// Read the list of scenarios
+	std::ifstream manifest(filename, std::ifstream::in);
+
+	if (!manifest.is_open()) {
+		fprintf(stderr, "Benchmark: could not open %s\n", filename);
+		return false;
+	}
+
+	std::string dir(filename);
+	dir = dir.find('/') == std::string::npos ? "" : dir.substr(0, dir.rfind('/') + 1);
+
+	std::string line;
+	int linenum = 0;
+
+	while (std::getline(manifest, line)) {
+		linenum++;
+
+		std::istringstream fields(line);
+		bench_entry_t entry;
+		unsigned long frames = 0;
+
+		if (!(fields >> entry.name) || entry.name[0] == '#') { continue; }
+
+		if (!(fields >> entry.romname)) {
+			fprintf(stderr, "Benchmark: no ROM for %s on line %d\n", entry.name.c_str(), linenum);
+			return false;
+		}
+
+		if (!(fields >> entry.moviename)) { entry.moviename = "-"; }
+		fields >> frames;
+
+		entry.rom = nst_bench_path(dir, entry.romname);
+		entry.movie = entry.moviename == "-" ? "" : nst_bench_path(dir, entry.moviename);
+		entry.frames = frames ? frames : entry.movie.empty() ? BENCH_DEFAULT_FRAMES : 0;
+
+		entries.push_back(entry);
+	}
+
+	return true;
+}
+
+static int nst_bench_once(const bench_entry_t *entry, const bench_filter_t *filter, bench_run_t *run, const char **error) {
+	// Run a scenario once in a fresh emulator
+	Emulator emu;
+	Machine machine(emu);
+	Movie movie(emu);
+	Video video(emu);
+	Sound sound(emu);
+
+	if (Cartridge::Database(emulator).IsLoaded()) { Cartridge::Database(emu).Share(emulator); }
+
+	std::ifstream rom(entry->rom.c_str(), std::ifstream::in|std::ifstream::binary);
+
+	if (!rom.is_open() || NES_FAILED(machine.Load(rom, nst_default_system()))) {
+		*error = "could not load ROM";
+		return BENCH_ERROR;
+	}
+
+	// Always start from the same RAM contents
+	machine.SetRamPowerState(0);
+	machine.Power(true);
+
+	std::ifstream moviefile;
+
+	if (!entry->movie.empty()) {
+		moviefile.open(entry->movie.c_str(), std::ifstream::in|std::ifstream::binary);
+
+		if (!moviefile.is_open()) {
+			*error = "could not open movie";
+			return BENCH_ERROR;
+		}
+
+		Nes::Result result = movie.Play(moviefile);
+
+		if (result == Nes::RESULT_ERR_WRONG_MODE) {
+			// Recorded in the other region
+			machine.SetMode(machine.GetMode() == Machine::NTSC ? Machine::PAL : Machine::NTSC);
+			moviefile.clear();
+			moviefile.seekg(0);
+			result = movie.Play(moviefile);
+		}
+
+		if (NES_FAILED(result)) {
+			*error = "could not play movie";
+			return BENCH_ERROR;
+		}
+	}
+
+	Video::RenderState renderstate;
+	renderstate.filter = filter->filter;
+	renderstate.width = filter->width;
+	renderstate.height = filter->height;
+	renderstate.bits.count = 32;
+	renderstate.bits.mask.r = 0x00ff0000;
+	renderstate.bits.mask.g = 0x0000ff00;
+	renderstate.bits.mask.b = 0x000000ff;
+
+	if (NES_FAILED(video.SetRenderState(renderstate))) {
+		*error = "filter not available";
+		return BENCH_UNSUPPORTED;
+	}
+
+	std::vector<uint32_t> pixels(filter->width * filter->height);
+	Video::Output videoout(&pixels[0], filter->width * 4);
+
+	int rate = 48000;
+	int16_t samples[48000 / 50];
+	sound.SetSampleBits(16);
+	sound.SetSampleRate(rate);
+	sound.SetSpeaker(Sound::SPEAKER_MONO);
+	Sound::Output soundout(samples, rate / (machine.GetMode() == Machine::PAL ? 50 : 60));
+
+	Machine::Stats stats;
+	bool counted = NES_SUCCEEDED(machine.GetStats(stats));
+
+	unsigned long limit = entry->frames ? entry->frames : BENCH_MAX_FRAMES;
+
+	run->times.clear();
+	run->times.reserve(limit);
+	run->seconds = 0;
+	run->instructions = 0;
+
+	for (unsigned long frame = 0; frame < BENCH_WARMUP + limit; frame++) {
+		if (!entry->frames && !movie.IsPlaying()) { break; }
+
+		double start = nst_bench_time();
+
+		if (NES_FAILED(emu.Execute(&videoout, &soundout, NULL))) {
+			*error = "emulation failed";
+			return BENCH_ERROR;
+		}
+
+		double ns = nst_bench_time() - start;
+
+		if (frame < BENCH_WARMUP) { continue; }
+
+		run->times.push_back(ns);
+		run->seconds += ns / 1000000000.0;
+
+		if (counted && NES_SUCCEEDED(machine.GetStats(stats))) { run->instructions += stats.instructions; }
+	}
+
+	if (run->times.empty()) {
+		*error = "movie shorter than the warm-up";
+		return BENCH_ERROR;
+	}
+
+	if (!counted) { run->instructions = 0; }
+
+	// Hash the picture as 16 bit little endian palette indices
+	std::vector<unsigned short> indices(Video::Output::WIDTH * Video::Output::HEIGHT);
+	std::vector<unsigned char> bytes(indices.size() * 2);
+
+	video.GetPixels(&indices[0]);
+
+	for (size_t i = 0; i < indices.size(); i++) {
+		bytes[i * 2] = indices[i] & 0xff;
+		bytes[i * 2 + 1] = indices[i] >> 8;
+	}
+
+	run->framehash = crc32(0, &bytes[0], bytes.size());
+	run->ramhash = crc32(0, Cheats(emu).GetRam(), Cheats::RAM_SIZE);
+
+	return BENCH_OK;
+}
+
+static double nst_bench_percentile(const std::vector<double>& sorted, double p) {
+	// Nearest rank percentile
+	size_t rank = (size_t)(p / 100.0 * sorted.size() + 0.5);
+	if (rank < 1) { rank = 1; }
+	if (rank > sorted.size()) { rank = sorted.size(); }
+	return sorted[rank - 1];
+}
+
+static void nst_bench_scenario(bench_entry_t *entry, int filterindex, int runs) {
+	// Run a scenario with one filter and sum up the runs
+	bench_result_t *result = &entry->results[filterindex];
+	std::vector<double> times, fps;
+	double seconds = 0, instructions = 0;
+	bench_run_t run;
+
+	result->status = BENCH_OK;
+	result->error = NULL;
+	result->deterministic = true;
+
+	for (int i = 0; i < runs; i++) {
+		result->status = nst_bench_once(entry, &filters[filterindex], &run, &result->error);
+		if (result->status != BENCH_OK) { return; }
+
+		if (i == 0) {
+			result->framehash = run.framehash;
+			result->ramhash = run.ramhash;
+		}
+		else if (run.framehash != result->framehash || run.ramhash != result->ramhash) {
+			result->deterministic = false;
+		}
+
+		times.insert(times.end(), run.times.begin(), run.times.end());
+		fps.push_back(run.times.size() / run.seconds);
+		seconds += run.seconds;
+		instructions += run.instructions;
+	}
+
+	std::sort(times.begin(), times.end());
+	std::sort(fps.begin(), fps.end());
+
+	result->frames = times.size();
+	result->fps = fps[fps.size() / 2];
+	result->mean = seconds * 1000000000.0 / times.size();
+	result->p50 = nst_bench_percentile(times, 50);
+	result->p90 = nst_bench_percentile(times, 90);
+	result->p99 = nst_bench_percentile(times, 99);
+	result->max = times.back();
+	result->ips = instructions / seconds;
+}
+
+static void nst_bench_string(FILE *fp, const std::string& str) {
+	// Write out a JSON string
+	fputc('"', fp);
+
+	for (size_t i = 0; i < str.size(); i++) {
+		unsigned char c = str[i];
+		if (c == '"' || c == '\\') { fprintf(fp, "\\%c", c); }
+		else if (c < 0x20) { fprintf(fp, "\\u%04x", c); }
+		else { fputc(c, fp); }
+	}
+
+	fputc('"', fp);
+}
+
+static void nst_bench_report(FILE *fp, std::vector<bench_entry_t>& entries, const char *manifest, int runs) {
+	// Write out the JSON report
+	static const char *statuses[] = { "ok", "error", "unsupported" };
+
+	fprintf(fp, "{\n  \"manifest\": ");
+	nst_bench_string(fp, manifest);
+	fprintf(fp, ",\n  \"runs\": %d,\n  \"warmup\": %d,\n", runs, BENCH_WARMUP);
+	fprintf(fp, "  \"scenarios\": [");
+
+	for (size_t i = 0; i < entries.size(); i++) {
+		bench_entry_t *entry = &entries[i];
+
+		fprintf(fp, "%s\n    {\"name\": ", i ? "," : "");
+		nst_bench_string(fp, entry->name);
+		fprintf(fp, ", \"rom\": ");
+		nst_bench_string(fp, entry->romname);
+		fprintf(fp, ", \"movie\": ");
+		if (entry->movie.empty()) { fprintf(fp, "null"); }
+		else { nst_bench_string(fp, entry->moviename); }
+		fprintf(fp, ",\n     \"filters\": [");
+
+		for (int f = 0; f < BENCH_FILTERS; f++) {
+			bench_result_t *result = &entry->results[f];
+
+			fprintf(fp, "%s\n      {\"filter\": \"%s\", \"status\": \"%s\"",
+				f ? "," : "", filters[f].name, statuses[result->status]);
+
+			if (result->status != BENCH_OK) {
+				fprintf(fp, ", \"error\": \"%s\"}", result->error);
+				continue;
+			}
+
+			fprintf(fp, ", \"frames\": %lu, \"fps\": %.1f", result->frames, result->fps);
+			fprintf(fp, ", \"ns\": {\"mean\": %.0f, \"p50\": %.0f, \"p90\": %.0f, \"p99\": %.0f, \"max\": %.0f}",
+				result->mean, result->p50, result->p90, result->p99, result->max);
+
+			if (result->ips > 0) { fprintf(fp, ", \"ips\": %.0f", result->ips); }
+			else { fprintf(fp, ", \"ips\": null"); }
+
+			fprintf(fp, ", \"framehash\": \"%08x\", \"ramhash\": \"%08x\", \"deterministic\": %s}",
+				result->framehash, result->ramhash, result->deterministic ? "true" : "false");
+		}
+
+		fprintf(fp, "\n     ]}");
+	}
+
+	fprintf(fp, "\n  ]\n}\n");
+}
+
+bool nst_bench_run(const bench_conf_t *bconf) {
+	// Run every scenario in the manifest with every filter and write out a report
+	std::vector<bench_entry_t> entries;
+
+	if (!nst_bench_manifest(entries, bconf->manifest)) { return false; }
+
+	int runs = bconf->runs > 0 ? bconf->runs : BENCH_RUNS;
+
+	nst_db_load();
+
+	for (size_t i = 0; i < entries.size(); i++) {
+		for (int f = 0; f < BENCH_FILTERS; f++) {
+			fprintf(stderr, "Benchmark: %s, %s\n", entries[i].name.c_str(), filters[f].name);
+			nst_bench_scenario(&entries[i], f, runs);
+		}
+	}
+
+	FILE *fp = bconf->report ? fopen(bconf->report, "w") : stdout;
+
+	if (!fp) {
+		fprintf(stderr, "Benchmark: could not write %s\n", bconf->report);
+		return false;
+	}
+
+	nst_bench_report(fp, entries, bconf->manifest, runs);
+	if (fp != stdout) { fclose(fp); }
+
+	// A scenario that fails or does not repeat itself makes the numbers useless
+	bool passed = true;
+	for (size_t i = 0; i < entries.size(); i++) {
+		for (int f = 0; f < BENCH_FILTERS; f++) {
+			if (entries[i].results[f].status == BENCH_ERROR) { passed = false; }
+			if (entries[i].results[f].status == BENCH_OK && !entries[i].results[f].deterministic) { passed = false; }
+		}
+	}
+
+	return passed;
+}
@@ -0,0 +1,21 @@
+#ifndef _BENCH_H_
+#define _BENCH_H_
+
+#define BENCH_DEFAULT_FRAMES 3600 // Frames for a scenario with neither a movie nor a count
+#define BENCH_MAX_FRAMES 216000 // Cut movies off after an hour at 60 fps
+#define BENCH_WARMUP 60 // Frames run before timing starts
+#define BENCH_RUNS 3 // Runs of each scenario with each filter
+
+// The manifest lists one scenario per line as "name rom [movie [frames]]",
+// with "-" for no movie. Relative paths are taken from the directory of the
+// manifest. Lines that are empty or start with '#' are skipped.
+
+typedef struct {
+	const char *manifest;
+	const char *report; // JSON report file, NULL for stdout
+	int runs; // 0 for BENCH_RUNS
+} bench_conf_t;
+
+bool nst_bench_run(const bench_conf_t *bconf);
+
+#endif
@@ -0,0 +1,347 @@
+/*
+ * Nestopia UE
+ *
+ * Copyright (C) 2012-2018 R. Danbrook
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ *
+ */
+
+// Screenshots and frame dumps. The emulation thread only copies frames into
+// the queue, a worker thread does the encoding and the writing.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <sys/stat.h>
+
+#include <zlib.h>
+
+#include "nstcommon.h"
+#include "config.h"
+#include "video.h"
+#include "capture.h"
+#include "png.h"
+#include "workqueue.h"
+
+#define CAPTURE_RAW_PIXELS (Video::Output::WIDTH * Video::Output::HEIGHT)
+
+extern Emulator emulator;
+extern nstpaths_t nstpaths;
+
+enum {
+	CAPTURE_JOB_SHOT,
+	CAPTURE_JOB_PNG,
+	CAPTURE_JOB_RAW
+};
+
+typedef struct {
+	int type;
+	int level;
+	char filename[520];
+	int width;
+	int height;
+	void *pixels; // 32-bit BGRA for PNG, 16-bit palette indices for raw
+	size_t size; // Bytes allocated for pixels
+	bool result;
+} capture_job_t;
+
+static capture_job_t jobs[CAPTURE_QUEUE_SIZE];
+static workqueue_t queue;
+
+// Frame dump, the raw file and the previous frame belong to the worker
+static int dumpformat = -1;
+static char dumppath[512];
+static unsigned dumpframes, dumpdropped;
+static FILE *rawfile;
+static uint16_t rawprev[CAPTURE_RAW_PIXELS];
+static unsigned char rawdelta[CAPTURE_RAW_PIXELS * 2];
+
+static int nst_capture_level() {
+	// The configured compression level, within what zlib takes
+	return conf.misc_capture_level < 0 ? 0 : conf.misc_capture_level > 9 ? 9 : conf.misc_capture_level;
+}
+
+static unsigned nst_capture_zlib(unsigned char **out, size_t *outsize,
+	const unsigned char *in, size_t insize, const LodePNGCompressSettings *settings) {
+	// Let zlib do the deflating, it is a lot faster than lodepng at it
+	uLongf size = compressBound(insize);
+	*out = (unsigned char*)malloc(size);
+	if (!*out) { return 83; } // lodepng's allocation failure
+
+	if (compress2(*out, &size, in, insize, *(const int*)settings->custom_context) != Z_OK) {
+		free(*out);
+		*out = NULL;
+		return 83;
+	}
+
+	*outsize = size;
+	return 0;
+}
+
+static bool nst_capture_png(capture_job_t *job) {
+	// Turn the frame into RGBA in place and encode it
+	unsigned char *p = (unsigned char*)job->pixels;
+
+	for (int i = 0; i < job->width * job->height; i++, p += 4) {
+		unsigned char b = p[0];
+		p[0] = p[2];
+		p[2] = b;
+		p[3] = 0xff;
+	}
+
+	LodePNGState state;
+	lodepng_state_init(&state);
+	state.encoder.zlibsettings.custom_zlib = nst_capture_zlib;
+	state.encoder.zlibsettings.custom_context = &job->level;
+
+	unsigned char *png = NULL;
+	size_t pngsize = 0;
+	unsigned error = lodepng_encode(&png, &pngsize, (const unsigned char*)job->pixels, job->width, job->height, &state);
+	if (!error) { error = lodepng_save_file(png, pngsize, job->filename); }
+
+	lodepng_state_cleanup(&state);
+	free(png);
+
+	return !error;
+}
+
+static bool nst_capture_raw(capture_job_t *job) {
+	// Append a frame of palette indices, stored as the change from the last one
+	const uint16_t *pixels = (const uint16_t*)job->pixels;
+
+	for (int i = 0; i < CAPTURE_RAW_PIXELS; i++) {
+		uint16_t delta = pixels[i] ^ rawprev[i];
+		rawdelta[i * 2] = delta & 0xff;
+		rawdelta[i * 2 + 1] = delta >> 8;
+		rawprev[i] = pixels[i];
+	}
+
+	uLongf size = compressBound(sizeof(rawdelta));
+	unsigned char *data = (unsigned char*)malloc(size + 4);
+	if (!data) { return false; }
+
+	bool result = compress2(data + 4, &size, rawdelta, sizeof(rawdelta), job->level) == Z_OK;
+
+	if (result) {
+		for (int i = 0; i < 4; i++) { data[i] = (size >> (i * 8)) & 0xff; }
+		result = fwrite(data, 1, size + 4, rawfile) == size + 4;
+	}
+
+	free(data);
+	return result;
+}
+
+static void nst_capture_process(unsigned slot) {
+	// Runs on the worker, queued frames are encoded in order
+	capture_job_t *job = &jobs[slot];
+
+	job->result = job->type == CAPTURE_JOB_RAW ? nst_capture_raw(job) : nst_capture_png(job);
+
+	if (job->type == CAPTURE_JOB_SHOT) {
+		if (job->result) { fprintf(stderr, "Screenshot: %s\n", job->filename); }
+		else { fprintf(stderr, "Screenshot failed: %s\n", job->filename); }
+	}
+	else if (!job->result) {
+		fprintf(stderr, "Frame dump: write failed: %s\n", job->filename);
+	}
+}
+
+static capture_job_t *nst_capture_slot(bool wait, size_t size) {
+	// Get the next free slot with room for size bytes, or NULL
+	int index = nst_workqueue_slot(&queue, wait);
+	if (index < 0) { return NULL; }
+
+	capture_job_t *slot = &jobs[index];
+
+	if (slot->size < size) {
+		void *pixels = realloc(slot->pixels, size);
+		if (!pixels) { return NULL; }
+		slot->pixels = pixels;
+		slot->size = size;
+	}
+
+	slot->level = nst_capture_level();
+	return slot;
+}
+
+void nst_capture_init() {
+	// Start the capture worker
+	if (queue.running) { return; }
+
+	queue.size = CAPTURE_QUEUE_SIZE;
+	queue.process = nst_capture_process;
+
+	if (!nst_workqueue_start(&queue, "capture")) {
+		fprintf(stderr, "Capture: could not start worker thread: %s\n", SDL_GetError());
+	}
+}
+
+void nst_capture_deinit() {
+	// Finish any pending frames and stop the worker
+	nst_capture_dump_stop();
+	nst_workqueue_stop(&queue);
+
+	for (int i = 0; i < CAPTURE_QUEUE_SIZE; i++) {
+		free(jobs[i].pixels);
+		jobs[i].pixels = NULL;
+		jobs[i].size = 0;
+	}
+}
+
+bool nst_capture_screenshot(const char *filename, const uint32_t *pixels, int width, int height) {
+	// Queue a screenshot, waiting for a free slot if need be
+	size_t size = width * height * 4;
+	capture_job_t job, *slot = NULL;
+
+	if (queue.running) { slot = nst_capture_slot(true, size); }
+
+	if (!slot) {
+		// No worker, do it all here
+		job.pixels = malloc(size);
+		if (!job.pixels) { return false; }
+		job.level = nst_capture_level();
+		slot = &job;
+	}
+
+	slot->type = CAPTURE_JOB_SHOT;
+	slot->width = width;
+	slot->height = height;
+	memcpy(slot->pixels, pixels, size);
+
+	if (filename == NULL) {
+		snprintf(slot->filename, sizeof(slot->filename), "%sscreenshots/%s-%ld-%d.png",
+			nstpaths.nstdir, nstpaths.gamename, time(NULL), rand() % 899 + 100);
+	}
+	else {
+		snprintf(slot->filename, sizeof(slot->filename), "%s", filename);
+	}
+
+	if (slot == &job) {
+		job.result = nst_capture_png(&job);
+		fprintf(stderr, "Screenshot%s: %s\n", job.result ? "" : " failed", job.filename);
+		free(job.pixels);
+		return job.result;
+	}
+
+	nst_workqueue_submit(&queue);
+	return true;
+}
+
+bool nst_capture_dump_start(const char *path, int format) {
+	// Start dumping every frame, to a directory of PNGs or a single raw file
+	nst_capture_dump_stop();
+
+	if (!queue.running) {
+		fprintf(stderr, "Frame dump: no worker thread\n");
+		return false;
+	}
+
+	if (path == NULL) {
+		snprintf(dumppath, sizeof(dumppath), "%sscreenshots/%s-%ld%s",
+			nstpaths.nstdir, nstpaths.gamename, time(NULL), format == CAPTURE_RAW ? ".nfd" : "");
+	}
+	else {
+		snprintf(dumppath, sizeof(dumppath), "%s", path);
+	}
+
+	if (format == CAPTURE_RAW) {
+		rawfile = fopen(dumppath, "wb");
+		if (!rawfile) {
+			fprintf(stderr, "Frame dump: could not open %s\n", dumppath);
+			return false;
+		}
+
+		unsigned char header[12] = { 'N', 'S', 'T', 'F',
+			CAPTURE_RAW_VERSION, 0,
+			Video::Output::WIDTH & 0xff, Video::Output::WIDTH >> 8,
+			Video::Output::HEIGHT & 0xff, Video::Output::HEIGHT >> 8,
+			0, 0 };
+
+		Video video(emulator);
+		fwrite(header, 1, sizeof(header), rawfile);
+		fwrite(video.GetPalette().GetColors(), 3, Video::Palette::NUM_ENTRIES_EXT, rawfile);
+
+		memset(rawprev, 0, sizeof(rawprev));
+	}
+	else if (mkdir(dumppath, 0755) && errno != EEXIST) {
+		fprintf(stderr, "Frame dump: could not create %s\n", dumppath);
+		return false;
+	}
+
+	dumpformat = format;
+	dumpframes = dumpdropped = 0;
+
+	fprintf(stderr, "Frame dump: %s\n", dumppath);
+	nst_video_print("Frame dump started", 8, 212, 2, true);
+
+	return true;
+}
+
+void nst_capture_dump_stop() {
+	// Stop dumping and wait for the last frames to be written
+	if (dumpformat < 0) { return; }
+
+	nst_workqueue_flush(&queue);
+
+	if (rawfile) {
+		fclose(rawfile);
+		rawfile = NULL;
+	}
+
+	dumpformat = -1;
+
+	fprintf(stderr, "Frame dump: %u frames, %u dropped\n", dumpframes, dumpdropped);
+	nst_video_print("Frame dump stopped", 8, 212, 2, true);
+}
+
+bool nst_capture_dumping() {
+	return dumpformat >= 0;
+}
+
+void nst_capture_frame(const uint32_t *pixels, int width, int height) {
+	// Copy a finished frame into the queue, never waits for the worker
+	if (dumpformat < 0) { return; }
+
+	size_t size = dumpformat == CAPTURE_RAW ? sizeof(rawprev) : width * height * 4;
+	capture_job_t *slot = nst_capture_slot(false, size);
+
+	if (!slot) {
+		dumpdropped++;
+		return;
+	}
+
+	if (dumpformat == CAPTURE_RAW) {
+		Video video(emulator);
+		slot->type = CAPTURE_JOB_RAW;
+		slot->width = Video::Output::WIDTH;
+		slot->height = Video::Output::HEIGHT;
+		video.GetPixels((unsigned short*)slot->pixels);
+		snprintf(slot->filename, sizeof(slot->filename), "%s", dumppath);
+	}
+	else {
+		slot->type = CAPTURE_JOB_PNG;
+		slot->width = width;
+		slot->height = height;
+		memcpy(slot->pixels, pixels, size);
+		snprintf(slot->filename, sizeof(slot->filename), "%s/%06u.png", dumppath, dumpframes);
+	}
+
+	dumpframes++;
+	nst_workqueue_submit(&queue);
+}
@@ -0,0 +1,29 @@
+#ifndef _CAPTURE_H_
+#define _CAPTURE_H_
+
+#include <stdint.h>
+
+#define CAPTURE_QUEUE_SIZE 8 // Frames waiting to be encoded, dump frames beyond this are dropped
+
+#define CAPTURE_PNG 0 // One PNG file per frame in a directory
+#define CAPTURE_RAW 1 // Palette indices in a single file, see below
+
+// Raw frame dump layout, all values little-endian:
+//   "NSTF", u16 version (1), u16 width, u16 height, u16 reserved,
+//   512 palette entries of 3 bytes each (R, G, B)
+// followed by one record per frame:
+//   u32 size, then size bytes of zlib data holding width * height u16 palette
+//   indices, each XORed with the same pixel of the previous frame (zero before
+//   the first frame), so unchanged pixels become runs of zeros
+
+#define CAPTURE_RAW_VERSION 1
+
+void nst_capture_init();
+void nst_capture_deinit();
+bool nst_capture_screenshot(const char *filename, const uint32_t *pixels, int width, int height);
+bool nst_capture_dump_start(const char *path, int format);
+void nst_capture_dump_stop();
+bool nst_capture_dumping();
+void nst_capture_frame(const uint32_t *pixels, int width, int height);
+
+#endif
@@ -0,0 +1,129 @@
+/*
+ * Nestopia UE
+ *
+ * Copyright (C) 2012-2018 R. Danbrook
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ *
+ */
+
+
+// Code/data logging: a ROM is run headlessly with the core's logger on and
+// the flags are written in the .cdl layout other tools read. Flags from an
+// earlier run are merged in first, so coverage builds up over several runs.
+
+#include <fstream>
+
+#include <stdio.h>
+
+#include "nstcommon.h"
+#include "config.h"
+#include "cdl.h"
+
+#include "core/api/NstApiCodeDataLogger.hpp"
+
+extern Emulator emulator;
+
+static void nst_cdl_print(CodeDataLogger& cdl, CodeDataLogger::Rom rom, const char *name) {
+	// One line per bank, then the ROM as a whole
+	CodeDataLogger::Coverage cov;
+
+	for (unsigned int i = 0; i <= cdl.NumBanks(rom); i++) {
+		bool total = i == cdl.NumBanks(rom);
+		if (NES_FAILED(total ? cdl.GetCoverage(rom, cov) : cdl.GetCoverage(rom, i, cov))) { continue; }
+
+		char label[16];
+		if (total) { snprintf(label, sizeof(label), "%s", name); }
+		else { snprintf(label, sizeof(label), "%s %3u", name, i); }
+
+		// No ROM to cover, as with CHR-RAM
+		if (!cov.size) {
+			printf("%-8s    n/a\n", label);
+			continue;
+		}
+
+		if (rom == CodeDataLogger::PRG) {
+			printf("%-8s %6.2f%%  code %6lu  data %6lu  pcm %6lu\n", label, 100.0 * cov.logged / cov.size,
+				(unsigned long)cov.code, (unsigned long)cov.data, (unsigned long)cov.pcm);
+		}
+		else {
+			printf("%-8s %6.2f%%  drawn %6lu  read %6lu\n", label, 100.0 * cov.logged / cov.size,
+				(unsigned long)cov.drawn, (unsigned long)cov.read);
+		}
+	}
+}
+
+bool nst_cdl_record(const cdl_conf_t *cdlconf) {
+	Emulator emu;
+	Machine machine(emu);
+	CodeDataLogger cdl(emu);
+
+	nst_db_load();
+	if (Cartridge::Database(emulator).IsLoaded()) { Cartridge::Database(emu).Share(emulator); }
+
+	std::ifstream rom(cdlconf->rom, std::ifstream::in|std::ifstream::binary);
+
+	if (!rom.is_open() || NES_FAILED(machine.Load(rom, nst_default_system()))) {
+		fprintf(stderr, "CDL: could not load %s\n", cdlconf->rom);
+		return false;
+	}
+
+	if (!machine.Is(Machine::CARTRIDGE)) {
+		fprintf(stderr, "CDL: %s is not a cartridge\n", cdlconf->rom);
+		return false;
+	}
+
+	std::ifstream in(cdlconf->out, std::ifstream::in|std::ifstream::binary);
+
+	if (in.is_open() && NES_FAILED(cdl.Load(in))) {
+		fprintf(stderr, "CDL: %s does not match %s\n", cdlconf->out, cdlconf->rom);
+		return false;
+	}
+
+	in.close();
+
+	Input(emu).ConnectController(0, Input::PAD1);
+	Input(emu).ConnectController(1, Input::PAD2);
+
+	machine.SetRamPowerState(0);
+	machine.Power(true);
+
+	if (NES_FAILED(cdl.Start())) {
+		fprintf(stderr, "CDL: could not start the logger\n");
+		return false;
+	}
+
+	Input::Controllers controllers;
+	int frames = cdlconf->frames > 0 ? cdlconf->frames : CDL_FRAMES;
+
+	for (int i = 0; i < frames; i++) {
+		if (NES_FAILED(emu.Execute(NULL, NULL, &controllers))) { break; }
+	}
+
+	cdl.Stop();
+
+	std::ofstream out(cdlconf->out, std::ofstream::out|std::ofstream::binary);
+
+	if (!out.is_open() || NES_FAILED(cdl.Save(out))) {
+		fprintf(stderr, "CDL: could not write %s\n", cdlconf->out);
+		return false;
+	}
+
+	nst_cdl_print(cdl, CodeDataLogger::PRG, "PRG");
+	nst_cdl_print(cdl, CodeDataLogger::CHR, "CHR");
+
+	return true;
+}
@@ -0,0 +1,17 @@
+#ifndef _CDL_H_
+#define _CDL_H_
+
+#define CDL_FRAMES 600 // Frames to run a ROM for while logging
+
+// Code/data logs flag every PRG-ROM and CHR-ROM byte by how the game used it.
+// After a run the coverage of each 8K PRG bank and 1K CHR bank is printed.
+
+typedef struct {
+	const char *rom;
+	const char *out; // Flags are merged into this file if it exists
+	int frames; // Frames to run, 0 for CDL_FRAMES
+} cdl_conf_t;
+
+bool nst_cdl_record(const cdl_conf_t *cdlconf);
+
+#endif
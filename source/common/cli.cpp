@@ -22,10 +22,53 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <getopt.h>
 
 #include "cli.h"
 #include "config.h"
+#include "netplay.h"
+#include "verify.h"
+#include "bench.h"
+#include "testrom.h"
+#include "trace.h"
+#include "cdl.h"
+#include "debug.h"
+#include "shmout.h"
+#include "nvr.h"
+
+// Long options without a short equivalent
+#define CLI_NETPLAY_PLAYER 256
+#define CLI_NETPLAY_PORT 257
+#define CLI_NETPLAY_PEER 258
+#define CLI_NETPLAY_TEST 259
+#define CLI_MOVIE_INDEX 260
+#define CLI_VERIFY 261
+#define CLI_VERIFY_JOBS 262
+#define CLI_VERIFY_REPORT 263
+#define CLI_VERIFY_UPDATE 264
+#define CLI_NVR_CONVERT 265
+#define CLI_BENCH 266
+#define CLI_BENCH_REPORT 267
+#define CLI_BENCH_RUNS 268
+#define CLI_TEST_ROMS 269
+#define CLI_TEST_JOBS 270
+#define CLI_TEST_REPORT 271
+#define CLI_TEST_FRAMES 272
+#define CLI_TRACE 273
+#define CLI_TRACE_FRAMES 274
+#define CLI_TRACE_SIZE 275
+#define CLI_TRACE_COUNT 276
+#define CLI_TRACE_PC 277
+#define CLI_TRACE_FRAME 278
+#define CLI_TRACE_DECODE 279
+#define CLI_TRACE_DIFF 280
+#define CLI_CDL 281
+#define CLI_CDL_FRAMES 282
+#define CLI_BREAK 283
+#define CLI_BREAK_FRAMES 284
+#define CLI_SHM 285
+#define CLI_SHM_FORMAT 286
 
 void cli_error(const char *message) {
 	cli_show_usage();
@@ -50,6 +93,38 @@ void cli_show_usage() {
 	printf("  -u, --unlimitedsprites  Remove sprite limit\n");
 	printf("  -q, --spritelimit       Enable sprite limit\n\n");
 	printf("  -v, --version           Show version information\n\n");
+	printf("      --netplay-player    Netplay as player 1 or 2\n");
+	printf("      --netplay-port      Local UDP port for netplay\n");
+	printf("      --netplay-peer      Netplay peer as host:port\n");
+	printf("      --netplay-test      Test netplay over loopback on FILE\n");
+	printf("                          (latency in frames,packet loss in percent)\n");
+	printf("      --movie-index       Write a seek index for a movie of FILE\n");
+	printf("      --verify            Verify the movies in a manifest\n");
+	printf("      --verify-jobs       Threads to verify movies on (0=one per CPU)\n");
+	printf("      --verify-report     Write the verification report to a file\n");
+	printf("      --verify-update     Write new hashes back to the manifest\n");
+	printf("      --nvr-convert       Convert a video recording to .y4m and .wav\n");
+	printf("      --bench             Benchmark the scenarios in a manifest\n");
+	printf("      --bench-report      Write the benchmark report to a file\n");
+	printf("      --bench-runs        Runs of each scenario with each filter\n");
+	printf("      --test-roms         Run the test ROMs in a directory\n");
+	printf("      --test-jobs         Threads to run test ROMs on (0=one per CPU)\n");
+	printf("      --test-report       Write the test report to a file (.xml for JUnit)\n");
+	printf("      --test-frames       Frames to give each test ROM\n");
+	printf("      --trace             Write a CPU trace of FILE\n");
+	printf("      --trace-frames      Frames to run FILE for while tracing\n");
+	printf("      --trace-size        Instructions kept in the trace\n");
+	printf("      --trace-count       Instructions to trace after the trigger\n");
+	printf("      --trace-pc          Start tracing at an address (hex)\n");
+	printf("      --trace-frame       Start tracing at a frame\n");
+	printf("      --trace-decode      Print a CPU trace as text\n");
+	printf("      --trace-diff        Find where a CPU trace departs from FILE\n");
+	printf("      --cdl               Log the code and data FILE uses to a .cdl file\n");
+	printf("      --cdl-frames        Frames to run FILE for while logging\n");
+	printf("      --break             Print each access to ADDR[-ADDR][:rwx] (hex) by FILE\n");
+	printf("      --break-frames      Frames to run FILE for while debugging\n");
+	printf("      --shm               Write video and audio to a shared memory object\n");
+	printf("      --shm-format        Shared memory video format (rgb, indices)\n\n");
 	printf("More options can be set in the configuration file.\n");
 	printf("Options are saved, and do not need to be set on future invocations.\n\n");
 }
@@ -61,6 +136,19 @@ void cli_show_version() {
 void cli_handle_command(int argc, char *argv[]) {
 	int c;
 	int optint;
+	int nptest_latency = -1, nptest_loss = 0;
+	char *movieindex = NULL;
+	char *nvrconvert = NULL;
+	verify_conf_t vconf = { NULL, NULL, 0, false };
+	bench_conf_t bconf = { NULL, NULL, 0 };
+	testrom_conf_t tconf = { NULL, NULL, 0, 0 };
+	trace_conf_t trconf = { NULL, NULL, 0, 0, 0, -1, -1 };
+	char *tracedecode = NULL;
+	char *tracediff = NULL;
+	cdl_conf_t cdlconf = { NULL, NULL, 0 };
+	debug_conf_t dconf = { NULL, 0, 0, {} };
+	char *shmname = NULL;
+	int shmformat = SHMOUT_RGB;
 
 	while (1) {
 		static struct option long_options[] = {
@@ -80,6 +168,37 @@ void cli_handle_command(int argc, char *argv[]) {
 			{"unlimitedsprites", no_argument, 0, 'u'},
 			{"spritelimit", no_argument, 0, 'q'},
 			{"version", no_argument, 0, 'v'},
+			{"netplay-player", required_argument, 0, CLI_NETPLAY_PLAYER},
+			{"netplay-port", required_argument, 0, CLI_NETPLAY_PORT},
+			{"netplay-peer", required_argument, 0, CLI_NETPLAY_PEER},
+			{"netplay-test", required_argument, 0, CLI_NETPLAY_TEST},
+			{"movie-index", required_argument, 0, CLI_MOVIE_INDEX},
+			{"verify", required_argument, 0, CLI_VERIFY},
+			{"verify-jobs", required_argument, 0, CLI_VERIFY_JOBS},
+			{"verify-report", required_argument, 0, CLI_VERIFY_REPORT},
+			{"verify-update", no_argument, 0, CLI_VERIFY_UPDATE},
+			{"nvr-convert", required_argument, 0, CLI_NVR_CONVERT},
+			{"bench", required_argument, 0, CLI_BENCH},
+			{"bench-report", required_argument, 0, CLI_BENCH_REPORT},
+			{"bench-runs", required_argument, 0, CLI_BENCH_RUNS},
+			{"test-roms", required_argument, 0, CLI_TEST_ROMS},
+			{"test-jobs", required_argument, 0, CLI_TEST_JOBS},
+			{"test-report", required_argument, 0, CLI_TEST_REPORT},
+			{"test-frames", required_argument, 0, CLI_TEST_FRAMES},
+			{"trace", required_argument, 0, CLI_TRACE},
+			{"trace-frames", required_argument, 0, CLI_TRACE_FRAMES},
+			{"trace-size", required_argument, 0, CLI_TRACE_SIZE},
+			{"trace-count", required_argument, 0, CLI_TRACE_COUNT},
+			{"trace-pc", required_argument, 0, CLI_TRACE_PC},
+			{"trace-frame", required_argument, 0, CLI_TRACE_FRAME},
+			{"trace-decode", required_argument, 0, CLI_TRACE_DECODE},
+			{"trace-diff", required_argument, 0, CLI_TRACE_DIFF},
+			{"cdl", required_argument, 0, CLI_CDL},
+			{"cdl-frames", required_argument, 0, CLI_CDL_FRAMES},
+			{"break", required_argument, 0, CLI_BREAK},
+			{"break-frames", required_argument, 0, CLI_BREAK_FRAMES},
+			{"shm", required_argument, 0, CLI_SHM},
+			{"shm-format", required_argument, 0, CLI_SHM_FORMAT},
 			{0, 0, 0, 0}
 		};
 		
@@ -161,9 +280,218 @@ void cli_handle_command(int argc, char *argv[]) {
 				exit(0);
 				break;
 			
+			case CLI_NETPLAY_PLAYER:
+				optint = atoi(optarg);
+				if (optint == 1 || optint == 2) {
+					nst_netplay_configure(optint, 0, NULL);
+				}
+				else {
+					cli_error("Error: Invalid netplay player");
+				}
+				break;
+			
+			case CLI_NETPLAY_PORT:
+				optint = atoi(optarg);
+				if (optint > 0 && optint < 65536) {
+					nst_netplay_configure(0, optint, NULL);
+				}
+				else {
+					cli_error("Error: Invalid netplay port");
+				}
+				break;
+			
+			case CLI_NETPLAY_PEER:
+				nst_netplay_configure(0, 0, optarg);
+				break;
+			
+			case CLI_NETPLAY_TEST:
+				if (sscanf(optarg, "%d,%d", &nptest_latency, &nptest_loss) < 1 ||
+					nptest_latency < 0 || nptest_loss < 0 || nptest_loss > 100) {
+					cli_error("Error: Invalid netplay test parameters");
+				}
+				break;
+			
+			case CLI_MOVIE_INDEX:
+				movieindex = optarg;
+				break;
+			
+			case CLI_VERIFY:
+				vconf.manifest = optarg;
+				break;
+			
+			case CLI_VERIFY_JOBS:
+				vconf.jobs = atoi(optarg);
+				if (vconf.jobs < 0) { cli_error("Error: Invalid number of verify jobs"); }
+				break;
+			
+			case CLI_VERIFY_REPORT:
+				vconf.report = optarg;
+				break;
+			
+			case CLI_VERIFY_UPDATE:
+				vconf.update = true;
+				break;
+			
+			case CLI_NVR_CONVERT:
+				nvrconvert = optarg;
+				break;
+			
+			case CLI_BENCH:
+				bconf.manifest = optarg;
+				break;
+			
+			case CLI_BENCH_REPORT:
+				bconf.report = optarg;
+				break;
+			
+			case CLI_BENCH_RUNS:
+				bconf.runs = atoi(optarg);
+				if (bconf.runs < 1) { cli_error("Error: Invalid number of benchmark runs"); }
+				break;
+			
+			case CLI_TEST_ROMS:
+				tconf.dir = optarg;
+				break;
+			
+			case CLI_TEST_JOBS:
+				tconf.jobs = atoi(optarg);
+				if (tconf.jobs < 0) { cli_error("Error: Invalid number of test jobs"); }
+				break;
+			
+			case CLI_TEST_REPORT:
+				tconf.report = optarg;
+				break;
+			
+			case CLI_TEST_FRAMES:
+				tconf.frames = atoi(optarg);
+				if (tconf.frames < 1) { cli_error("Error: Invalid number of test frames"); }
+				break;
+			
+			case CLI_TRACE:
+				trconf.out = optarg;
+				break;
+			
+			case CLI_TRACE_FRAMES:
+				trconf.frames = atoi(optarg);
+				if (trconf.frames < 1) { cli_error("Error: Invalid number of trace frames"); }
+				break;
+			
+			case CLI_TRACE_SIZE:
+				trconf.size = strtoul(optarg, NULL, 0);
+				if (trconf.size < 1) { cli_error("Error: Invalid trace size"); }
+				break;
+			
+			case CLI_TRACE_COUNT:
+				trconf.count = strtoul(optarg, NULL, 0);
+				break;
+			
+			case CLI_TRACE_PC:
+				trconf.pc = strtol(optarg, NULL, 16);
+				if (trconf.pc < 0 || trconf.pc > 0xffff) { cli_error("Error: Invalid trace address"); }
+				break;
+			
+			case CLI_TRACE_FRAME:
+				trconf.frame = atoi(optarg);
+				if (trconf.frame < 0) { cli_error("Error: Invalid trace frame"); }
+				break;
+			
+			case CLI_TRACE_DECODE:
+				tracedecode = optarg;
+				break;
+			
+			case CLI_TRACE_DIFF:
+				tracediff = optarg;
+				break;
+			
+			case CLI_CDL:
+				cdlconf.out = optarg;
+				break;
+			
+			case CLI_CDL_FRAMES:
+				cdlconf.frames = atoi(optarg);
+				if (cdlconf.frames < 1) { cli_error("Error: Invalid number of logging frames"); }
+				break;
+			
+			case CLI_BREAK:
+				if (dconf.numbreaks >= DEBUG_MAX_BREAKS) { cli_error("Error: Too many breakpoints"); }
+				if (!nst_debug_parse(optarg, &dconf.breaks[dconf.numbreaks++])) { cli_error("Error: Invalid breakpoint"); }
+				break;
+			
+			case CLI_BREAK_FRAMES:
+				dconf.frames = atoi(optarg);
+				if (dconf.frames < 1) { cli_error("Error: Invalid number of debugging frames"); }
+				break;
+			
+			case CLI_SHM:
+				shmname = optarg;
+				break;
+			
+			case CLI_SHM_FORMAT:
+				if (!strcmp(optarg, "rgb")) { shmformat = SHMOUT_RGB; }
+				else if (!strcmp(optarg, "indices")) { shmformat = SHMOUT_INDICES; }
+				else { cli_error("Error: Invalid shared memory format"); }
+				break;
+			
 			default:
 				cli_error("Error: Invalid option");
 				break;
 		}
 	}
+	
+	if (nptest_latency >= 0) {
+		if (optind >= argc) { cli_error("Error: No file to test netplay with"); }
+		exit(nst_netplay_test(argv[optind], 600, nptest_latency, nptest_loss) ? 0 : 1);
+	}
+	
+	if (nvrconvert) {
+		exit(nst_nvr_convert(nvrconvert) ? 0 : 1);
+	}
+	
+	if (movieindex) {
+		if (optind >= argc) { cli_error("Error: No file to index the movie with"); }
+		exit(nst_movie_index(movieindex, argv[optind]) ? 0 : 1);
+	}
+	
+	if (vconf.manifest) {
+		exit(nst_verify_run(&vconf) ? 0 : 1);
+	}
+	
+	if (bconf.manifest) {
+		exit(nst_bench_run(&bconf) ? 0 : 1);
+	}
+	
+	if (tconf.dir) {
+		exit(nst_testrom_run(&tconf) ? 0 : 1);
+	}
+	
+	if (trconf.out) {
+		if (optind >= argc) { cli_error("Error: No file to trace"); }
+		trconf.rom = argv[optind];
+		exit(nst_trace_record(&trconf) ? 0 : 1);
+	}
+	
+	if (tracedecode) {
+		exit(nst_trace_decode(tracedecode) ? 0 : 1);
+	}
+	
+	if (tracediff) {
+		if (optind >= argc) { cli_error("Error: No trace to compare with"); }
+		exit(nst_trace_diff(tracediff, argv[optind]) == 0 ? 0 : 1);
+	}
+	
+	if (cdlconf.out) {
+		if (optind >= argc) { cli_error("Error: No file to log"); }
+		cdlconf.rom = argv[optind];
+		exit(nst_cdl_record(&cdlconf) ? 0 : 1);
+	}
+	
+	if (dconf.numbreaks) {
+		if (optind >= argc) { cli_error("Error: No file to debug"); }
+		dconf.rom = argv[optind];
+		exit(nst_debug_run(&dconf) ? 0 : 1);
+	}
+	
+	if (shmname && !nst_shmout_start(shmname, shmformat)) {
+		exit(1);
+	}
 }
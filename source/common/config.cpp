@@ -96,6 +96,10 @@ void config_file_write(const char *nstdir) {
 		fprintf(fp, "stereo=%d\n\n", conf.audio_stereo);
 		fprintf(fp, "; Valid values are 11025, 22050, 44100, 48000, and 96000.\n");
 		fprintf(fp, "sample_rate=%d\n\n", conf.audio_sample_rate);
+		fprintf(fp, "; Target latency in milliseconds. Valid values are 10 to 250.\n");
+		fprintf(fp, "latency=%d\n\n", conf.audio_latency);
+		fprintf(fp, "; Adjust the rate slightly to keep the latency steady. Valid values are 1 and 0.\n");
+		fprintf(fp, "drc=%d\n\n", conf.audio_drc);
 		fprintf(fp, "; Valid values are 0 to 100.\n");
 		fprintf(fp, "volume=%d\n", conf.audio_volume);
 		fprintf(fp, "vol_sq1=%d\n", conf.audio_vol_sq1);
@@ -117,11 +121,21 @@ void config_file_write(const char *nstdir) {
 		fprintf(fp, "speed=%d\n\n", conf.timing_speed);
 		fprintf(fp, "; Fast-Forward Speed\n");
 		fprintf(fp, "ffspeed=%d\n\n", conf.timing_ffspeed);
+		fprintf(fp, "; Fast-forward as fast as possible instead. Valid values are 1 and 0.\n");
+		fprintf(fp, "ffunbounded=%d\n\n", conf.timing_ffunbounded);
 		fprintf(fp, "; Pulse turbo buttons every n frames. Minimum value is 2.\n");
 		fprintf(fp, "turbopulse=%d\n\n", conf.timing_turbopulse);
 		fprintf(fp, "; Valid values are 1 and 0.\n");
 		fprintf(fp, "vsync=%d\n", conf.timing_vsync);
 		fprintf(fp, "limiter=%d\n", conf.timing_limiter);
+		fprintf(fp, "; Time frames with the frame pacer instead of the display and audio.\n");
+		fprintf(fp, "pacer=%d\n", conf.timing_pacer);
+		fprintf(fp, "; Emulate in a thread of its own, apart from the display. Valid values are 1 and 0.\n");
+		fprintf(fp, "emuthread=%d\n", conf.timing_emuthread);
+		fprintf(fp, "; Read the joysticks when the game reads the pads. Valid values are 1 and 0.\n");
+		fprintf(fp, "latepoll=%d\n", conf.timing_latepoll);
+		fprintf(fp, "; Show frame time and event counts. Needs a build with --enable-profile.\n");
+		fprintf(fp, "stats=%d\n", conf.timing_stats);
 		fprintf(fp, "\n"); // End of Section
 		
 		// Misc
@@ -143,6 +157,14 @@ void config_file_write(const char *nstdir) {
 		fprintf(fp, "homebrew_exit=%d\n", conf.misc_homebrew_exit);
 		fprintf(fp, "homebrew_stdout=%d\n", conf.misc_homebrew_stdout);
 		fprintf(fp, "homebrew_stderr=%d\n", conf.misc_homebrew_stderr);
+		fprintf(fp, "; Frames between state hashes in recorded movies, 0 to disable.\n");
+		fprintf(fp, "movie_hash=%d\n", conf.misc_movie_hash);
+		fprintf(fp, "; Frames between seekable states in recorded movies, 0 to disable.\n");
+		fprintf(fp, "movie_keyframes=%d\n", conf.misc_movie_keyframes);
+		fprintf(fp, "; Frame dump format: 0=PNG files, 1=Raw palette indices (.nfd)\n");
+		fprintf(fp, "capture_format=%d\n", conf.misc_capture_format);
+		fprintf(fp, "; Compression level for screenshots and frame dumps, 0 to 9.\n");
+		fprintf(fp, "capture_level=%d\n", conf.misc_capture_level);
 
 		fclose(fp);
 	}
@@ -181,6 +203,8 @@ void config_set_default() {
 	conf.audio_api = 0;
 	conf.audio_stereo = false;
 	conf.audio_sample_rate = 48000;
+	conf.audio_latency = 48;
+	conf.audio_drc = true;
 	conf.audio_volume = 85;
 	conf.audio_vol_sq1 = 85;
 	conf.audio_vol_sq2 = 85;
@@ -197,9 +221,14 @@ void config_set_default() {
 	// Timing
 	conf.timing_speed = 60;
 	conf.timing_ffspeed = 3;
+	conf.timing_ffunbounded = false;
 	conf.timing_turbopulse = 3;
 	conf.timing_vsync = true;
 	conf.timing_limiter = true;
+	conf.timing_pacer = false;
+	conf.timing_emuthread = false;
+	conf.timing_latepoll = false;
+	conf.timing_stats = false;
 	
 	// Misc
 	conf.misc_default_system = 0;
@@ -215,6 +244,10 @@ void config_set_default() {
 	conf.misc_homebrew_exit = -1;
 	conf.misc_homebrew_stdout = -1;
 	conf.misc_homebrew_stderr = -1;
+	conf.misc_movie_hash = 0;
+	conf.misc_movie_keyframes = 0;
+	conf.misc_capture_format = 0;
+	conf.misc_capture_level = 6;
 }
 
 static int config_match(void* user, const char* section, const char* name, const char* value) {
@@ -249,6 +282,8 @@ static int config_match(void* user, const char* section, const char* name, const
 	else if (MATCH("audio", "api")) { pconfig->audio_api = atoi(value); }
 	else if (MATCH("audio", "stereo")) { pconfig->audio_stereo = atoi(value); }
 	else if (MATCH("audio", "sample_rate")) { pconfig->audio_sample_rate = atoi(value); }
+	else if (MATCH("audio", "latency")) { pconfig->audio_latency = atoi(value); }
+	else if (MATCH("audio", "drc")) { pconfig->audio_drc = atoi(value); }
 	else if (MATCH("audio", "volume")) { pconfig->audio_volume = atoi(value); }
 	else if (MATCH("audio", "vol_sq1")) { pconfig->audio_vol_sq1 = atoi(value); }
 	else if (MATCH("audio", "vol_sq2")) { pconfig->audio_vol_sq2 = atoi(value); }
@@ -265,9 +300,14 @@ static int config_match(void* user, const char* section, const char* name, const
 	// Timing
 	else if (MATCH("timing", "speed")) { pconfig->timing_speed = atoi(value); }
 	else if (MATCH("timing", "ffspeed")) { pconfig->timing_ffspeed = atoi(value); }
+	else if (MATCH("timing", "ffunbounded")) { pconfig->timing_ffunbounded = atoi(value); }
 	else if (MATCH("timing", "turbopulse")) { pconfig->timing_turbopulse = atoi(value); }
 	else if (MATCH("timing", "vsync")) { pconfig->timing_vsync = atoi(value); }
 	else if (MATCH("timing", "limiter")) { pconfig->timing_limiter = atoi(value); }
+	else if (MATCH("timing", "pacer")) { pconfig->timing_pacer = atoi(value); }
+	else if (MATCH("timing", "emuthread")) { pconfig->timing_emuthread = atoi(value); }
+	else if (MATCH("timing", "latepoll")) { pconfig->timing_latepoll = atoi(value); }
+	else if (MATCH("timing", "stats")) { pconfig->timing_stats = atoi(value); }
     
 	// Misc
 	else if (MATCH("misc", "default_system")) { pconfig->misc_default_system = atoi(value); }
@@ -283,6 +323,10 @@ static int config_match(void* user, const char* section, const char* name, const
 	else if (MATCH("misc", "homebrew_exit")) { pconfig->misc_homebrew_exit = atoi(value); }
 	else if (MATCH("misc", "homebrew_stdout")) { pconfig->misc_homebrew_stdout = atoi(value); }
 	else if (MATCH("misc", "homebrew_stderr")) { pconfig->misc_homebrew_stderr = atoi(value); }
+	else if (MATCH("misc", "movie_hash")) { pconfig->misc_movie_hash = atoi(value); }
+	else if (MATCH("misc", "movie_keyframes")) { pconfig->misc_movie_keyframes = atoi(value); }
+	else if (MATCH("misc", "capture_format")) { pconfig->misc_capture_format = atoi(value); }
+	else if (MATCH("misc", "capture_level")) { pconfig->misc_capture_level = atoi(value); }
 
 	else { return 0; }
 	return 1;
@@ -31,6 +31,8 @@ typedef struct {
 	int audio_api;
 	bool audio_stereo;
 	int audio_sample_rate;
+	int audio_latency;
+	bool audio_drc;
 	int audio_volume;
 	int audio_vol_sq1;
 	int audio_vol_sq2;
@@ -47,9 +49,14 @@ typedef struct {
 	// Timing
 	int timing_speed;
 	int timing_ffspeed;
+	bool timing_ffunbounded;
 	int timing_turbopulse;
 	bool timing_vsync;
 	bool timing_limiter;
+	bool timing_pacer;
+	bool timing_emuthread;
+	bool timing_latepoll;
+	bool timing_stats;
 	
 	// Misc
 	//int misc_video_region;
@@ -65,6 +72,10 @@ typedef struct {
 	int misc_homebrew_exit;
 	int misc_homebrew_stdout;
 	int misc_homebrew_stderr;
+	int misc_movie_hash;
+	int misc_movie_keyframes;
+	int misc_capture_format;
+	int misc_capture_level;
 } settings_t;
 
 void config_file_read(const char *nstdir);
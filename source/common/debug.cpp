@@ -0,0 +1,145 @@
+/*
+ * Nestopia UE
+ *
+ * Copyright (C) 2012-2018 R. Danbrook
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ *
+ */
+
+
+// Breakpoints: a ROM is run headlessly with the core's debugger watching the
+// given addresses, and every break is printed with the CPU registers at the
+// instruction boundary it was reported at.
+
+#include <fstream>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nstcommon.h"
+#include "config.h"
+#include "debug.h"
+
+#include "core/api/NstApiDebugger.hpp"
+
+extern Emulator emulator;
+
+typedef struct {
+	Emulator *emu;
+	unsigned long frame;
+	unsigned long events;
+} debug_state_t;
+
+static void NST_CALLBACK nst_debug_break(void *userData, const Debugger::Event& event) {
+	debug_state_t *state = (debug_state_t*)userData;
+	Debugger::Registers regs;
+
+	if (state->events++ >= DEBUG_MAX_EVENTS) { return; }
+
+	Debugger(*state->emu).GetRegisters(regs);
+
+	const char *type = event.type == Debugger::BREAK_EXEC ? "exec " : event.type == Debugger::BREAK_READ ? "read " : "write";
+
+	printf("%6lu  %s $%04X = %02X  at $%04X  PC:%04X A:%02X X:%02X Y:%02X S:%02X P:%02X\n",
+		state->frame, type, event.address, event.data, event.pc,
+		regs.pc, regs.a, regs.x, regs.y, regs.sp, regs.p);
+
+	if (event.dropped) {
+		printf("%6lu  %u more accesses at $%04X dropped\n", state->frame, event.dropped, event.pc);
+	}
+}
+
+bool nst_debug_parse(const char *spec, debug_break_t *brk) {
+	// ADDR[-ADDR][:rwx], addresses in hex, all of rwx when no flags are given
+	char *end;
+
+	brk->first = brk->last = strtoul(spec, &end, 16);
+	if (end == spec) { return false; }
+
+	if (*end == '-') {
+		const char *last = end + 1;
+		brk->last = strtoul(last, &end, 16);
+		if (end == last) { return false; }
+	}
+
+	brk->flags = 0;
+
+	if (*end == ':') {
+		for (end++; *end; end++) {
+			if (*end == 'r') { brk->flags |= Debugger::BREAK_READ; }
+			else if (*end == 'w') { brk->flags |= Debugger::BREAK_WRITE; }
+			else if (*end == 'x') { brk->flags |= Debugger::BREAK_EXEC; }
+			else { return false; }
+		}
+	}
+	else if (*end) {
+		return false;
+	}
+
+	if (!brk->flags) { brk->flags = Debugger::BREAK_ALL; }
+
+	return brk->first <= brk->last && brk->last <= 0xffff;
+}
+
+bool nst_debug_run(const debug_conf_t *dconf) {
+	Emulator emu;
+	Machine machine(emu);
+	Debugger debugger(emu);
+	debug_state_t state = { &emu, 0, 0 };
+
+	nst_db_load();
+	if (Cartridge::Database(emulator).IsLoaded()) { Cartridge::Database(emu).Share(emulator); }
+
+	std::ifstream rom(dconf->rom, std::ifstream::in|std::ifstream::binary);
+
+	if (!rom.is_open() || NES_FAILED(machine.Load(rom, nst_default_system()))) {
+		fprintf(stderr, "Debug: could not load %s\n", dconf->rom);
+		return false;
+	}
+
+	Input(emu).ConnectController(0, Input::PAD1);
+	Input(emu).ConnectController(1, Input::PAD2);
+
+	for (int i = 0; i < dconf->numbreaks; i++) {
+		const debug_break_t *brk = &dconf->breaks[i];
+
+		if (NES_FAILED(debugger.SetBreakpoint(brk->first, brk->last, brk->flags))) {
+			fprintf(stderr, "Debug: could not set a breakpoint at $%04X\n", brk->first);
+			return false;
+		}
+	}
+
+	debugger.SetCallback(nst_debug_break, &state);
+
+	machine.SetRamPowerState(0);
+	machine.Power(true);
+
+	Input::Controllers controllers;
+	int frames = dconf->frames > 0 ? dconf->frames : DEBUG_FRAMES;
+
+	for (int i = 0; i < frames && state.events < DEBUG_MAX_EVENTS; i++) {
+		state.frame = emu.Frame();
+		if (NES_FAILED(emu.Execute(NULL, NULL, &controllers))) { break; }
+	}
+
+	if (state.events >= DEBUG_MAX_EVENTS) {
+		fprintf(stderr, "Debug: stopped after %d breaks\n", DEBUG_MAX_EVENTS);
+	}
+
+	return true;
+}
@@ -0,0 +1,24 @@
+#ifndef _DEBUG_H_
+#define _DEBUG_H_
+
+#define DEBUG_FRAMES 600 // Frames to run a ROM for while debugging
+#define DEBUG_MAX_BREAKS 16 // Breakpoints that can be given
+#define DEBUG_MAX_EVENTS 10000 // Breaks printed before the run is stopped
+
+typedef struct {
+	unsigned int first;
+	unsigned int last;
+	unsigned int flags; // Debugger::BREAK_* flags
+} debug_break_t;
+
+typedef struct {
+	const char *rom;
+	int frames; // Frames to run, 0 for DEBUG_FRAMES
+	int numbreaks;
+	debug_break_t breaks[DEBUG_MAX_BREAKS];
+} debug_conf_t;
+
+bool nst_debug_parse(const char *spec, debug_break_t *brk);
+bool nst_debug_run(const debug_conf_t *dconf);
+
+#endif
@@ -0,0 +1,344 @@
+/*
+ * Nestopia UE
+ *
+ * Copyright (C) 2012-2018 R. Danbrook
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ *
+ */
+
+// Environments for training agents: each one is a headless emulator that is
+// stepped a few frames at a time. Nothing is blitted and no sound is made, the
+// observation is built straight from the palette indices the PPU leaves behind.
+// All buffers are set up when an environment is created, so stepping does not
+// allocate.
+
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+#include <stdio.h>
+
+#include <SDL.h>
+
+#include "nstcommon.h"
+#include "config.h"
+#include "env.h"
+
+#include "core/api/NstApiCheats.hpp"
+
+extern Emulator emulator;
+
+struct nst_env_s {
+	Emulator emu;
+	Input::Controllers controllers;
+	std::stringstream start; // State that reset returns to
+	std::vector<unsigned short> pixels;
+	unsigned char luma[512];
+	int obstype;
+	int downsample;
+	std::vector<unsigned short> ram;
+};
+
+enum {
+	VECENV_STEP,
+	VECENV_RESET,
+	VECENV_QUIT
+};
+
+struct nst_vecenv_s {
+	std::vector<env_t*> envs;
+	std::vector<unsigned char> obs;
+	int obssize;
+	std::vector<SDL_Thread*> workers;
+	SDL_sem *start;
+	SDL_sem *done;
+	SDL_atomic_t next;
+	SDL_atomic_t failed;
+	int op;
+	const unsigned int *actions;
+	int frameskip;
+};
+
+static void nst_env_observe(env_t *env, unsigned char *obs) {
+	// Build the observation from the last frame and the observed RAM
+	int d = env->downsample;
+	int width = Video::Output::WIDTH / d;
+	int height = Video::Output::HEIGHT / d;
+
+	Video(env->emu).GetPixels(&env->pixels[0]);
+	const unsigned short *pixels = &env->pixels[0];
+
+	if (env->obstype == ENV_OBS_INDEX) {
+		for (int y = 0; y < height; y++) {
+			const unsigned short *line = pixels + y * d * Video::Output::WIDTH;
+			for (int x = 0; x < width; x++) { *obs++ = line[x * d] & 0x3f; }
+		}
+	}
+	else if (d == 1) {
+		for (int i = 0; i < width * height; i++) { *obs++ = env->luma[pixels[i] & 0x1ff]; }
+	}
+	else {
+		for (int y = 0; y < height; y++) {
+			const unsigned short *line = pixels + y * d * Video::Output::WIDTH;
+			for (int x = 0; x < width; x++) {
+				unsigned int sum = 0;
+				for (int by = 0; by < d; by++) {
+					for (int bx = 0; bx < d; bx++) {
+						sum += env->luma[line[by * Video::Output::WIDTH + x * d + bx] & 0x1ff];
+					}
+				}
+				*obs++ = sum / (d * d);
+			}
+		}
+	}
+
+	Cheats::Ram ram = Cheats(env->emu).GetRam();
+
+	for (size_t i = 0; i < env->ram.size(); i++) { *obs++ = ram[env->ram[i]]; }
+}
+
+env_t* nst_env_create(const env_conf_t *econf) {
+	// Load the game and remember the state to reset to
+	if (econf->downsample != 1 && econf->downsample != 2 && econf->downsample != 4) {
+		fprintf(stderr, "Env: downsample must be 1, 2 or 4\n");
+		return NULL;
+	}
+
+	if (econf->ramcount < 0 || econf->ramcount > ENV_MAX_RAM) {
+		fprintf(stderr, "Env: at most %d RAM bytes can be observed\n", ENV_MAX_RAM);
+		return NULL;
+	}
+
+	env_t *env = new env_t;
+	env->obstype = econf->obstype;
+	env->downsample = econf->downsample;
+	env->pixels.resize(Video::Output::WIDTH * Video::Output::HEIGHT);
+
+	for (int i = 0; i < econf->ramcount; i++) {
+		env->ram.push_back(econf->ram[i] & (Cheats::RAM_SIZE - 1));
+	}
+
+	Machine machine(env->emu);
+
+	if (Cartridge::Database(emulator).IsLoaded()) { Cartridge::Database(env->emu).Share(emulator); }
+
+	std::ifstream rom(econf->rom, std::ifstream::in|std::ifstream::binary);
+
+	if (!rom.is_open() || NES_FAILED(machine.Load(rom, nst_default_system()))) {
+		fprintf(stderr, "Env: could not load %s\n", econf->rom);
+		delete env;
+		return NULL;
+	}
+
+	Input input(env->emu);
+	input.ConnectController(0, Input::PAD1);
+	input.ConnectController(1, Input::PAD2);
+
+	machine.SetRamPowerState(0);
+	machine.Power(true);
+
+	if (econf->snapshot) {
+		std::ifstream state(econf->snapshot, std::ifstream::in|std::ifstream::binary);
+
+		if (!state.is_open() || NES_FAILED(machine.LoadState(state))) {
+			fprintf(stderr, "Env: could not load the state %s\n", econf->snapshot);
+			delete env;
+			return NULL;
+		}
+	}
+
+	if (NES_FAILED(machine.SaveState(env->start, Machine::NO_COMPRESSION))) {
+		delete env;
+		return NULL;
+	}
+
+	// Gray levels for every palette index and emphasis
+	Video::Palette::Colors colors = Video(env->emu).GetPalette().GetColors();
+
+	for (int i = 0; i < 512; i++) {
+		env->luma[i] = (colors[i][0] * 77 + colors[i][1] * 150 + colors[i][2] * 29) >> 8;
+	}
+
+	return env;
+}
+
+void nst_env_destroy(env_t *env) {
+	delete env;
+}
+
+int nst_env_obs_width(const env_t *env) {
+	return Video::Output::WIDTH / env->downsample;
+}
+
+int nst_env_obs_height(const env_t *env) {
+	return Video::Output::HEIGHT / env->downsample;
+}
+
+int nst_env_obs_size(const env_t *env) {
+	return nst_env_obs_width(env) * nst_env_obs_height(env) + env->ram.size();
+}
+
+bool nst_env_reset(env_t *env, unsigned char *obs) {
+	// Go back to the starting state
+	env->start.clear();
+	env->start.seekg(0);
+
+	if (NES_FAILED(Machine(env->emu).LoadState(env->start))) { return false; }
+
+	env->controllers.pad[0].buttons = 0;
+	env->controllers.pad[1].buttons = 0;
+
+	if (obs) { nst_env_observe(env, obs); }
+	return true;
+}
+
+bool nst_env_step(env_t *env, unsigned int actions, int frameskip, unsigned char *obs) {
+	// Hold the buttons down for a number of frames and observe the last one
+	env->controllers.pad[0].buttons = actions & 0xff;
+	env->controllers.pad[1].buttons = (actions >> 8) & 0xff;
+
+	for (int i = 0; i < (frameskip > 0 ? frameskip : 1); i++) {
+		if (NES_FAILED(env->emu.Execute(NULL, NULL, &env->controllers))) { return false; }
+	}
+
+	if (obs) { nst_env_observe(env, obs); }
+	return true;
+}
+
+static void nst_vecenv_work(vecenv_t *vec) {
+	// Take environments off the vector until none are left
+	int count = vec->envs.size();
+
+	while (1) {
+		int i = SDL_AtomicAdd(&vec->next, 1);
+		if (i >= count) { break; }
+
+		unsigned char *obs = &vec->obs[i * vec->obssize];
+		bool ok = vec->op == VECENV_RESET ?
+			nst_env_reset(vec->envs[i], obs) :
+			nst_env_step(vec->envs[i], vec->actions[i], vec->frameskip, obs);
+
+		if (!ok) { SDL_AtomicSet(&vec->failed, 1); }
+	}
+}
+
+static int nst_vecenv_worker(void *data) {
+	// Worker thread, sleeps until there is a step to help with
+	vecenv_t *vec = (vecenv_t*)data;
+
+	while (1) {
+		SDL_SemWait(vec->start);
+		if (vec->op == VECENV_QUIT) { break; }
+		nst_vecenv_work(vec);
+		SDL_SemPost(vec->done);
+	}
+
+	return 0;
+}
+
+static bool nst_vecenv_run(vecenv_t *vec, int op) {
+	// Run an operation on every environment, this thread helps out
+	vec->op = op;
+	SDL_AtomicSet(&vec->next, 0);
+	SDL_AtomicSet(&vec->failed, 0);
+
+	for (size_t i = 0; i < vec->workers.size(); i++) { SDL_SemPost(vec->start); }
+	if (op == VECENV_QUIT) { return true; }
+
+	nst_vecenv_work(vec);
+
+	for (size_t i = 0; i < vec->workers.size(); i++) { SDL_SemWait(vec->done); }
+
+	return !SDL_AtomicGet(&vec->failed);
+}
+
+vecenv_t* nst_vecenv_create(const env_conf_t *econf, int count, int jobs) {
+	// Create the environments, the observation buffer and the threads
+	if (count < 1) { return NULL; }
+
+	vecenv_t *vec = new vecenv_t;
+	vec->start = SDL_CreateSemaphore(0);
+	vec->done = SDL_CreateSemaphore(0);
+
+	for (int i = 0; i < count; i++) {
+		env_t *env = nst_env_create(econf);
+
+		if (!env) {
+			nst_vecenv_destroy(vec);
+			return NULL;
+		}
+
+		vec->envs.push_back(env);
+	}
+
+	vec->obssize = nst_env_obs_size(vec->envs[0]);
+	vec->obs.resize(count * vec->obssize);
+
+	if (jobs <= 0) { jobs = SDL_GetCPUCount(); }
+	if (jobs > count) { jobs = count; }
+
+	// The calling thread does its share of the work too
+	for (int i = 1; i < jobs; i++) {
+		char name[32];
+		snprintf(name, sizeof(name), "env%d", i);
+		SDL_Thread *worker = SDL_CreateThread(nst_vecenv_worker, name, vec);
+		if (!worker) { break; }
+		vec->workers.push_back(worker);
+	}
+
+	if (!nst_vecenv_reset(vec, -1)) {
+		nst_vecenv_destroy(vec);
+		return NULL;
+	}
+
+	return vec;
+}
+
+void nst_vecenv_destroy(vecenv_t *vec) {
+	nst_vecenv_run(vec, VECENV_QUIT);
+
+	for (size_t i = 0; i < vec->workers.size(); i++) { SDL_WaitThread(vec->workers[i], NULL); }
+	for (size_t i = 0; i < vec->envs.size(); i++) { nst_env_destroy(vec->envs[i]); }
+
+	SDL_DestroySemaphore(vec->start);
+	SDL_DestroySemaphore(vec->done);
+	delete vec;
+}
+
+unsigned char* nst_vecenv_obs(vecenv_t *vec) {
+	return &vec->obs[0];
+}
+
+int nst_vecenv_count(const vecenv_t *vec) {
+	return vec->envs.size();
+}
+
+bool nst_vecenv_reset(vecenv_t *vec, int index) {
+	if (index >= 0) {
+		if (index >= (int)vec->envs.size()) { return false; }
+		return nst_env_reset(vec->envs[index], &vec->obs[index * vec->obssize]);
+	}
+
+	return nst_vecenv_run(vec, VECENV_RESET);
+}
+
+bool nst_vecenv_step(vecenv_t *vec, const unsigned int *actions, int frameskip) {
+	// Step every environment with its own buttons
+	vec->actions = actions;
+	vec->frameskip = frameskip;
+	return nst_vecenv_run(vec, VECENV_STEP);
+}
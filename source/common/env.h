@@ -0,0 +1,44 @@
+#ifndef _ENV_H_
+#define _ENV_H_
+
+#define ENV_OBS_GRAY 0 // Luma of the current palette, averaged over each block
+#define ENV_OBS_INDEX 1 // Palette index without emphasis, top left of each block
+
+#define ENV_MAX_RAM 256 // RAM bytes that can be observed
+
+// An observation is the picture of the last frame, downsampled by 1, 2 or 4
+// in both directions with one byte per pixel, followed by the observed RAM
+// bytes. Actions are the pad 1 buttons in the low byte and the pad 2 buttons
+// in the next, using the bits of Input::Controllers::Pad.
+
+typedef struct {
+	const char *rom;
+	const char *snapshot; // State to reset to, NULL to reset to power on
+	int obstype; // ENV_OBS_*
+	int downsample;
+	const unsigned short *ram; // CPU RAM addresses to observe
+	int ramcount;
+} env_conf_t;
+
+typedef struct nst_env_s env_t;
+typedef struct nst_vecenv_s vecenv_t;
+
+env_t* nst_env_create(const env_conf_t *econf);
+void nst_env_destroy(env_t *env);
+int nst_env_obs_width(const env_t *env);
+int nst_env_obs_height(const env_t *env);
+int nst_env_obs_size(const env_t *env);
+bool nst_env_reset(env_t *env, unsigned char *obs);
+bool nst_env_step(env_t *env, unsigned int actions, int frameskip, unsigned char *obs);
+
+// A vector of environments stepped together on a pool of threads. The
+// observations of all of them are written to one buffer, one after the other.
+
+vecenv_t* nst_vecenv_create(const env_conf_t *econf, int count, int jobs);
+void nst_vecenv_destroy(vecenv_t *vec);
+unsigned char* nst_vecenv_obs(vecenv_t *vec);
+int nst_vecenv_count(const vecenv_t *vec);
+bool nst_vecenv_reset(vecenv_t *vec, int index); // -1 for all of them
+bool nst_vecenv_step(vecenv_t *vec, const unsigned int *actions, int frameskip);
+
+#endif
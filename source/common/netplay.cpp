@@ -0,0 +1,529 @@
+/*
+ * Nestopia UE
+ *
+ * Copyright (C) 2012-2018 R. Danbrook
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ *
+ */
+
+// Rollback netplay: every frame runs at once on a prediction of the remote
+// input (the last one received). When the real input arrives and differs,
+// the state from before the first wrong frame is restored and the frames
+// up to the present are run again, all within one host frame.
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "netplay.h"
+
+#define NETPLAY_MASK (NETPLAY_RING - 1)
+#define NETPLAY_HEADER 19
+
+extern Emulator emulator;
+
+static netplay_t *session = NULL;
+static int netplay_player = 0;
+static int netplay_port = 0;
+static char netplay_peer[256];
+
+static void nst_netplay_put32(unsigned char *buf, int value) {
+	buf[0] = value & 0xff;
+	buf[1] = (value >> 8) & 0xff;
+	buf[2] = (value >> 16) & 0xff;
+	buf[3] = (value >> 24) & 0xff;
+}
+
+static int nst_netplay_get32(const unsigned char *buf) {
+	return (int)(buf[0] | (buf[1] << 8) | (buf[2] << 16) | ((unsigned)buf[3] << 24));
+}
+
+static bool nst_netplay_link_open(netplay_link_t *link, int port, const char *host, int peerport) {
+	// Open a non-blocking UDP socket and resolve the peer
+	memset(link, 0, sizeof(netplay_link_t));
+
+	link->fd = socket(AF_INET, SOCK_DGRAM, 0);
+	if (link->fd < 0) { return false; }
+
+	struct sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_ANY);
+	addr.sin_port = htons(port);
+
+	if (bind(link->fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+		fprintf(stderr, "Netplay: could not bind port %d\n", port);
+		close(link->fd);
+		return false;
+	}
+
+	fcntl(link->fd, F_SETFL, fcntl(link->fd, F_GETFL, 0) | O_NONBLOCK);
+
+	if (host) {
+		struct addrinfo hints, *res;
+		memset(&hints, 0, sizeof(hints));
+		hints.ai_family = AF_INET;
+		hints.ai_socktype = SOCK_DGRAM;
+
+		if (getaddrinfo(host, NULL, &hints, &res) != 0) {
+			fprintf(stderr, "Netplay: could not resolve %s\n", host);
+			close(link->fd);
+			return false;
+		}
+
+		memcpy(&link->peer, res->ai_addr, sizeof(link->peer));
+		link->peer.sin_port = htons(peerport);
+		freeaddrinfo(res);
+	}
+
+	return true;
+}
+
+static void nst_netplay_link_flush(netplay_link_t *link) {
+	// Send out the held back packets that are due
+	int kept = 0;
+
+	for (int i = 0; i < link->numdelayed; i++) {
+		if (link->delayed[i].tick <= link->tick) {
+			sendto(link->fd, link->delayed[i].data, link->delayed[i].length, 0,
+				(struct sockaddr*)&link->peer, sizeof(link->peer));
+		}
+		else { link->delayed[kept++] = link->delayed[i]; }
+	}
+
+	link->numdelayed = kept;
+}
+
+static void nst_netplay_link_send(netplay_link_t *link, const unsigned char *data, int length) {
+	// Send a packet, through the simulated latency and loss if set
+	if (link->loss && (int)(rand_r(&link->seed) % 100) < link->loss) { return; }
+
+	if (!link->latency) {
+		sendto(link->fd, data, length, 0, (struct sockaddr*)&link->peer, sizeof(link->peer));
+		return;
+	}
+
+	if (link->numdelayed == NETPLAY_DELAY_MAX) { return; }
+
+	link->delayed[link->numdelayed].tick = link->tick + link->latency;
+	link->delayed[link->numdelayed].length = length;
+	memcpy(link->delayed[link->numdelayed].data, data, length);
+	link->numdelayed++;
+}
+
+static int nst_netplay_link_recv(netplay_link_t *link, unsigned char *data, int length) {
+	// Receive a packet from the peer, anyone else is ignored
+	struct sockaddr_in from;
+	socklen_t fromlen;
+
+	while (true) {
+		fromlen = sizeof(from);
+		int received = recvfrom(link->fd, data, length, 0, (struct sockaddr*)&from, &fromlen);
+
+		if (received < 0) { return -1; }
+
+		if (from.sin_addr.s_addr == link->peer.sin_addr.s_addr && from.sin_port == link->peer.sin_port) {
+			return received;
+		}
+	}
+}
+
+static unsigned int nst_netplay_save(Emulator *emu, std::stringstream *state) {
+	// Save the state into a reused buffer, hash the machine without
+	// going through the serialized copy
+	state->clear();
+	state->seekp(0);
+	Machine(*emu).SaveState(*state, Machine::NO_COMPRESSION);
+
+	Machine::StateHash hash;
+	Machine(*emu).GetStateHash(hash);
+	return hash.hi ^ hash.lo;
+}
+
+static void nst_netplay_execute(netplay_t *np, int frame, Video::Output *video, Sound::Output *sound, Input::Controllers *pads) {
+	// Run one frame with the inputs recorded for it
+	int slot = frame & NETPLAY_MASK;
+	np->hash[slot] = nst_netplay_save(np->emulator, np->state[slot]);
+
+	Input::Controllers controllers;
+	if (pads) { controllers = *pads; }
+	controllers.pad[0].buttons = np->input[0][slot];
+	controllers.pad[1].buttons = np->input[1][slot];
+
+	np->emulator->Execute(video, sound, &controllers);
+}
+
+static void nst_netplay_rollback(netplay_t *np, int frame, Input::Controllers *pads) {
+	// Restore the state before a mispredicted frame and catch up silently
+	std::stringstream *state = np->state[frame & NETPLAY_MASK];
+	state->clear();
+	state->seekg(0);
+	Machine(*np->emulator).LoadState(*state);
+
+	for (int f = frame; f < np->frame; f++) {
+		nst_netplay_execute(np, f, NULL, NULL, pads);
+		np->resimulated++;
+	}
+
+	np->rollbacks++;
+}
+
+static int nst_netplay_receive(netplay_t *np) {
+	// Take in remote inputs, return the first frame that was mispredicted
+	unsigned char buf[NETPLAY_PACKET_MAX];
+	int remote = !np->local;
+	int rollback = np->frame;
+	int length;
+
+	while ((length = nst_netplay_link_recv(&np->link, buf, sizeof(buf))) >= 0) {
+		if (length < NETPLAY_HEADER || buf[0] != 'N' || buf[1] != 'P') { continue; }
+		if (length < NETPLAY_HEADER + buf[18]) { continue; }
+
+		int ack = nst_netplay_get32(buf + 2);
+		if (ack > np->remoteack) { np->remoteack = ack; }
+
+		np->peersync = nst_netplay_get32(buf + 6);
+		np->peerhash = (unsigned int)nst_netplay_get32(buf + 10);
+
+		int start = nst_netplay_get32(buf + 14);
+
+		for (int i = 0; i < buf[18]; i++) {
+			int f = start + i;
+
+			// Inputs are taken in order, anything further out would overwrite live slots
+			if (f != np->remoteframe + 1) { continue; }
+			if (f >= np->frame + NETPLAY_RING - NETPLAY_MAX_AHEAD - 1) { break; }
+
+			int slot = f & NETPLAY_MASK;
+			if (f < np->frame && np->input[remote][slot] != buf[NETPLAY_HEADER + i] && f < rollback) { rollback = f; }
+
+			np->input[remote][slot] = buf[NETPLAY_HEADER + i];
+			np->remoteframe = f;
+		}
+	}
+
+	// Frames still unconfirmed are predicted from the latest input
+	unsigned char predicted = np->remoteframe < 0 ? 0 : np->input[remote][np->remoteframe & NETPLAY_MASK];
+
+	for (int f = np->remoteframe + 1; f < np->frame; f++) {
+		int slot = f & NETPLAY_MASK;
+		if (np->input[remote][slot] != predicted) {
+			if (f < rollback) { rollback = f; }
+			np->input[remote][slot] = predicted;
+		}
+	}
+
+	return rollback;
+}
+
+static void nst_netplay_check(netplay_t *np) {
+	// Compare the peer's hash of a confirmed state with our own
+	int f = np->peersync;
+
+	if (f <= np->checked || f > nst_netplay_confirmed(np) || np->frame - f >= NETPLAY_RING) { return; }
+
+	if (np->hash[f & NETPLAY_MASK] != np->peerhash) {
+		if (!np->desyncs) { fprintf(stderr, "Netplay: desync detected at frame %d\n", f); }
+		np->desyncs++;
+	}
+
+	np->checked = f;
+}
+
+static void nst_netplay_send(netplay_t *np) {
+	// Send every local input the peer has not confirmed yet
+	unsigned char buf[NETPLAY_PACKET_MAX];
+	int start = np->remoteack + 1;
+
+	if (start < np->frame - NETPLAY_RING) { start = np->frame - NETPLAY_RING; }
+	if (start > np->frame) { start = np->frame; }
+
+	int count = np->frame - start;
+	int sync = nst_netplay_confirmed(np);
+
+	buf[0] = 'N';
+	buf[1] = 'P';
+	nst_netplay_put32(buf + 2, np->remoteframe);
+	nst_netplay_put32(buf + 6, sync);
+	nst_netplay_put32(buf + 10, sync < 0 ? 0 : (int)np->hash[sync & NETPLAY_MASK]);
+	nst_netplay_put32(buf + 14, start);
+	buf[18] = count;
+
+	for (int i = 0; i < count; i++) {
+		buf[NETPLAY_HEADER + i] = np->input[np->local][(start + i) & NETPLAY_MASK];
+	}
+
+	nst_netplay_link_send(&np->link, buf, NETPLAY_HEADER + count);
+}
+
+netplay_t* nst_netplay_open(Emulator *emu, int local, int port, const char *host, int peerport) {
+	// Open a session on an emulator with a game loaded and powered on
+	netplay_t *np = new netplay_t;
+
+	if (!nst_netplay_link_open(&np->link, port, host, peerport)) {
+		delete np;
+		return NULL;
+	}
+
+	np->emulator = emu;
+	np->local = local ? 1 : 0;
+	np->frame = 0;
+	np->remoteframe = -1;
+	np->remoteack = -1;
+	np->peersync = -1;
+	np->peerhash = 0;
+	np->checked = -1;
+	np->rollbacks = np->resimulated = np->stalls = np->desyncs = 0;
+	memset(np->input, 0, sizeof(np->input));
+	memset(np->hash, 0, sizeof(np->hash));
+
+	for (int i = 0; i < NETPLAY_RING; i++) {
+		np->state[i] = new std::stringstream(std::ios::in|std::ios::out|std::ios::binary);
+	}
+
+	return np;
+}
+
+void nst_netplay_close(netplay_t *np) {
+	// Close a session
+	if (!np) { return; }
+
+	close(np->link.fd);
+
+	for (int i = 0; i < NETPLAY_RING; i++) {
+		delete np->state[i];
+	}
+
+	delete np;
+}
+
+bool nst_netplay_frame(netplay_t *np, unsigned int buttons, Video::Output *video, Sound::Output *sound, Input::Controllers *pads) {
+	// Advance a session by one host frame, false if it had to wait for the peer
+	bool advanced = false;
+
+	np->link.tick++;
+	nst_netplay_link_flush(&np->link);
+
+	int rollback = nst_netplay_receive(np);
+	if (rollback < np->frame) { nst_netplay_rollback(np, rollback, pads); }
+
+	nst_netplay_check(np);
+
+	if (np->frame - np->remoteframe - 1 < NETPLAY_MAX_AHEAD) {
+		int slot = np->frame & NETPLAY_MASK;
+		int remote = !np->local;
+
+		np->input[np->local][slot] = buttons;
+
+		if (np->frame > np->remoteframe) {
+			np->input[remote][slot] = np->remoteframe < 0 ? 0 : np->input[remote][np->remoteframe & NETPLAY_MASK];
+		}
+
+		nst_netplay_execute(np, np->frame, video, sound, pads);
+		np->frame++;
+		advanced = true;
+	}
+	else { np->stalls++; }
+
+	nst_netplay_send(np);
+
+	return advanced;
+}
+
+int nst_netplay_confirmed(netplay_t *np) {
+	// Last frame whose starting state depends only on confirmed inputs
+	int confirmed = np->remoteframe + 1;
+	if (confirmed > np->frame - 1) { confirmed = np->frame - 1; }
+	return confirmed;
+}
+
+void nst_netplay_configure(int player, int port, const char *peer) {
+	// Set up the session to start when a game is loaded
+	if (player) { netplay_player = player; }
+	if (port) { netplay_port = port; }
+	if (peer) { snprintf(netplay_peer, sizeof(netplay_peer), "%s", peer); }
+}
+
+bool nst_netplay_start() {
+	// Start a session on the main emulator if one was configured
+	if (session || !netplay_player || !netplay_peer[0]) { return false; }
+
+	char host[256];
+	snprintf(host, sizeof(host), "%s", netplay_peer);
+
+	char *colon = strrchr(host, ':');
+	if (!colon) {
+		fprintf(stderr, "Netplay: peer must be given as host:port\n");
+		return false;
+	}
+
+	*colon = '\0';
+	int peerport = atoi(colon + 1);
+
+	// Both sides start from a hard reset
+	Machine(emulator).Reset(true);
+
+	session = nst_netplay_open(&emulator, netplay_player - 1, netplay_port, host, peerport);
+
+	if (session) {
+		fprintf(stderr, "Netplay: player %d on port %d, peer %s:%d\n", netplay_player, netplay_port, host, peerport);
+	}
+
+	return session != NULL;
+}
+
+void nst_netplay_stop() {
+	// End the session on the main emulator
+	if (!session) { return; }
+
+	fprintf(stderr, "Netplay: %u rollbacks, %u frames resimulated, %u stalls, %u desyncs\n",
+		session->rollbacks, session->resimulated, session->stalls, session->desyncs);
+
+	nst_netplay_close(session);
+	session = NULL;
+}
+
+bool nst_netplay_active() {
+	return session != NULL;
+}
+
+void nst_netplay_run(Video::Output *video, Sound::Output *sound, Input::Controllers *pads) {
+	// Run a host frame, the local player always plays on the first pad
+	nst_netplay_frame(session, pads->pad[0].buttons, video, sound, pads);
+}
+
+static bool nst_netplay_test_load(Emulator *emu, const std::string& rom) {
+	// Load and power on a harness instance
+	Machine machine(*emu);
+	std::istringstream file(rom);
+
+	if (NES_FAILED(machine.Load(file, Machine::FAVORED_NES_NTSC))) { return false; }
+
+	machine.SetRamPowerState(0);
+	return NES_SUCCEEDED(machine.Power(true));
+}
+
+bool nst_netplay_test(const char *filename, int frames, int latency, int loss) {
+	// Run two sessions against each other over loopback and check that every
+	// confirmed state matches a plain run with the same inputs
+	std::ifstream file(filename, std::ios::in|std::ios::binary);
+	std::string rom((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+	Emulator emu[3];
+	netplay_t *np[2];
+	std::vector<unsigned int> hashes[2];
+	std::vector<unsigned char> inputs[2];
+	unsigned int seed[2] = { 1, 2 };
+	unsigned int buttons[2] = { 0, 0 };
+
+	for (int i = 0; i < 3; i++) {
+		if (!nst_netplay_test_load(&emu[i], rom)) {
+			fprintf(stderr, "Netplay test: could not load %s\n", filename);
+			return false;
+		}
+	}
+
+	for (int i = 0; i < 2; i++) {
+		np[i] = nst_netplay_open(&emu[i], i, 0, NULL, 0);
+		if (!np[i]) {
+			if (i) { nst_netplay_close(np[0]); }
+			return false;
+		}
+	}
+
+	// Point the sessions at each other on loopback
+	for (int i = 0; i < 2; i++) {
+		struct sockaddr_in addr;
+		socklen_t addrlen = sizeof(addr);
+		getsockname(np[!i]->link.fd, (struct sockaddr*)&addr, &addrlen);
+
+		np[i]->link.peer = addr;
+		np[i]->link.peer.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		np[i]->link.latency = latency;
+		np[i]->link.loss = loss;
+		np[i]->link.seed = 100 + i;
+	}
+
+	for (int tick = 0; tick < frames * 4 + 1000; tick++) {
+		if (nst_netplay_confirmed(np[0]) >= frames && nst_netplay_confirmed(np[1]) >= frames) { break; }
+
+		for (int i = 0; i < 2; i++) {
+			// Hold buttons for a while like a player would
+			if ((rand_r(&seed[i]) & 7) == 0) { buttons[i] = rand_r(&seed[i]) & 0xff; }
+
+			nst_netplay_frame(np[i], buttons[i], NULL, NULL, NULL);
+
+			while ((int)hashes[i].size() <= nst_netplay_confirmed(np[i])) {
+				hashes[i].push_back(np[i]->hash[hashes[i].size() & NETPLAY_MASK]);
+			}
+		}
+
+		while ((int)inputs[0].size() <= np[0]->remoteframe) {
+			int slot = inputs[0].size() & NETPLAY_MASK;
+			inputs[0].push_back(np[0]->input[0][slot]);
+			inputs[1].push_back(np[0]->input[1][slot]);
+		}
+	}
+
+	for (int i = 0; i < 2; i++) {
+		fprintf(stderr, "Netplay test: player %d ran %d frames, %u rollbacks, %u frames resimulated, %u stalls\n",
+			i + 1, np[i]->frame, np[i]->rollbacks, np[i]->resimulated, np[i]->stalls);
+	}
+
+	nst_netplay_close(np[0]);
+	nst_netplay_close(np[1]);
+
+	if ((int)hashes[0].size() <= frames || (int)hashes[1].size() <= frames || (int)inputs[0].size() < frames) {
+		fprintf(stderr, "Netplay test: sessions did not confirm %d frames\n", frames);
+		return false;
+	}
+
+	// Replay the confirmed inputs without netplay as the reference
+	std::stringstream state(std::ios::in|std::ios::out|std::ios::binary);
+	Input::Controllers controllers;
+	int mismatches = 0;
+
+	for (int f = 0; f <= frames; f++) {
+		unsigned int hash = nst_netplay_save(&emu[2], &state);
+
+		if (hashes[0][f] != hash || hashes[1][f] != hash) {
+			if (!mismatches) { fprintf(stderr, "Netplay test: frame %d differs\n", f); }
+			mismatches++;
+		}
+
+		if (f == frames) { break; }
+
+		controllers.pad[0].buttons = inputs[0][f];
+		controllers.pad[1].buttons = inputs[1][f];
+		emu[2].Execute(NULL, NULL, &controllers);
+	}
+
+	fprintf(stderr, "Netplay test: %d of %d frames match, latency %d, loss %d%%: %s\n",
+		frames + 1 - mismatches, frames + 1, latency, loss, mismatches ? "FAILED" : "OK");
+
+	return mismatches == 0;
+}
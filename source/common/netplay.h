@@ -0,0 +1,73 @@
+#ifndef _NETPLAY_H_
+#define _NETPLAY_H_
+
+#include <sstream>
+
+#include <netinet/in.h>
+
+#include "nstcommon.h"
+#include "core/api/NstApiInput.hpp"
+
+#define NETPLAY_RING 32 // Frames of inputs and states kept, power of two
+#define NETPLAY_MAX_AHEAD 12 // Frames run on predicted input before stalling
+#define NETPLAY_PACKET_MAX 64
+#define NETPLAY_DELAY_MAX 64
+
+// Both sides must start from the same ROM, settings and save data, netplay
+// only exchanges inputs. Only standard pads on ports 1 and 2 are supported.
+
+typedef struct {
+	int fd;
+	struct sockaddr_in peer;
+
+	// Link simulation for the loopback harness
+	int latency; // Frames a packet is held before it is sent
+	int loss; // Percentage of packets dropped
+	unsigned int seed;
+	int tick;
+	int numdelayed;
+	struct {
+		int tick;
+		int length;
+		unsigned char data[NETPLAY_PACKET_MAX];
+	} delayed[NETPLAY_DELAY_MAX];
+} netplay_link_t;
+
+typedef struct {
+	Emulator *emulator;
+	netplay_link_t link;
+	int local; // Local player, 0 or 1
+	int frame; // Next frame to be run
+	int remoteframe; // Last frame with a confirmed remote input
+	int remoteack; // Last local input the peer has confirmed
+	int peersync; // Last confirmed frame the peer reported a hash for
+	unsigned int peerhash;
+	int checked; // Last frame compared against the peer
+	unsigned char input[2][NETPLAY_RING]; // Inputs each frame was run with
+	std::stringstream *state[NETPLAY_RING]; // State at the start of each frame
+	unsigned int hash[NETPLAY_RING];
+
+	// Statistics
+	unsigned int rollbacks;
+	unsigned int resimulated;
+	unsigned int stalls;
+	unsigned int desyncs;
+} netplay_t;
+
+// Sessions, usable on any emulator instance
+netplay_t* nst_netplay_open(Emulator *emu, int local, int port, const char *host, int peerport);
+void nst_netplay_close(netplay_t *np);
+bool nst_netplay_frame(netplay_t *np, unsigned int buttons, Video::Output *video, Sound::Output *sound, Input::Controllers *pads);
+int nst_netplay_confirmed(netplay_t *np);
+
+// Frontend session on the main emulator
+void nst_netplay_configure(int player, int port, const char *peer);
+bool nst_netplay_start();
+void nst_netplay_stop();
+bool nst_netplay_active();
+void nst_netplay_run(Video::Output *video, Sound::Output *sound, Input::Controllers *pads);
+
+// Loopback test harness
+bool nst_netplay_test(const char *filename, int frames, int latency, int loss);
+
+#endif
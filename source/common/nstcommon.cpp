@@ -32,6 +32,7 @@
 #include <libgen.h>
 
 #include <errno.h>
+#include <time.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 
@@ -47,6 +48,13 @@
 #include "audio.h"
 #include "video.h"
 #include "samples.h"
+#include "savestate.h"
+#include "capture.h"
+#include "nvr.h"
+#include "wavrec.h"
+#include "shmout.h"
+#include "netplay.h"
+#include "pacer.h"
 
 Emulator emulator;
 Video::Output *cNstVideo;
@@ -58,6 +66,10 @@ nstpaths_t nstpaths;
 static bool ffspeed = false;
 static bool playing = false;
 
+// Fast-forward speed measurement
+static double ffstart;
+static int ffframes;
+
 static std::ifstream *nstdb;
 
 static std::ifstream *fdsbios;
@@ -71,6 +83,7 @@ static size_t custpalsize;
 static int loaded = 0;
 
 bool (*nst_archive_select)(const char*, char*, size_t);
+void (*nst_input_poll)() = NULL;
 
 static bool NST_CALLBACK nst_cb_videolock(void* userData, Video::Output& video) {
 	video.pitch = video_lock_screen(video.pixels);
@@ -79,6 +92,17 @@ static bool NST_CALLBACK nst_cb_videolock(void* userData, Video::Output& video)
 
 static void NST_CALLBACK nst_cb_videounlock(void* userData, Video::Output& video) {
 	video_unlock_screen(video.pixels);
+	nst_nvr_video();
+}
+
+static bool NST_CALLBACK nst_cb_pad(void* userData, Input::Controllers::Pad& pad, unsigned int port) {
+	// The game is reading this pad for the first time this frame, which is
+	// the latest moment the host input can be sampled. Netplay inputs are
+	// settled before the frame starts, and other emulators have pads of their own.
+	if (conf.timing_latepoll && nst_input_poll && cNstPads && &pad == &cNstPads->pad[port] && !nst_netplay_active()) {
+		nst_input_poll();
+	}
+	return true;
 }
 
 static bool NST_CALLBACK nst_cb_soundlock(void* userData, Sound::Output& sound) {
@@ -86,7 +110,9 @@ static bool NST_CALLBACK nst_cb_soundlock(void* userData, Sound::Output& sound)
 }
 
 static void NST_CALLBACK nst_cb_soundunlock(void* userData, Sound::Output& sound) {
-	// Do Nothing
+	nst_nvr_audio((const int16_t*)sound.samples[0], sound.length[0]);
+	nst_wavrec_audio((const int16_t*)sound.samples[0], sound.length[0]);
+	nst_shmout_audio((const int16_t*)sound.samples[0], sound.length[0]);
 }
 
 static void NST_CALLBACK nst_cb_event(void *userData, User::Event event, const void* data) {
@@ -199,7 +225,7 @@ static void NST_CALLBACK nst_cb_file(void *userData, User::File& file) {
 	}
 }
 
-static Machine::FavoredSystem nst_default_system() {
+Machine::FavoredSystem nst_default_system() {
 	switch (conf.misc_default_system) {
 		case 2: return Machine::FAVORED_NES_PAL; break;
 		case 3: return Machine::FAVORED_FAMICOM; break;
@@ -458,7 +484,7 @@ void nst_movie_save(char *filename) {
 	movierecfile = new std::fstream(filename, std::ifstream::out|std::ifstream::binary); 
 
 	if (movierecfile->is_open()) {
-		movie.Record((std::iostream&)*movierecfile, Nes::Api::Movie::CLEAN);
+		movie.Record((std::iostream&)*movierecfile, Nes::Api::Movie::CLEAN, conf.misc_movie_hash, conf.misc_movie_keyframes);
 	}
 	else {
 		delete movierecfile;
@@ -474,6 +500,17 @@ void nst_movie_load(char *filename) {
 
 	if (moviefile->is_open()) {
 		movie.Play(*moviefile);
+		
+		// Pick up a sidecar index for seeking if there is one
+		char idxpath[512];
+		snprintf(idxpath, sizeof(idxpath), "%s.idx", filename);
+		std::ifstream idxfile(idxpath, std::ifstream::in|std::ifstream::binary);
+		
+		if (idxfile.is_open() && movie.IsPlaying()) {
+			if (NES_FAILED(movie.LoadIndex(idxfile))) {
+				fprintf(stderr, "Movie: could not load index %s\n", idxpath);
+			}
+		}
 	}
 	else {
 		delete moviefile;
@@ -481,6 +518,40 @@ void nst_movie_load(char *filename) {
 	}
 }
 
+bool nst_movie_index(const char *filename, const char *romfile) {
+	// Play a movie through offline and write a sidecar index for seeking
+	Emulator emu;
+	Machine machine(emu);
+	Movie movie(emu);
+	
+	std::ifstream rom(romfile, std::ifstream::in|std::ifstream::binary);
+	if (!rom.is_open() || NES_FAILED(machine.Load(rom, nst_default_system()))) {
+		fprintf(stderr, "Movie index: could not load %s\n", romfile);
+		return false;
+	}
+	
+	machine.SetRamPowerState(conf.misc_power_state);
+	machine.Power(true);
+	
+	std::ifstream moviein(filename, std::ifstream::in|std::ifstream::binary);
+	if (!moviein.is_open() || NES_FAILED(movie.Play(moviein))) {
+		fprintf(stderr, "Movie index: could not play %s\n", filename);
+		return false;
+	}
+	
+	char idxpath[512];
+	snprintf(idxpath, sizeof(idxpath), "%s.idx", filename);
+	std::ofstream idxfile(idxpath, std::ofstream::out|std::ofstream::binary);
+	
+	if (!idxfile.is_open() || NES_FAILED(movie.SaveIndex(idxfile, MOVIE_INDEX_INTERVAL))) {
+		fprintf(stderr, "Movie index: could not write %s\n", idxpath);
+		return false;
+	}
+	
+	fprintf(stderr, "Movie index: wrote %s\n", idxpath);
+	return true;
+}
+
 void nst_movie_stop() {
 	// Stop any movie that is playing or recording
 	Movie movie(emulator);
@@ -629,6 +700,8 @@ void nst_set_callbacks() {
 	User::fileIoCallback.Set(nst_cb_file, userData);
 	User::logCallback.Set(nst_cb_log, userData);
 	User::eventCallback.Set(nst_cb_event, userData);
+	
+	Input::Controllers::Pad::callback.Set(nst_cb_pad, userData);
 }
 
 void nst_set_dirs() {
@@ -741,20 +814,17 @@ void nst_set_rewind(int direction) {
 }
 
 void nst_state_save(char *filename) {
-	// Save a state by filename
-	Machine machine(emulator);
-	
-	std::ofstream statefile(filename, std::ifstream::out|std::ifstream::binary);
-	
-	if (statefile.is_open()) { machine.SaveState(statefile, Nes::Api::Machine::NO_COMPRESSION); }
-	fprintf(stderr, "State Saved: %s\n", filename);
-	nst_video_print("State Saved", 8, 212, 2, true);
+	// Save a state by filename, compression and writing are done by the worker
+	nst_savestate_queue(filename);
 }
 
 void nst_state_load(char *filename) {
 	// Load a state by filename
 	Machine machine(emulator);
 	
+	// Make sure a state that was just saved is on disk
+	nst_savestate_flush();
+	
 	std::ifstream statefile(filename, std::ifstream::in|std::ifstream::binary);
 	
 	if (statefile.is_open()) { machine.LoadState(statefile); }
@@ -785,14 +855,64 @@ void nst_state_quickload(int slot) {
 	nst_state_load(slotpath);
 }
 
+static double nst_timing_now() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1000000000.0;
+}
+
+static void nst_timing_fastforward() {
+	// Only the last frame of a round is presented, the others are run without
+	// any video or sound output so nothing is filtered, blitted or synthesized
+	double start = nst_timing_now();
+	double period = (nst_pal() ? PACER_PERIOD_PAL : PACER_PERIOD_NTSC) / 1000000000.0;
+	int frames = 1;
+	
+	if (conf.timing_ffunbounded) {
+		// As many frames as fit in most of a frame period
+		while (nst_timing_now() - start < period * 0.75) {
+			emulator.Execute(NULL, NULL, cNstPads);
+			frames++;
+		}
+	}
+	else {
+		for (; frames < nst_timing_runframes(); frames++) {
+			emulator.Execute(NULL, NULL, cNstPads);
+		}
+	}
+	
+	emulator.Execute(cNstVideo, cNstSound, cNstPads);
+	
+	// Show the speed actually reached about once a second
+	double now = nst_timing_now();
+	ffframes += frames;
+	
+	if (now - ffstart >= 1.0) {
+		char speedtext[32];
+		snprintf(speedtext, sizeof(speedtext), "Fast-forward %.1fx", ffframes * period / (now - ffstart));
+		nst_video_print(speedtext, 8, 212, 2, true);
+		ffstart = now;
+		ffframes = 0;
+	}
+}
+
 int nst_timing_runframes() {
 	// Calculate how many emulation frames to run
 	if (ffspeed) { return conf.timing_ffspeed; }
 	return 1;
 }
 
+bool nst_timing_paced() {
+	// Whether frames should be held back to real time
+	return playing && conf.timing_limiter && !(ffspeed && conf.timing_ffunbounded);
+}
+
 void nst_timing_set_ffspeed() {
 	// Set the framerate to the fast-forward speed
+	if (!ffspeed) {
+		ffstart = nst_timing_now();
+		ffframes = 0;
+	}
 	ffspeed = true;
 }
 
@@ -815,20 +935,33 @@ void nst_reset(bool hardreset) {
 
 void nst_emuloop() {
 	// Main Emulation Loop
-	if (NES_SUCCEEDED(Rewinder(emulator).Enable(true))) {
+	if (nst_netplay_active()) {
+		// Rewinding would only fight the netplay rollbacks
+		Rewinder(emulator).Enable(false);
+	}
+	else if (NES_SUCCEEDED(Rewinder(emulator).Enable(true))) {
 		Rewinder(emulator).EnableSound(true);
 	}
 	
+	// Report save states written in the background
+	nst_savestate_poll();
+	
 	if (playing) {
-		audio_play();
+		// Skip this round if the audio device has enough queued up already
+		if (!audio_play()) { return; }
 		
 		// Pulse the turbo buttons
 		nst_input_turbo_pulse(cNstPads);
 		
-		// Execute frames
-		for (int i = 0; i < nst_timing_runframes(); i++) {
-			emulator.Execute(cNstVideo, cNstSound, cNstPads);
+		// Netplay runs exactly one frame per host frame
+		if (nst_netplay_active()) {
+			nst_netplay_run(cNstVideo, cNstSound, cNstPads);
+			return;
 		}
+		
+		// Execute frames
+		if (ffspeed) { nst_timing_fastforward(); }
+		else { emulator.Execute(cNstVideo, cNstSound, cNstPads); }
 	}
 }
 
@@ -836,6 +969,11 @@ void nst_unload() {
 	// Remove the cartridge and shut down the NES
 	Machine machine(emulator);
 	
+	// End any frame dump, video or audio recording of this game
+	nst_capture_dump_stop();
+	nst_nvr_stop();
+	nst_wavrec_stop();
+	
 	// Power down the NES
 	machine.Power(false);
 
@@ -848,6 +986,7 @@ void nst_pause() {
 	if (playing) {
 		audio_pause();
 		audio_deinit();
+		if (conf.timing_pacer || conf.timing_emuthread) { nst_pacer_report(); }
 	}
 	
 	playing = false;
@@ -870,6 +1009,8 @@ void nst_play() {
 	audio_set_params(cNstSound);
 	audio_unpause();
 	
+	nst_pacer_reset(nst_pal(), conf.timing_speed);
+	
 	if (nst_nsf()) {
 		Nsf nsf(emulator);
 		nsf.PlaySong();
@@ -15,6 +15,8 @@
 
 using namespace Nes::Api;
 
+#define MOVIE_INDEX_INTERVAL 600 // Frames between states in sidecar movie indexes
+
 typedef struct {
 	char nstdir[256];
 	char savedir[256];
@@ -27,6 +29,9 @@ typedef struct {
 	char sampdir[512];
 } nstpaths_t;
 
+// System
+Machine::FavoredSystem nst_default_system();
+
 // Pointers
 void* nst_ptr_video();
 void* nst_ptr_sound();
@@ -55,6 +60,7 @@ void nst_fds_switch();
 void nst_movie_save(char *filename);
 void nst_movie_load(char *filename);
 void nst_movie_stop();
+bool nst_movie_index(const char *filename, const char *romfile);
 
 // NSF
 bool nst_nsf();
@@ -93,6 +99,7 @@ void nst_state_quickload(int isvst);
 
 // Timing
 int nst_timing_runframes();
+bool nst_timing_paced();
 void nst_timing_set_ffspeed();
 void nst_timing_set_default();
 
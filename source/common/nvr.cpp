@@ -0,0 +1,534 @@
+/*
+ * Nestopia UE
+ *
+ * Copyright (C) 2012-2018 R. Danbrook
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ *
+ */
+
+// Lossless video recording of the palette indices the PPU puts out. Only
+// the 8x8 tiles that changed since the last frame are stored, and those go
+// through a small LZ coder that is fast enough to run on every frame.
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "nstcommon.h"
+#include "config.h"
+#include "video.h"
+#include "pacer.h"
+#include "nvr.h"
+#include "wavrec.h"
+
+#define NVR_HEADER_SIZE 28
+#define NVR_PALETTE_SIZE (512 * 3)
+#define NVR_TILE_BYTES (64 + 8)
+#define NVR_VIDEO_RAW (NVR_TILES / 8 + NVR_TILES * NVR_TILE_BYTES)
+#define NVR_LZ_BOUND(n) ((n) + (n) / 255 + 16 + 4)
+#define NVR_HASH_BITS 12
+
+extern Emulator emulator;
+
+static FILE *recfile;
+static uint16_t recpixels[2][NVR_WIDTH * NVR_HEIGHT];
+static int reccurrent;
+static unsigned recframes;
+static int recchannels;
+static int16_t reclast[2];
+static unsigned char recpalette[NVR_PALETTE_SIZE];
+static unsigned char recraw[NVR_VIDEO_RAW];
+static unsigned char reclz[NVR_LZ_BOUND(NVR_VIDEO_RAW)];
+
+static void nst_nvr_put16(unsigned char *p, unsigned v) {
+	p[0] = v & 0xff;
+	p[1] = (v >> 8) & 0xff;
+}
+
+static void nst_nvr_put32(unsigned char *p, unsigned v) {
+	for (int i = 0; i < 4; i++) { p[i] = (v >> (i * 8)) & 0xff; }
+}
+
+static unsigned nst_nvr_get16(const unsigned char *p) {
+	return p[0] | (p[1] << 8);
+}
+
+static unsigned nst_nvr_get32(const unsigned char *p) {
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned)p[3] << 24);
+}
+
+static unsigned char *nst_nvr_lz_length(unsigned char *out, unsigned n) {
+	// Continue a length that did not fit in the token
+	for (; n >= 255; n -= 255) { *out++ = 255; }
+	*out++ = n;
+	return out;
+}
+
+static size_t nst_nvr_lz_encode(const unsigned char *in, size_t size, unsigned char *out) {
+	// Greedy LZ with a single hash probe, out needs NVR_LZ_BOUND(size) bytes
+	static uint32_t table[1 << NVR_HASH_BITS];
+	unsigned char *o = out + 4;
+	size_t anchor = 0, i = 0;
+
+	memset(table, 0, sizeof(table));
+	nst_nvr_put32(out, size);
+
+	while (i + 4 <= size) {
+		uint32_t seq;
+		memcpy(&seq, in + i, 4);
+		uint32_t h = (seq * 2654435761U) >> (32 - NVR_HASH_BITS);
+		size_t cand = table[h];
+		table[h] = i + 1;
+
+		if (!cand-- || i - cand > 0xffff || memcmp(in + cand, in + i, 4)) {
+			i++;
+			continue;
+		}
+
+		size_t len = 4;
+		while (i + len < size && in[cand + len] == in[i + len]) { len++; }
+
+		size_t literals = i - anchor;
+		unsigned char *token = o++;
+		*token = ((literals < 15 ? literals : 15) << 4) | (len - 4 < 15 ? len - 4 : 15);
+		if (literals >= 15) { o = nst_nvr_lz_length(o, literals - 15); }
+		memcpy(o, in + anchor, literals);
+		o += literals;
+		nst_nvr_put16(o, i - cand);
+		o += 2;
+		if (len - 4 >= 15) { o = nst_nvr_lz_length(o, len - 4 - 15); }
+
+		i += len;
+		anchor = i;
+	}
+
+	size_t literals = size - anchor;
+	*o++ = (literals < 15 ? literals : 15) << 4;
+	if (literals >= 15) { o = nst_nvr_lz_length(o, literals - 15); }
+	memcpy(o, in + anchor, literals);
+	o += literals;
+
+	return o - out;
+}
+
+static long nst_nvr_lz_decode(const unsigned char *in, size_t size, unsigned char *out, size_t maxsize) {
+	// Undo nst_nvr_lz_encode, returns the decoded size or -1 for bad data
+	if (size < 4) { return -1; }
+
+	size_t outsize = nst_nvr_get32(in);
+	const unsigned char *end = in + size;
+	unsigned char *o = out;
+
+	if (outsize > maxsize) { return -1; }
+	in += 4;
+
+	while (in < end) {
+		unsigned token = *in++;
+		size_t literals = token >> 4;
+		size_t len = (token & 0x0f) + 4;
+
+		if (literals == 15) {
+			unsigned n;
+			do {
+				if (in >= end) { return -1; }
+				n = *in++;
+				literals += n;
+			} while (n == 255);
+		}
+
+		if (literals > (size_t)(end - in) || literals > outsize - (o - out)) { return -1; }
+		memcpy(o, in, literals);
+		o += literals;
+		in += literals;
+
+		if (in == end) { break; }
+		if (end - in < 2) { return -1; }
+
+		size_t offset = nst_nvr_get16(in);
+		in += 2;
+
+		if ((token & 0x0f) == 15) {
+			unsigned n;
+			do {
+				if (in >= end) { return -1; }
+				n = *in++;
+				len += n;
+			} while (n == 255);
+		}
+
+		if (!offset || offset > (size_t)(o - out) || len > outsize - (o - out)) { return -1; }
+
+		// Byte by byte, matches may overlap what they produce
+		for (const unsigned char *m = o - offset; len; len--) { *o++ = *m++; }
+	}
+
+	return (size_t)(o - out) == outsize ? (long)outsize : -1;
+}
+
+static bool nst_nvr_chunk(int type, const unsigned char *head, size_t headsize, const unsigned char *data, size_t size) {
+	// Write out a chunk with its type and size
+	unsigned char prefix[5];
+	prefix[0] = type;
+	nst_nvr_put32(prefix + 1, headsize + size);
+
+	return fwrite(prefix, 1, sizeof(prefix), recfile) == sizeof(prefix) &&
+		fwrite(head, 1, headsize, recfile) == headsize &&
+		fwrite(data, 1, size, recfile) == size;
+}
+
+bool nst_nvr_start(const char *filename) {
+	// Start recording to a file
+	nst_nvr_stop();
+
+	recfile = fopen(filename, "wb");
+	if (!recfile) {
+		fprintf(stderr, "Video recording: could not open %s\n", filename);
+		return false;
+	}
+
+	// Frames are small, a large buffer keeps the writes few
+	setvbuf(recfile, NULL, _IOFBF, 1 << 20);
+
+	Video video(emulator);
+	memcpy(recpalette, video.GetPalette().GetColors(), NVR_PALETTE_SIZE);
+
+	recchannels = conf.audio_stereo ? 2 : 1;
+	reclast[0] = reclast[1] = 0;
+	recframes = 0;
+	reccurrent = 0;
+
+	// Exact frame rates, from the master clocks
+	unsigned char header[NVR_HEADER_SIZE] = { 'N', 'S', 'T', 'V' };
+	nst_nvr_put16(header + 4, NVR_VERSION);
+	nst_nvr_put16(header + 6, NVR_WIDTH);
+	nst_nvr_put16(header + 8, NVR_HEIGHT);
+	nst_nvr_put16(header + 10, recchannels);
+	nst_nvr_put32(header + 12, conf.audio_sample_rate);
+	nst_nvr_put32(header + 16, nst_pal() ? PACER_RATE_PAL_NUM : PACER_RATE_NTSC_NUM);
+	nst_nvr_put32(header + 20, nst_pal() ? PACER_RATE_PAL_DEN : PACER_RATE_NTSC_DEN);
+
+	fwrite(header, 1, sizeof(header), recfile);
+	fwrite(recpalette, 1, NVR_PALETTE_SIZE, recfile);
+
+	fprintf(stderr, "Video recording: %s\n", filename);
+	return true;
+}
+
+void nst_nvr_stop() {
+	// Finish the recording
+	if (!recfile) { return; }
+
+	if (fclose(recfile)) { fprintf(stderr, "Video recording: write failed\n"); }
+	recfile = NULL;
+
+	fprintf(stderr, "Video recording: %u frames\n", recframes);
+}
+
+bool nst_nvr_recording() {
+	return recfile != NULL;
+}
+
+void nst_nvr_video() {
+	// Record the frame the PPU just finished
+	if (!recfile) { return; }
+
+	Video video(emulator);
+	uint16_t *cur = recpixels[reccurrent];
+	const uint16_t *prev = recpixels[reccurrent ^ 1];
+	video.GetPixels(cur);
+
+	// The palette only changes with the settings
+	if (memcmp(recpalette, video.GetPalette().GetColors(), NVR_PALETTE_SIZE)) {
+		memcpy(recpalette, video.GetPalette().GetColors(), NVR_PALETTE_SIZE);
+		nst_nvr_chunk(NVR_PALETTE, recpalette, NVR_PALETTE_SIZE, NULL, 0);
+	}
+
+	unsigned char key = recframes % NVR_KEYFRAME_INTERVAL == 0;
+	unsigned char *bitmap = recraw;
+	unsigned char *p = recraw + NVR_TILES / 8;
+
+	memset(bitmap, 0, NVR_TILES / 8);
+
+	for (int t = 0; t < NVR_TILES; t++) {
+		int offset = (t / (NVR_WIDTH / 8)) * 8 * NVR_WIDTH + (t % (NVR_WIDTH / 8)) * 8;
+		const uint16_t *a = cur + offset;
+		const uint16_t *b = prev + offset;
+		bool changed = key;
+
+		for (int row = 0; row < 8 && !changed; row++) {
+			changed = memcmp(a + row * NVR_WIDTH, b + row * NVR_WIDTH, 8 * sizeof(uint16_t)) != 0;
+		}
+
+		if (!changed) { continue; }
+
+		bitmap[t >> 3] |= 1 << (t & 7);
+
+		for (int row = 0; row < 8; row++) {
+			for (int col = 0; col < 8; col++) { *p++ = a[row * NVR_WIDTH + col] & 0xff; }
+		}
+
+		for (int row = 0; row < 8; row++) {
+			unsigned char high = 0;
+			for (int col = 0; col < 8; col++) { high |= ((a[row * NVR_WIDTH + col] >> 8) & 1) << col; }
+			*p++ = high;
+		}
+	}
+
+	size_t size = nst_nvr_lz_encode(recraw, p - recraw, reclz);
+
+	if (!nst_nvr_chunk(NVR_VIDEO, &key, 1, reclz, size)) {
+		fprintf(stderr, "Video recording: write failed\n");
+		nst_nvr_stop();
+		return;
+	}
+
+	reccurrent ^= 1;
+	recframes++;
+}
+
+void nst_nvr_audio(const int16_t *samples, int frames) {
+	// Record the sound of a frame, as differences that pack down well
+	if (!recfile) { return; }
+
+	int total = frames * recchannels;
+
+	for (int start = 0; start < total; start += NVR_MAX_AUDIO) {
+		int count = total - start < NVR_MAX_AUDIO ? total - start : NVR_MAX_AUDIO;
+
+		for (int i = 0; i < count; i++) {
+			int c = (start + i) % recchannels;
+			int16_t s = samples[start + i];
+			nst_nvr_put16(recraw + i * 2, (uint16_t)(s - reclast[c]));
+			reclast[c] = s;
+		}
+
+		unsigned char head[2];
+		nst_nvr_put16(head, count);
+		size_t size = nst_nvr_lz_encode(recraw, count * 2, reclz);
+
+		if (!nst_nvr_chunk(NVR_AUDIO, head, sizeof(head), reclz, size)) {
+			fprintf(stderr, "Video recording: write failed\n");
+			nst_nvr_stop();
+			return;
+		}
+	}
+}
+
+bool nst_nvr_open(nvr_reader_t *reader, const char *filename) {
+	// Open a recording and read its header
+	unsigned char header[NVR_HEADER_SIZE];
+
+	memset(reader, 0, sizeof(nvr_reader_t));
+	reader->file = fopen(filename, "rb");
+	if (!reader->file) { return false; }
+
+	if (fread(header, 1, sizeof(header), reader->file) != sizeof(header) ||
+		fread(reader->palette, 1, NVR_PALETTE_SIZE, reader->file) != NVR_PALETTE_SIZE ||
+		memcmp(header, "NSTV", 4) ||
+		nst_nvr_get16(header + 4) != NVR_VERSION ||
+		nst_nvr_get16(header + 6) != NVR_WIDTH ||
+		nst_nvr_get16(header + 8) != NVR_HEIGHT) {
+		nst_nvr_close(reader);
+		return false;
+	}
+
+	reader->channels = nst_nvr_get16(header + 10);
+	reader->rate = nst_nvr_get32(header + 12);
+	reader->fpsnum = nst_nvr_get32(header + 16);
+	reader->fpsden = nst_nvr_get32(header + 20);
+
+	if (reader->channels < 1 || reader->channels > 2 || !reader->fpsden) {
+		nst_nvr_close(reader);
+		return false;
+	}
+
+	reader->buf = (unsigned char*)malloc(NVR_LZ_BOUND(NVR_VIDEO_RAW) + 2);
+	reader->raw = (unsigned char*)malloc(NVR_VIDEO_RAW);
+
+	if (!reader->buf || !reader->raw) {
+		nst_nvr_close(reader);
+		return false;
+	}
+
+	return true;
+}
+
+int nst_nvr_read(nvr_reader_t *reader) {
+	// Read the next chunk, returns its type, NVR_END at the end or -1 on bad data
+	unsigned char prefix[5];
+
+	while (true) {
+		size_t got = fread(prefix, 1, sizeof(prefix), reader->file);
+		if (got == 0) { return NVR_END; }
+		if (got != sizeof(prefix)) { return -1; }
+
+		size_t size = nst_nvr_get32(prefix + 1);
+
+		if (size > NVR_LZ_BOUND(NVR_VIDEO_RAW) + 2) {
+			if (prefix[0] == NVR_VIDEO || prefix[0] == NVR_AUDIO || prefix[0] == NVR_PALETTE) { return -1; }
+			if (fseek(reader->file, size, SEEK_CUR)) { return -1; }
+			continue;
+		}
+
+		if (fread(reader->buf, 1, size, reader->file) != size) { return -1; }
+
+		switch (prefix[0]) {
+			case NVR_VIDEO: {
+				if (size < 1) { return -1; }
+				long rawsize = nst_nvr_lz_decode(reader->buf + 1, size - 1, reader->raw, NVR_VIDEO_RAW);
+				if (rawsize < NVR_TILES / 8) { return -1; }
+
+				const unsigned char *bitmap = reader->raw;
+				const unsigned char *p = reader->raw + NVR_TILES / 8;
+				const unsigned char *end = reader->raw + rawsize;
+
+				for (int t = 0; t < NVR_TILES; t++) {
+					if (!(bitmap[t >> 3] & (1 << (t & 7)))) { continue; }
+					if (end - p < NVR_TILE_BYTES) { return -1; }
+
+					uint16_t *a = reader->pixels + (t / (NVR_WIDTH / 8)) * 8 * NVR_WIDTH + (t % (NVR_WIDTH / 8)) * 8;
+
+					for (int row = 0; row < 8; row++) {
+						for (int col = 0; col < 8; col++) {
+							a[row * NVR_WIDTH + col] = p[row * 8 + col] | (((p[64 + row] >> col) & 1) << 8);
+						}
+					}
+
+					p += NVR_TILE_BYTES;
+				}
+
+				return p == end ? NVR_VIDEO : -1;
+			}
+
+			case NVR_AUDIO: {
+				if (size < 2) { return -1; }
+				int count = nst_nvr_get16(reader->buf);
+				if (count > NVR_MAX_AUDIO ||
+					nst_nvr_lz_decode(reader->buf + 2, size - 2, reader->raw, NVR_VIDEO_RAW) != count * 2) {
+					return -1;
+				}
+
+				for (int i = 0; i < count; i++) {
+					int c = i % reader->channels;
+					reader->last[c] += (int16_t)nst_nvr_get16(reader->raw + i * 2);
+					reader->samples[i] = reader->last[c];
+				}
+
+				reader->numsamples = count;
+				return NVR_AUDIO;
+			}
+
+			case NVR_PALETTE:
+				if (size != NVR_PALETTE_SIZE) { return -1; }
+				memcpy(reader->palette, reader->buf, NVR_PALETTE_SIZE);
+				return NVR_PALETTE;
+
+			default: break; // Unknown chunks are skipped
+		}
+	}
+}
+
+void nst_nvr_close(nvr_reader_t *reader) {
+	// Close a recording opened with nst_nvr_open
+	if (reader->file) { fclose(reader->file); }
+	free(reader->buf);
+	free(reader->raw);
+	memset(reader, 0, sizeof(nvr_reader_t));
+}
+
+static void nst_nvr_yuv(const unsigned char palette[512][3], unsigned char yuv[512][3]) {
+	// BT.601 studio swing, which is what players expect from .y4m
+	for (int i = 0; i < 512; i++) {
+		double r = palette[i][0], g = palette[i][1], b = palette[i][2];
+		yuv[i][0] = (unsigned char)(16.5 + (65.481 * r + 128.553 * g + 24.966 * b) / 255);
+		yuv[i][1] = (unsigned char)(128.5 + (-37.797 * r - 74.203 * g + 112.0 * b) / 255);
+		yuv[i][2] = (unsigned char)(128.5 + (112.0 * r - 93.786 * g - 18.214 * b) / 255);
+	}
+}
+
+bool nst_nvr_convert(const char *filename) {
+	// Convert a recording into filename.y4m and filename.wav
+	static nvr_reader_t reader;
+	static unsigned char planes[3][NVR_WIDTH * NVR_HEIGHT];
+	unsigned char yuv[512][3];
+	char path[512];
+
+	if (!nst_nvr_open(&reader, filename)) {
+		fprintf(stderr, "Video conversion: not a recording: %s\n", filename);
+		return false;
+	}
+
+	snprintf(path, sizeof(path), "%s.y4m", filename);
+	FILE *y4m = fopen(path, "wb");
+	snprintf(path, sizeof(path), "%s.wav", filename);
+	FILE *wav = fopen(path, "wb");
+
+	if (!y4m || !wav) {
+		fprintf(stderr, "Video conversion: could not write next to %s\n", filename);
+		if (y4m) { fclose(y4m); }
+		if (wav) { fclose(wav); }
+		nst_nvr_close(&reader);
+		return false;
+	}
+
+	// NES pixels are not square, 8:7 on NTSC and about 11:8 on PAL
+	bool pal = (double)reader.fpsnum / reader.fpsden < 55;
+	fprintf(y4m, "YUV4MPEG2 W%d H%d F%u:%u Ip A%s C444\n", NVR_WIDTH, NVR_HEIGHT,
+		reader.fpsnum, reader.fpsden, pal ? "11:8" : "8:7");
+	nst_wav_header(wav, reader.rate, reader.channels, 0);
+	nst_nvr_yuv(reader.palette, yuv);
+
+	unsigned frames = 0, bytes = 0;
+	int type;
+
+	while ((type = nst_nvr_read(&reader)) > 0) {
+		if (type == NVR_PALETTE) {
+			nst_nvr_yuv(reader.palette, yuv);
+		}
+		else if (type == NVR_VIDEO) {
+			for (int i = 0; i < NVR_WIDTH * NVR_HEIGHT; i++) {
+				const unsigned char *c = yuv[reader.pixels[i] & 0x1ff];
+				planes[0][i] = c[0];
+				planes[1][i] = c[1];
+				planes[2][i] = c[2];
+			}
+			fputs("FRAME\n", y4m);
+			fwrite(planes, 1, sizeof(planes), y4m);
+			frames++;
+		}
+		else if (type == NVR_AUDIO) {
+			unsigned char le[NVR_MAX_AUDIO * 2];
+			for (int i = 0; i < reader.numsamples; i++) { nst_nvr_put16(le + i * 2, (uint16_t)reader.samples[i]); }
+			fwrite(le, 2, reader.numsamples, wav);
+			bytes += reader.numsamples * 2;
+		}
+	}
+
+	unsigned rate = frames ? nst_wav_rate(bytes, reader.channels, frames, pal) : reader.rate;
+
+	fseek(wav, 0, SEEK_SET);
+	nst_wav_header(wav, rate, reader.channels, bytes);
+
+	bool ok = type == NVR_END && !ferror(y4m) && !ferror(wav);
+	ok = !fclose(y4m) && ok;
+	ok = !fclose(wav) && ok;
+	nst_nvr_close(&reader);
+
+	if (type != NVR_END) { fprintf(stderr, "Video conversion: damaged recording, stopped after %u frames\n", frames); }
+	fprintf(stderr, "Video conversion: %u frames, %u Hz sound\n", frames, rate);
+
+	return ok;
+}
@@ -0,0 +1,70 @@
+#ifndef _NVR_H_
+#define _NVR_H_
+
+#include <stdio.h>
+#include <stdint.h>
+
+#define NVR_VERSION 1
+#define NVR_WIDTH 256
+#define NVR_HEIGHT 240
+#define NVR_TILES ((NVR_WIDTH / 8) * (NVR_HEIGHT / 8))
+#define NVR_KEYFRAME_INTERVAL 600 // Frames between frames coded without reference to the last one
+#define NVR_MAX_AUDIO 8192 // Samples per chunk, all channels
+
+// Lossless recording of the unfiltered picture and the sound, all values
+// little-endian. The file starts with
+//   "NSTV", u16 version, u16 width, u16 height, u16 channels,
+//   u32 sample rate, u32 frame rate numerator, u32 frame rate denominator,
+//   512 palette entries of 3 bytes each (R, G, B)
+// followed by chunks of u8 type, u32 payload size and the payload:
+//   'V' u8 keyframe, then LZ data of a bitmap of changed 8x8 tiles (one bit
+//       per tile, rows top to bottom, lowest bit first) and, for every tile
+//       set, 64 low bytes of its 9-bit palette indices and 8 bytes holding
+//       the ninth bits. Tiles not set are the same as in the last frame.
+//   'A' u16 sample count, then LZ data of the samples as differences from
+//       the previous sample of the same channel
+//   'P' a new palette of 512 * 3 bytes
+// LZ data is u32 decoded size and LZ4-style sequences: a token of literal
+// count (high nibble) and match length minus 4 (low nibble), each 15 being
+// continued by bytes added on until one is below 255, the literals, then a
+// u16 match offset. Runs are matches at offset 1. The last sequence ends
+// after its literals.
+
+enum {
+	NVR_END = 0,
+	NVR_VIDEO = 'V',
+	NVR_AUDIO = 'A',
+	NVR_PALETTE = 'P'
+};
+
+typedef struct {
+	FILE *file;
+	int channels;
+	unsigned rate;
+	unsigned fpsnum;
+	unsigned fpsden;
+	unsigned char palette[512][3];
+	uint16_t pixels[NVR_WIDTH * NVR_HEIGHT]; // Picture after the last video chunk
+	int16_t samples[NVR_MAX_AUDIO]; // Sound from the last audio chunk
+	int numsamples;
+	int16_t last[2];
+	unsigned char *buf;
+	unsigned char *raw;
+} nvr_reader_t;
+
+// Recording, fed from the video and sound output callbacks
+bool nst_nvr_start(const char *filename);
+void nst_nvr_stop();
+bool nst_nvr_recording();
+void nst_nvr_video();
+void nst_nvr_audio(const int16_t *samples, int frames);
+
+// Playback
+bool nst_nvr_open(nvr_reader_t *reader, const char *filename);
+int nst_nvr_read(nvr_reader_t *reader);
+void nst_nvr_close(nvr_reader_t *reader);
+
+// Conversion to a .y4m picture and a .wav sound file next to the recording
+bool nst_nvr_convert(const char *filename);
+
+#endif
@@ -0,0 +1,141 @@
+/*
+ * Nestopia UE
+ *
+ * Copyright (C) 2012-2018 R. Danbrook
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ *
+ */
+
+// Frame pacing against the monotonic clock. The kernel is trusted to wake
+// up somewhere near the requested time, the rest of the way to the deadline
+// is covered by spinning.
+
+#include <algorithm>
+
+#include <errno.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#include <SDL.h>
+
+#include "pacer.h"
+
+static double period = PACER_PERIOD_NTSC;
+static double deadline;
+static int64_t last;
+static bool started = false;
+
+static float frametimes[PACER_SAMPLES]; // Nanoseconds
+static int numframes;
+
+// The emulation thread waits while the interface resets and reports,
+// only ever held for a few assignments and never while sleeping
+static SDL_SpinLock lock;
+
+static int64_t nst_pacer_now() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+void nst_pacer_reset(bool pal, int speed) {
+	// Start pacing afresh, speed is in frames per second at 60 Hz
+	double length = pal ? PACER_PERIOD_PAL : PACER_PERIOD_NTSC;
+	if (speed > 0) { length = length * 60 / speed; }
+
+	SDL_AtomicLock(&lock);
+	period = length;
+	started = false;
+	numframes = 0;
+	SDL_AtomicUnlock(&lock);
+}
+
+void nst_pacer_wait() {
+	// Wait for the start of the next frame
+	int64_t now = nst_pacer_now();
+
+	// Start over rather than rush to catch up after a stall or pause
+	SDL_AtomicLock(&lock);
+	deadline += period;
+	bool restart = !started || now > deadline + period;
+	started = true;
+	SDL_AtomicUnlock(&lock);
+
+	if (restart) {
+		deadline = now;
+		last = now;
+		return;
+	}
+
+	int64_t target = (int64_t)deadline - PACER_SPIN_NS;
+
+	if (target > now) {
+		struct timespec ts;
+		ts.tv_sec = target / 1000000000;
+		ts.tv_nsec = target % 1000000000;
+		while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR);
+	}
+
+	do { now = nst_pacer_now(); } while (now < (int64_t)deadline);
+
+	SDL_AtomicLock(&lock);
+	frametimes[numframes++ % PACER_SAMPLES] = now - last;
+	SDL_AtomicUnlock(&lock);
+	last = now;
+}
+
+void nst_pacer_stats(pacer_stats_t *stats) {
+	// Summarize the most recent frame times
+	float sorted[PACER_SAMPLES];
+	double sum = 0, sumsq = 0;
+
+	SDL_AtomicLock(&lock);
+	int count = numframes < PACER_SAMPLES ? numframes : PACER_SAMPLES;
+	for (int i = 0; i < count; i++) { sorted[i] = frametimes[i] / 1000; }
+	SDL_AtomicUnlock(&lock);
+
+	stats->frames = count;
+	stats->mean = stats->stddev = stats->p50 = stats->p90 = stats->p99 = stats->p999 = stats->max = 0;
+	if (!count) { return; }
+
+	for (int i = 0; i < count; i++) {
+		sum += sorted[i];
+		sumsq += (double)sorted[i] * sorted[i];
+	}
+
+	std::sort(sorted, sorted + count);
+
+	stats->mean = sum / count;
+	stats->stddev = sqrt(std::max(0.0, sumsq / count - stats->mean * stats->mean));
+	stats->p50 = sorted[count * 50 / 100];
+	stats->p90 = sorted[count * 90 / 100];
+	stats->p99 = sorted[count * 99 / 100];
+	stats->p999 = sorted[count * 999 / 1000];
+	stats->max = sorted[count - 1];
+}
+
+void nst_pacer_report() {
+	// Print the frame time statistics
+	pacer_stats_t stats;
+	nst_pacer_stats(&stats);
+	if (!stats.frames) { return; }
+
+	fprintf(stderr, "Pacer: %d frames, mean %.1fus, stddev %.1fus, p50 %.1fus, p90 %.1fus, p99 %.1fus, p99.9 %.1fus, max %.1fus\n",
+		stats.frames, stats.mean, stats.stddev, stats.p50, stats.p90, stats.p99, stats.p999, stats.max);
+}
@@ -0,0 +1,33 @@
+#ifndef _PACER_H_
+#define _PACER_H_
+
+#define PACER_SPIN_NS 1000000 // Sleep until this close to the deadline, then spin
+#define PACER_SAMPLES 1024 // Frame times kept for the statistics
+
+// Exact frame rates as fractions, derived from the master clocks
+#define PACER_RATE_NTSC_NUM 39375000 // 236250000 / 11 / 12 / 29780.5 = 60.0988 Hz
+#define PACER_RATE_NTSC_DEN 655171
+#define PACER_RATE_PAL_NUM 10640685 // 26601712.5 / 16 / 33247.5 = 50.0070 Hz
+#define PACER_RATE_PAL_DEN 212784
+
+// Exact frame periods in nanoseconds
+#define PACER_PERIOD_NTSC (1e9 * PACER_RATE_NTSC_DEN / PACER_RATE_NTSC_NUM)
+#define PACER_PERIOD_PAL (1e9 * PACER_RATE_PAL_DEN / PACER_RATE_PAL_NUM)
+
+typedef struct {
+	int frames; // Frame times the figures are taken from
+	double mean; // Everything in microseconds
+	double stddev;
+	double p50;
+	double p90;
+	double p99;
+	double p999;
+	double max;
+} pacer_stats_t;
+
+void nst_pacer_reset(bool pal, int speed);
+void nst_pacer_wait();
+void nst_pacer_stats(pacer_stats_t *stats);
+void nst_pacer_report();
+
+#endif
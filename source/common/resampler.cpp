@@ -0,0 +1,116 @@
+/*
+ * Nestopia UE
+ *
+ * Copyright (C) 2012-2018 R. Danbrook
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ *
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "resampler.h"
+
+#define RESAMPLER_HALF (RESAMPLER_TAPS / 2)
+#define RESAMPLER_CUTOFF 0.95 // Of the input Nyquist frequency, leaves room for ratios below 1
+
+static float kernel[RESAMPLER_PHASES + 1][RESAMPLER_TAPS];
+static bool kernelready = false;
+
+static void nst_resampler_kernel() {
+	// Blackman windowed sinc for every phase, each normalized to unity gain
+	for (int p = 0; p <= RESAMPLER_PHASES; p++) {
+		double frac = (double)p / RESAMPLER_PHASES;
+		double sum = 0;
+
+		for (int k = 0; k < RESAMPLER_TAPS; k++) {
+			double x = (k - RESAMPLER_HALF + 1) - frac;
+			double w = (x + RESAMPLER_HALF) / RESAMPLER_HALF; // 0 to 2 across the window
+			double window = 0.42 - 0.5 * cos(M_PI * w) + 0.08 * cos(2 * M_PI * w);
+			double sinc = x == 0 ? 1.0 : sin(M_PI * RESAMPLER_CUTOFF * x) / (M_PI * RESAMPLER_CUTOFF * x);
+
+			kernel[p][k] = w <= 0 || w >= 2 ? 0 : sinc * window;
+			sum += kernel[p][k];
+		}
+
+		for (int k = 0; k < RESAMPLER_TAPS; k++) { kernel[p][k] /= sum; }
+	}
+
+	kernelready = true;
+}
+
+void nst_resampler_init(resampler_t *rs, int channels) {
+	// Start out with silence before the first input
+	if (!kernelready) { nst_resampler_kernel(); }
+
+	memset(rs, 0, sizeof(resampler_t));
+	rs->channels = channels;
+	rs->count = RESAMPLER_HALF;
+	rs->pos = RESAMPLER_HALF - 1;
+}
+
+int nst_resampler_run(resampler_t *rs, const int16_t *in, int frames, int16_t *out, int maxframes, double ratio) {
+	// Turn frames of input into about frames * ratio frames of output
+	double step = 1.0 / ratio;
+	int produced = 0;
+
+	if (frames > RESAMPLER_MAX_FRAMES) { frames = RESAMPLER_MAX_FRAMES; }
+
+	for (int i = 0; i < frames; i++) {
+		for (int c = 0; c < rs->channels; c++) {
+			rs->history[c][rs->count + i] = in[i * rs->channels + c];
+		}
+	}
+
+	rs->count += frames;
+
+	while ((int)rs->pos + RESAMPLER_HALF < rs->count && produced < maxframes) {
+		int base = (int)rs->pos;
+		double phase = (rs->pos - base) * RESAMPLER_PHASES;
+		int p = (int)phase;
+		float t = phase - p;
+
+		for (int c = 0; c < rs->channels; c++) {
+			const float *x = &rs->history[c][base - RESAMPLER_HALF + 1];
+			float sum = 0;
+
+			for (int k = 0; k < RESAMPLER_TAPS; k++) {
+				sum += x[k] * (kernel[p][k] + t * (kernel[p + 1][k] - kernel[p][k]));
+			}
+
+			int sample = (int)lrintf(sum);
+			out[produced * rs->channels + c] = sample > 32767 ? 32767 : sample < -32768 ? -32768 : sample;
+		}
+
+		produced++;
+		rs->pos += step;
+	}
+
+	// Keep only what the next output still needs
+	int shift = (int)rs->pos - RESAMPLER_HALF + 1;
+
+	if (shift > 0) {
+		for (int c = 0; c < rs->channels; c++) {
+			memmove(rs->history[c], &rs->history[c][shift], (rs->count - shift) * sizeof(float));
+		}
+
+		rs->count -= shift;
+		rs->pos -= shift;
+	}
+
+	return produced;
+}
@@ -0,0 +1,23 @@
+#ifndef _RESAMPLER_H_
+#define _RESAMPLER_H_
+
+#include <stdint.h>
+
+#define RESAMPLER_TAPS 16 // Input samples each output sample is made from
+#define RESAMPLER_PHASES 256 // Kernel positions between two input samples
+#define RESAMPLER_MAX_FRAMES 4096 // Input frames per call
+
+// Windowed sinc resampler for ratios close to 1, meant for nudging the
+// output rate a little without audible artifacts
+
+typedef struct {
+	int channels;
+	int count; // Input frames held
+	double pos; // Input position of the next output frame
+	float history[2][RESAMPLER_TAPS + RESAMPLER_MAX_FRAMES];
+} resampler_t;
+
+void nst_resampler_init(resampler_t *rs, int channels);
+int nst_resampler_run(resampler_t *rs, const int16_t *in, int frames, int16_t *out, int maxframes, double ratio);
+
+#endif
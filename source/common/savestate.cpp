@@ -0,0 +1,145 @@
+/*
+ * Nestopia UE
+ *
+ * Copyright (C) 2012-2018 R. Danbrook
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ *
+ */
+
+#include <fstream>
+
+#include <stdio.h>
+#include <string.h>
+
+#include "nstcommon.h"
+#include "savestate.h"
+#include "video.h"
+#include "workqueue.h"
+
+extern Emulator emulator;
+
+typedef struct {
+	char filename[520];
+	Machine::Snapshot *snapshot;
+	Nes::Result result;
+} savestate_job_t;
+
+static savestate_job_t jobs[SAVESTATE_QUEUE_SIZE];
+
+// Jobs in [done, written) are on disk but not reported yet
+static workqueue_t queue;
+static unsigned done;
+
+static void nst_savestate_write(savestate_job_t *job) {
+	// Compress and write out a snapshot, this is the slow part
+	std::ofstream statefile(job->filename, std::ifstream::out|std::ifstream::binary);
+
+	if (statefile.is_open()) { job->result = job->snapshot->Write(statefile, Machine::USE_COMPRESSION); }
+	else { job->result = Nes::RESULT_ERR_GENERIC; }
+}
+
+static void nst_savestate_report(savestate_job_t *job) {
+	// Report a finished job, always called from the emulation thread
+	if (NES_SUCCEEDED(job->result)) {
+		fprintf(stderr, "State Saved: %s\n", job->filename);
+		nst_video_print("State Saved", 8, 212, 2, true);
+	}
+	else {
+		fprintf(stderr, "State Save Failed: %s\n", job->filename);
+		nst_video_print("State Save Failed", 8, 212, 2, true);
+	}
+}
+
+static void nst_savestate_process(unsigned slot) {
+	// Runs on the worker, snapshots are written out in order
+	nst_savestate_write(&jobs[slot]);
+}
+
+void nst_savestate_init() {
+	// Start the save state worker
+	if (queue.running) { return; }
+
+	for (int i = 0; i < SAVESTATE_QUEUE_SIZE; i++) {
+		jobs[i].snapshot = new Machine::Snapshot;
+	}
+
+	done = 0;
+	queue.size = SAVESTATE_QUEUE_SIZE;
+	queue.process = nst_savestate_process;
+
+	if (!nst_workqueue_start(&queue, "savestate")) {
+		fprintf(stderr, "Save states: could not start worker thread: %s\n", SDL_GetError());
+	}
+}
+
+void nst_savestate_deinit() {
+	// Write out anything still pending and stop the worker
+	nst_workqueue_stop(&queue);
+	nst_savestate_poll();
+
+	for (int i = 0; i < SAVESTATE_QUEUE_SIZE; i++) {
+		delete jobs[i].snapshot;
+		jobs[i].snapshot = NULL;
+	}
+}
+
+bool nst_savestate_queue(const char *filename) {
+	// Take a snapshot and hand it over to the worker
+	Machine machine(emulator);
+	savestate_job_t job;
+
+	if (!queue.running) {
+		// No worker, do it all synchronously
+		Machine::Snapshot snapshot;
+		snprintf(job.filename, sizeof(job.filename), "%s", filename);
+		job.snapshot = &snapshot;
+		job.result = machine.SaveState(snapshot);
+		if (NES_SUCCEEDED(job.result)) { nst_savestate_write(&job); }
+		nst_savestate_report(&job);
+		return NES_SUCCEEDED(job.result);
+	}
+
+	// Every slot in use or still to be reported, wait for the oldest one to be written
+	if (queue.queued - done == SAVESTATE_QUEUE_SIZE) { nst_savestate_flush(); }
+
+	savestate_job_t *slot = &jobs[nst_workqueue_slot(&queue, true)];
+	snprintf(slot->filename, sizeof(slot->filename), "%s", filename);
+	slot->result = machine.SaveState(*slot->snapshot);
+
+	if (NES_FAILED(slot->result)) {
+		nst_savestate_report(slot);
+		return false;
+	}
+
+	nst_workqueue_submit(&queue);
+	return true;
+}
+
+void nst_savestate_flush() {
+	// Wait for all queued states to reach the disk
+	nst_workqueue_flush(&queue);
+	nst_savestate_poll();
+}
+
+void nst_savestate_poll() {
+	// Report states that have been written since the last poll
+	unsigned end = nst_workqueue_written(&queue);
+
+	for (; done != end; done++) {
+		nst_savestate_report(&jobs[done % SAVESTATE_QUEUE_SIZE]);
+	}
+}
@@ -0,0 +1,12 @@
+#ifndef _SAVESTATE_H_
+#define _SAVESTATE_H_
+
+#define SAVESTATE_QUEUE_SIZE 8
+
+void nst_savestate_init();
+void nst_savestate_deinit();
+bool nst_savestate_queue(const char *filename);
+void nst_savestate_flush();
+void nst_savestate_poll();
+
+#endif
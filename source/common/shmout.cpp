@@ -0,0 +1,199 @@
+/*
+ * Nestopia UE
+ *
+ * Copyright (C) 2012-2018 R. Danbrook
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ *
+ */
+
+
+// Shared memory output for other processes, see shmout.h for the layout.
+// Only the emulation thread writes, so the rings need no locks.
+
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+#include "nstcommon.h"
+#include "config.h"
+#include "video.h"
+#include "shmout.h"
+
+extern Emulator emulator;
+
+static shmout_header_t *header = NULL;
+static unsigned char *shm = NULL;
+static size_t shmsize;
+static char shmname[256];
+static int shmformat;
+
+static uint64_t nst_shmout_time() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void nst_shmout_publish(uint32_t *slotseq, uint32_t *seq, uint32_t value) {
+	// Make the slot visible before the header says it is there
+	__atomic_store_n(slotseq, value, __ATOMIC_RELEASE);
+	__atomic_store_n(seq, value, __ATOMIC_RELEASE);
+
+#ifdef __linux__
+	syscall(SYS_futex, seq, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+#endif
+}
+
+bool nst_shmout_start(const char *name, int format) {
+	// Create the object and lay out the header, replacing any left behind
+	nst_shmout_stop();
+
+	snprintf(shmname, sizeof(shmname), "%s%s", name[0] == '/' ? "" : "/", name);
+	shmformat = format;
+
+	size_t videosize = VIDBUF_MAXSIZE * sizeof(uint32_t);
+	size_t headersize = (sizeof(shmout_header_t) + 4095) & ~(size_t)4095;
+	shmsize = headersize + SHMOUT_VIDEO_SLOTS * videosize + SHMOUT_AUDIO_SLOTS * SHMOUT_AUDIO_SLOT_SIZE;
+
+	int fd = shm_open(shmname, O_RDWR|O_CREAT|O_TRUNC, 0600);
+
+	if (fd < 0) {
+		fprintf(stderr, "Shared memory: could not create %s\n", shmname);
+		return false;
+	}
+
+	void *map = ftruncate(fd, shmsize) == 0 ? mmap(NULL, shmsize, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+	close(fd);
+
+	if (map == MAP_FAILED) {
+		fprintf(stderr, "Shared memory: could not map %lu bytes of %s\n", (unsigned long)shmsize, shmname);
+		shm_unlink(shmname);
+		return false;
+	}
+
+	shm = (unsigned char*)map;
+	header = (shmout_header_t*)map;
+
+	memcpy(header->magic, "NSHM", 4);
+	header->version = SHMOUT_VERSION;
+	header->header_size = sizeof(shmout_header_t);
+	header->video_slots = SHMOUT_VIDEO_SLOTS;
+	header->video_slot_size = videosize;
+	header->video_offset = headersize;
+	header->audio_slots = SHMOUT_AUDIO_SLOTS;
+	header->audio_slot_size = SHMOUT_AUDIO_SLOT_SIZE;
+	header->audio_offset = headersize + SHMOUT_VIDEO_SLOTS * videosize;
+	__atomic_store_n(&header->writing, 1, __ATOMIC_RELEASE);
+
+	fprintf(stderr, "Shared memory: writing %s frames to %s\n", format == SHMOUT_INDICES ? "palette index" : "RGB", shmname);
+	return true;
+}
+
+void nst_shmout_stop() {
+	// Tell readers the writer is gone, then remove the object
+	if (!header) { return; }
+
+	__atomic_store_n(&header->writing, 0, __ATOMIC_RELEASE);
+
+#ifdef __linux__
+	syscall(SYS_futex, &header->video_seq, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+	syscall(SYS_futex, &header->audio_seq, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+#endif
+
+	munmap(shm, shmsize);
+	shm_unlink(shmname);
+
+	header = NULL;
+	shm = NULL;
+}
+
+bool nst_shmout_active() {
+	return header != NULL;
+}
+
+void nst_shmout_video(const uint32_t *pixels, int width, int height) {
+	// Copy a finished frame into the next slot
+	if (!header) { return; }
+
+	uint32_t seq = header->video_seq + 1;
+	if (!seq) { seq = 1; } // 0 marks a slot being written
+
+	shmout_video_t *meta = &header->video[seq % SHMOUT_VIDEO_SLOTS];
+	unsigned char *slot = shm + header->video_offset + (seq % SHMOUT_VIDEO_SLOTS) * header->video_slot_size;
+
+	__atomic_store_n(&meta->seq, 0, __ATOMIC_RELEASE);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	if (shmformat == SHMOUT_INDICES) {
+		Video(emulator).GetPixels((unsigned short*)slot);
+		meta->width = Video::Output::WIDTH;
+		meta->height = Video::Output::HEIGHT;
+		meta->pitch = Video::Output::WIDTH * sizeof(unsigned short);
+	}
+	else if ((size_t)width * height * sizeof(uint32_t) <= header->video_slot_size) {
+		memcpy(slot, pixels, (size_t)width * height * sizeof(uint32_t));
+		meta->width = width;
+		meta->height = height;
+		meta->pitch = width * sizeof(uint32_t);
+	}
+	else {
+		header->dropped++;
+		return;
+	}
+
+	meta->format = shmformat;
+	meta->frame = emulator.Frame();
+	meta->time = nst_shmout_time();
+
+	nst_shmout_publish(&meta->seq, &header->video_seq, seq);
+}
+
+void nst_shmout_audio(const int16_t *samples, int frames) {
+	// Copy a frame's samples into the next slot
+	if (!header || frames <= 0) { return; }
+
+	int channels = conf.audio_stereo ? 2 : 1;
+	size_t size = (size_t)frames * channels * sizeof(int16_t);
+	if (size > SHMOUT_AUDIO_SLOT_SIZE) { size = SHMOUT_AUDIO_SLOT_SIZE; }
+
+	uint32_t seq = header->audio_seq + 1;
+	if (!seq) { seq = 1; }
+
+	shmout_audio_t *meta = &header->audio[seq % SHMOUT_AUDIO_SLOTS];
+
+	__atomic_store_n(&meta->seq, 0, __ATOMIC_RELEASE);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	memcpy(shm + header->audio_offset + (seq % SHMOUT_AUDIO_SLOTS) * SHMOUT_AUDIO_SLOT_SIZE, samples, size);
+
+	meta->rate = conf.audio_sample_rate;
+	meta->channels = channels;
+	meta->samples = size / (channels * sizeof(int16_t));
+	meta->frame = emulator.Frame();
+	meta->time = nst_shmout_time();
+
+	nst_shmout_publish(&meta->seq, &header->audio_seq, seq);
+}
@@ -0,0 +1,75 @@
+#ifndef _SHMOUT_H_
+#define _SHMOUT_H_
+
+#include <stdint.h>
+
+#define SHMOUT_VERSION 1
+#define SHMOUT_VIDEO_SLOTS 8 // Frames a reader can fall behind before they are overwritten
+#define SHMOUT_AUDIO_SLOTS 32 // Audio blocks, one per frame
+#define SHMOUT_AUDIO_SLOT_SIZE 16384 // Bytes, a frame of 16-bit stereo at 96kHz and 50Hz is 7680
+
+#define SHMOUT_RGB 0 // Filtered output as 32-bit 0xXXRRGGBB pixels
+#define SHMOUT_INDICES 1 // 256x240 16-bit palette indices, before any filter
+
+// Shared memory output: each video frame and audio block is copied once into
+// a POSIX shared memory object, where readers in other processes use it in
+// place. Values are in native byte order, readers run on the same machine.
+//
+// The object starts with shmout_header_t. The video ring follows at
+// video_offset, video_slots slots of video_slot_size bytes, then the audio
+// ring at audio_offset. Frame n (counting from 1) goes in slot n % slots.
+//
+// The writer clears a slot's seq, fills the slot and its metadata, stores the
+// slot's seq and then the header's video_seq or audio_seq, and wakes futex
+// waiters on that word on Linux. A reader waits for the header's seq to move
+// past the last one it saw, reads the slot in place, then after an acquire
+// fence checks that the slot's seq is still the one it expected. If not, the
+// writer lapped it and the data may be torn. writing drops to 0 when the
+// writer goes away.
+
+typedef struct {
+	uint32_t seq; // Frame in the slot, 0 while being written
+	uint32_t format; // SHMOUT_RGB or SHMOUT_INDICES
+	uint32_t width;
+	uint32_t height;
+	uint32_t pitch; // Bytes per line
+	uint32_t frame; // Emulator frame number
+	uint64_t time; // CLOCK_MONOTONIC, nanoseconds
+} shmout_video_t;
+
+typedef struct {
+	uint32_t seq; // Block in the slot, 0 while being written
+	uint32_t rate;
+	uint32_t channels; // Interleaved 16-bit samples
+	uint32_t samples; // Per channel
+	uint32_t frame; // Emulator frame number
+	uint32_t reserved;
+	uint64_t time; // CLOCK_MONOTONIC, nanoseconds
+} shmout_audio_t;
+
+typedef struct {
+	char magic[4]; // "NSHM"
+	uint32_t version; // SHMOUT_VERSION
+	uint32_t header_size;
+	uint32_t writing; // 1 while the writer is attached
+	uint32_t video_seq; // Frames written, futex word
+	uint32_t audio_seq; // Blocks written, futex word
+	uint32_t video_slots;
+	uint32_t video_slot_size;
+	uint32_t video_offset;
+	uint32_t audio_slots;
+	uint32_t audio_slot_size;
+	uint32_t audio_offset;
+	uint32_t dropped; // Video frames too large for a slot
+	uint32_t reserved[3];
+	shmout_video_t video[SHMOUT_VIDEO_SLOTS];
+	shmout_audio_t audio[SHMOUT_AUDIO_SLOTS];
+} shmout_header_t;
+
+bool nst_shmout_start(const char *name, int format);
+void nst_shmout_stop();
+bool nst_shmout_active();
+void nst_shmout_video(const uint32_t *pixels, int width, int height);
+void nst_shmout_audio(const int16_t *samples, int frames);
+
+#endif
@@ -0,0 +1,402 @@
+/*
+ * Nestopia UE
+ *
+ * Copyright (C) 2012-2018 R. Danbrook
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ *
+ */
+
+// Test ROM runner: every ROM under a directory is run headlessly until it
+// reports a result or runs out of frames. The ROMs are shared out between
+// worker threads, each running one emulator at a time with its homebrew
+// ports captured, so the exit port ends the test rather than the process.
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#include <SDL.h>
+
+#include "nstcommon.h"
+#include "config.h"
+#include "testrom.h"
+
+#include "core/api/NstApiCheats.hpp"
+#include "core/api/NstApiHomebrew.hpp"
+
+extern Emulator emulator;
+
+enum {
+	TESTROM_PASSED,
+	TESTROM_FAILED,
+	TESTROM_TIMEOUT,
+	TESTROM_ERROR
+};
+
+typedef struct {
+	std::string path;
+	std::string name; // Path relative to the directory
+	int status;
+	unsigned int code; // Exit code or blargg result
+	const char *error;
+	std::string output;
+	unsigned long frames;
+	double seconds;
+} testrom_entry_t;
+
+typedef struct {
+	std::vector<testrom_entry_t> entries;
+	int frames;
+	SDL_atomic_t next;
+} testrom_t;
+
+static double nst_testrom_time() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1000000000.0;
+}
+
+static bool nst_testrom_is_rom(const std::string& name) {
+	static const char *exts[] = { ".nes", ".unf", ".unif" };
+
+	for (size_t i = 0; i < sizeof(exts) / sizeof(exts[0]); i++) {
+		size_t len = strlen(exts[i]);
+		if (name.size() > len && !strcasecmp(name.c_str() + name.size() - len, exts[i])) { return true; }
+	}
+
+	return false;
+}
+
+static void nst_testrom_scan(std::vector<testrom_entry_t>& entries, const std::string& dir, const std::string& prefix) {
+	// Find the ROMs under a directory, in a stable order
+	DIR *dp = opendir(dir.c_str());
+	if (!dp) { return; }
+
+	std::vector<std::string> names;
+
+	while (struct dirent *de = readdir(dp)) {
+		if (de->d_name[0] != '.') { names.push_back(de->d_name); }
+	}
+
+	closedir(dp);
+	std::sort(names.begin(), names.end());
+
+	for (size_t i = 0; i < names.size(); i++) {
+		std::string path = dir + "/" + names[i];
+		struct stat st;
+
+		if (stat(path.c_str(), &st)) { continue; }
+
+		if (S_ISDIR(st.st_mode)) {
+			nst_testrom_scan(entries, path, prefix + names[i] + "/");
+		}
+		else if (nst_testrom_is_rom(names[i])) {
+			testrom_entry_t entry;
+			entry.path = path;
+			entry.name = prefix + names[i];
+			entry.status = TESTROM_ERROR;
+			entry.code = 0;
+			entry.error = NULL;
+			entry.frames = 0;
+			entry.seconds = 0;
+			entries.push_back(entry);
+		}
+	}
+}
+
+static bool nst_testrom_blargg(Cheats& cheats) {
+	// The signature is only there once the test has started
+	return cheats.Peek(0x6001) == 0xde && cheats.Peek(0x6002) == 0xb0 && cheats.Peek(0x6003) == 0x61;
+}
+
+static void nst_testrom_one(testrom_t *t, testrom_entry_t *entry) {
+	// Run a test ROM until it reports a result
+	Emulator emu;
+	Machine machine(emu);
+	Homebrew homebrew(emu);
+	Cheats cheats(emu);
+	std::ostringstream output;
+
+	if (Cartridge::Database(emulator).IsLoaded()) { Cartridge::Database(emu).Share(emulator); }
+
+	std::ifstream rom(entry->path.c_str(), std::ifstream::in|std::ifstream::binary);
+
+	if (!rom.is_open() || NES_FAILED(machine.Load(rom, nst_default_system()))) {
+		entry->error = "could not load ROM";
+		return;
+	}
+
+	homebrew.Capture(&output);
+	if (conf.misc_homebrew_exit != -1) { homebrew.SetExitPort(conf.misc_homebrew_exit); }
+	if (conf.misc_homebrew_stdout != -1) { homebrew.SetStdOutPort(conf.misc_homebrew_stdout); }
+	if (conf.misc_homebrew_stderr != -1) { homebrew.SetStdErrPort(conf.misc_homebrew_stderr); }
+
+	machine.SetRamPowerState(conf.misc_power_state);
+	machine.Power(true);
+
+	int resetin = -1;
+	double start = nst_testrom_time();
+
+	entry->status = TESTROM_TIMEOUT;
+
+	for (entry->frames = 0; entry->frames < (unsigned long)t->frames; ) {
+		if (NES_FAILED(emu.Execute(NULL, NULL, NULL))) {
+			entry->status = TESTROM_ERROR;
+			entry->error = "emulation failed";
+			break;
+		}
+
+		entry->frames++;
+
+		if (homebrew.GetExitCode(entry->code)) {
+			entry->status = entry->code ? TESTROM_FAILED : TESTROM_PASSED;
+			break;
+		}
+
+		if (!nst_testrom_blargg(cheats)) { continue; }
+
+		unsigned int status = cheats.Peek(0x6000);
+
+		if (status < 0x80) {
+			// Done, the text explains the result
+			std::string text;
+
+			for (unsigned int i = 0; i < TESTROM_TEXT_MAX; i++) {
+				char c = cheats.Peek(0x6004 + i);
+				if (!c) { break; }
+				text += c;
+			}
+
+			output << text;
+			entry->code = status;
+			entry->status = status ? TESTROM_FAILED : TESTROM_PASSED;
+			break;
+		}
+		else if (status == 0x81 && resetin < 0) {
+			// The reset must come at least 100 ms after the request
+			resetin = TESTROM_RESET_DELAY;
+		}
+
+		if (resetin >= 0 && resetin-- == 0) {
+			machine.Reset(false);
+		}
+	}
+
+	entry->seconds = nst_testrom_time() - start;
+	entry->output = output.str();
+
+	homebrew.Capture(NULL);
+}
+
+static int nst_testrom_worker(void *data) {
+	// Worker thread, takes ROMs off the list until none are left
+	testrom_t *t = (testrom_t*)data;
+
+	while (1) {
+		int i = SDL_AtomicAdd(&t->next, 1);
+		if (i >= (int)t->entries.size()) { break; }
+		nst_testrom_one(t, &t->entries[i]);
+	}
+
+	return 0;
+}
+
+static void nst_testrom_json_string(FILE *fp, const std::string& str) {
+	// Write out a JSON string
+	fputc('"', fp);
+
+	for (size_t i = 0; i < str.size(); i++) {
+		unsigned char c = str[i];
+		if (c == '"' || c == '\\') { fprintf(fp, "\\%c", c); }
+		else if (c == '\n') { fprintf(fp, "\\n"); }
+		else if (c < 0x20 || c >= 0x7f) { fprintf(fp, "\\u%04x", c); }
+		else { fputc(c, fp); }
+	}
+
+	fputc('"', fp);
+}
+
+static void nst_testrom_xml_string(FILE *fp, const std::string& str) {
+	// Write out XML text, leaving out what XML 1.0 can't hold
+	for (size_t i = 0; i < str.size(); i++) {
+		unsigned char c = str[i];
+		if (c == '&') { fprintf(fp, "&amp;"); }
+		else if (c == '<') { fprintf(fp, "&lt;"); }
+		else if (c == '>') { fprintf(fp, "&gt;"); }
+		else if (c == '"') { fprintf(fp, "&quot;"); }
+		else if (c >= 0x20 && c < 0x7f) { fputc(c, fp); }
+		else if (c == '\n' || c == '\t') { fputc(c, fp); }
+	}
+}
+
+static void nst_testrom_result(const testrom_entry_t *entry, char *buf, size_t size) {
+	// One line description of the result
+	switch (entry->status) {
+		case TESTROM_PASSED: snprintf(buf, size, "passed"); break;
+		case TESTROM_FAILED: snprintf(buf, size, "failed with code %u", entry->code); break;
+		case TESTROM_TIMEOUT: snprintf(buf, size, "no result after %lu frames", entry->frames); break;
+		default: snprintf(buf, size, "%s", entry->error ? entry->error : "error"); break;
+	}
+}
+
+static void nst_testrom_json(FILE *fp, testrom_t *t, const char *dir, int *counts) {
+	// Write out the report as JSON
+	static const char *statuses[] = { "passed", "failed", "timeout", "error" };
+
+	fprintf(fp, "{\n  \"dir\": ");
+	nst_testrom_json_string(fp, dir);
+	fprintf(fp, ",\n  \"frames\": %d,\n", t->frames);
+	fprintf(fp, "  \"passed\": %d,\n  \"failed\": %d,\n  \"timeouts\": %d,\n  \"errors\": %d,\n",
+		counts[TESTROM_PASSED], counts[TESTROM_FAILED], counts[TESTROM_TIMEOUT], counts[TESTROM_ERROR]);
+	fprintf(fp, "  \"tests\": [");
+
+	for (size_t i = 0; i < t->entries.size(); i++) {
+		testrom_entry_t *entry = &t->entries[i];
+
+		fprintf(fp, "%s\n    {\"name\": ", i ? "," : "");
+		nst_testrom_json_string(fp, entry->name);
+		fprintf(fp, ", \"status\": \"%s\"", statuses[entry->status]);
+
+		if (entry->status == TESTROM_ERROR) {
+			fprintf(fp, ", \"error\": \"%s\"}", entry->error);
+			continue;
+		}
+
+		fprintf(fp, ", \"code\": %u, \"frames\": %lu, \"fps\": %.1f, \"output\": ",
+			entry->code, entry->frames, entry->seconds > 0 ? entry->frames / entry->seconds : 0);
+		nst_testrom_json_string(fp, entry->output);
+		fprintf(fp, "}");
+	}
+
+	fprintf(fp, "\n  ]\n}\n");
+}
+
+static void nst_testrom_junit(FILE *fp, testrom_t *t, const char *dir, int *counts) {
+	// Write out the report as JUnit XML, timeouts count as failures
+	double seconds = 0;
+	for (size_t i = 0; i < t->entries.size(); i++) { seconds += t->entries[i].seconds; }
+
+	fprintf(fp, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+	fprintf(fp, "<testsuite name=\"");
+	nst_testrom_xml_string(fp, dir);
+	fprintf(fp, "\" tests=\"%d\" failures=\"%d\" errors=\"%d\" time=\"%.3f\">\n",
+		(int)t->entries.size(), counts[TESTROM_FAILED] + counts[TESTROM_TIMEOUT], counts[TESTROM_ERROR], seconds);
+
+	for (size_t i = 0; i < t->entries.size(); i++) {
+		testrom_entry_t *entry = &t->entries[i];
+		char result[64];
+
+		nst_testrom_result(entry, result, sizeof(result));
+
+		fprintf(fp, "  <testcase classname=\"testrom\" name=\"");
+		nst_testrom_xml_string(fp, entry->name);
+		fprintf(fp, "\" time=\"%.3f\">\n", entry->seconds);
+
+		if (entry->status == TESTROM_FAILED || entry->status == TESTROM_TIMEOUT) {
+			fprintf(fp, "    <failure message=\"%s\"/>\n", result);
+		}
+		else if (entry->status == TESTROM_ERROR) {
+			fprintf(fp, "    <error message=\"%s\"/>\n", result);
+		}
+
+		if (!entry->output.empty()) {
+			fprintf(fp, "    <system-out>");
+			nst_testrom_xml_string(fp, entry->output);
+			fprintf(fp, "</system-out>\n");
+		}
+
+		fprintf(fp, "  </testcase>\n");
+	}
+
+	fprintf(fp, "</testsuite>\n");
+}
+
+bool nst_testrom_run(const testrom_conf_t *tconf) {
+	// Run every test ROM under the directory and write out a report
+	testrom_t t;
+	std::string dir(tconf->dir);
+
+	while (dir.size() > 1 && dir[dir.size() - 1] == '/') { dir.erase(dir.size() - 1); }
+
+	nst_testrom_scan(t.entries, dir, "");
+
+	if (t.entries.empty()) {
+		fprintf(stderr, "Test ROMs: none found in %s\n", tconf->dir);
+		return false;
+	}
+
+	t.frames = tconf->frames > 0 ? tconf->frames : TESTROM_FRAMES;
+
+	nst_db_load();
+
+	int jobs = tconf->jobs > 0 ? tconf->jobs : SDL_GetCPUCount();
+	if (jobs > (int)t.entries.size()) { jobs = t.entries.size(); }
+
+	SDL_AtomicSet(&t.next, 0);
+
+	std::vector<SDL_Thread*> workers;
+
+	for (int i = 0; i < jobs; i++) {
+		char name[32];
+		snprintf(name, sizeof(name), "testrom%d", i);
+		SDL_Thread *worker = SDL_CreateThread(nst_testrom_worker, name, &t);
+		if (worker) { workers.push_back(worker); }
+	}
+
+	// Carry on here if no threads could be started at all
+	if (workers.empty()) { nst_testrom_worker(&t); }
+
+	for (size_t i = 0; i < workers.size(); i++) { SDL_WaitThread(workers[i], NULL); }
+
+	int counts[4] = { 0, 0, 0, 0 };
+
+	for (size_t i = 0; i < t.entries.size(); i++) {
+		char result[64];
+		nst_testrom_result(&t.entries[i], result, sizeof(result));
+		fprintf(stderr, "Test ROMs: %s %s\n", t.entries[i].name.c_str(), result);
+		counts[t.entries[i].status]++;
+	}
+
+	fprintf(stderr, "Test ROMs: %d passed, %d failed, %d timed out, %d errors\n",
+		counts[TESTROM_PASSED], counts[TESTROM_FAILED], counts[TESTROM_TIMEOUT], counts[TESTROM_ERROR]);
+
+	FILE *fp = tconf->report ? fopen(tconf->report, "w") : stdout;
+
+	if (!fp) {
+		fprintf(stderr, "Test ROMs: could not write %s\n", tconf->report);
+		return false;
+	}
+
+	size_t len = tconf->report ? strlen(tconf->report) : 0;
+
+	if (len > 4 && !strcasecmp(tconf->report + len - 4, ".xml")) { nst_testrom_junit(fp, &t, tconf->dir, counts); }
+	else { nst_testrom_json(fp, &t, tconf->dir, counts); }
+
+	if (fp != stdout) { fclose(fp); }
+
+	return counts[TESTROM_PASSED] == (int)t.entries.size();
+}
@@ -0,0 +1,22 @@
+#ifndef _TESTROM_H_
+#define _TESTROM_H_
+
+#define TESTROM_FRAMES 7200 // Give up on a test after two minutes at 60 fps
+#define TESTROM_RESET_DELAY 10 // Frames between a test asking for a reset and the reset
+#define TESTROM_TEXT_MAX 0x1ffc // Room for text from $6004 to the end of W-RAM
+
+// Test ROMs report either through the blargg protocol, with the status at
+// $6000, the signature DE B0 61 at $6001 and text from $6004, or through the
+// homebrew exit port if one is set in the configuration. Anything written to
+// the homebrew standard out and standard error ports is collected as well.
+
+typedef struct {
+	const char *dir;
+	const char *report; // JSON report file, JUnit if it ends in .xml, NULL for stdout
+	int jobs; // Worker threads, 0 for one per CPU
+	int frames; // Timeout in frames, 0 for TESTROM_FRAMES
+} testrom_conf_t;
+
+bool nst_testrom_run(const testrom_conf_t *tconf);
+
+#endif
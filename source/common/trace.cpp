@@ -0,0 +1,232 @@
+/*
+ * Nestopia UE
+ *
+ * Copyright (C) 2012-2018 R. Danbrook
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ *
+ */
+
+// CPU traces: a ROM is run headlessly with the core's tracer recording, then
+// the trace is saved. Saved traces can be decoded to text, or two of them
+// walked side by side to find the first instruction where they part ways,
+// e.g. to see where a fast path stops agreeing with the reference one.
+
+#include <fstream>
+
+#include <stdio.h>
+#include <string.h>
+
+#include "nstcommon.h"
+#include "config.h"
+#include "trace.h"
+
+#include "core/api/NstApiTracer.hpp"
+
+extern Emulator emulator;
+
+static const char *mnemonics[256] = {
+	"BRK", "ORA", "KIL", "SLO", "NOP", "ORA", "ASL", "SLO", "PHP", "ORA", "ASL", "ANC", "NOP", "ORA", "ASL", "SLO",
+	"BPL", "ORA", "KIL", "SLO", "NOP", "ORA", "ASL", "SLO", "CLC", "ORA", "NOP", "SLO", "NOP", "ORA", "ASL", "SLO",
+	"JSR", "AND", "KIL", "RLA", "BIT", "AND", "ROL", "RLA", "PLP", "AND", "ROL", "ANC", "BIT", "AND", "ROL", "RLA",
+	"BMI", "AND", "KIL", "RLA", "NOP", "AND", "ROL", "RLA", "SEC", "AND", "NOP", "RLA", "NOP", "AND", "ROL", "RLA",
+	"RTI", "EOR", "KIL", "SRE", "NOP", "EOR", "LSR", "SRE", "PHA", "EOR", "LSR", "ALR", "JMP", "EOR", "LSR", "SRE",
+	"BVC", "EOR", "KIL", "SRE", "NOP", "EOR", "LSR", "SRE", "CLI", "EOR", "NOP", "SRE", "NOP", "EOR", "LSR", "SRE",
+	"RTS", "ADC", "KIL", "RRA", "NOP", "ADC", "ROR", "RRA", "PLA", "ADC", "ROR", "ARR", "JMP", "ADC", "ROR", "RRA",
+	"BVS", "ADC", "KIL", "RRA", "NOP", "ADC", "ROR", "RRA", "SEI", "ADC", "NOP", "RRA", "NOP", "ADC", "ROR", "RRA",
+	"NOP", "STA", "NOP", "SAX", "STY", "STA", "STX", "SAX", "DEY", "NOP", "TXA", "XAA", "STY", "STA", "STX", "SAX",
+	"BCC", "STA", "KIL", "AHX", "STY", "STA", "STX", "SAX", "TYA", "STA", "TXS", "TAS", "SHY", "STA", "SHX", "AHX",
+	"LDY", "LDA", "LDX", "LAX", "LDY", "LDA", "LDX", "LAX", "TAY", "LDA", "TAX", "LAX", "LDY", "LDA", "LDX", "LAX",
+	"BCS", "LDA", "KIL", "LAX", "LDY", "LDA", "LDX", "LAX", "CLV", "LDA", "TSX", "LAS", "LDY", "LDA", "LDX", "LAX",
+	"CPY", "CMP", "NOP", "DCP", "CPY", "CMP", "DEC", "DCP", "INY", "CMP", "DEX", "AXS", "CPY", "CMP", "DEC", "DCP",
+	"BNE", "CMP", "KIL", "DCP", "NOP", "CMP", "DEC", "DCP", "CLD", "CMP", "NOP", "DCP", "NOP", "CMP", "DEC", "DCP",
+	"CPX", "SBC", "NOP", "ISC", "CPX", "SBC", "INC", "ISC", "INX", "SBC", "NOP", "SBC", "CPX", "SBC", "INC", "ISC",
+	"BEQ", "SBC", "KIL", "ISC", "NOP", "SBC", "INC", "ISC", "SED", "SBC", "NOP", "ISC", "NOP", "SBC", "INC", "ISC"
+};
+
+static void nst_trace_format(char *line, size_t size, const Tracer::Entry& entry, unsigned int clock) {
+	// One instruction per line: frame, CPU cycle, scanline, dot, then the CPU
+	snprintf(line, size, "%6lu %6lu %4d %3u  %04X  %02X %s  A:%02X X:%02X Y:%02X S:%02X P:%02X",
+		(unsigned long)entry.frame, (unsigned long)(entry.cycle / clock), entry.scanline, entry.dot,
+		entry.pc, entry.opcode, mnemonics[entry.opcode],
+		entry.a, entry.x, entry.y, entry.sp, entry.p);
+}
+
+static bool nst_trace_open(std::ifstream& file, const char *filename, Tracer::Header& header) {
+	file.open(filename, std::ifstream::in|std::ifstream::binary);
+
+	if (!file.is_open() || NES_FAILED(Tracer::ReadHeader(file, header))) {
+		fprintf(stderr, "Trace: could not read %s\n", filename);
+		return false;
+	}
+
+	if (!header.clock) { header.clock = 1; }
+	return true;
+}
+
+bool nst_trace_record(const trace_conf_t *trconf) {
+	// Run the ROM with the tracer on and save what it caught
+	Emulator emu;
+	Machine machine(emu);
+	Tracer tracer(emu);
+
+	nst_db_load();
+	if (Cartridge::Database(emulator).IsLoaded()) { Cartridge::Database(emu).Share(emulator); }
+
+	std::ifstream rom(trconf->rom, std::ifstream::in|std::ifstream::binary);
+
+	if (!rom.is_open() || NES_FAILED(machine.Load(rom, nst_default_system()))) {
+		fprintf(stderr, "Trace: could not load %s\n", trconf->rom);
+		return false;
+	}
+
+	Input(emu).ConnectController(0, Input::PAD1);
+	Input(emu).ConnectController(1, Input::PAD2);
+
+	Tracer::Trigger trigger;
+
+	if (trconf->pc >= 0) {
+		trigger.type = Tracer::TRIGGER_ADDRESS;
+		trigger.address = trconf->pc;
+	}
+	else if (trconf->frame >= 0) {
+		trigger.type = Tracer::TRIGGER_FRAME;
+		trigger.frame = trconf->frame;
+	}
+
+	if (NES_FAILED(tracer.Start(trconf->size ? trconf->size : (unsigned long)Tracer::DEFAULT_SIZE, trigger, trconf->count))) {
+		fprintf(stderr, "Trace: could not allocate %lu entries\n", trconf->size);
+		return false;
+	}
+
+	machine.SetRamPowerState(0);
+	machine.Power(true);
+
+	Input::Controllers controllers;
+	int frames = trconf->frames > 0 ? trconf->frames : TRACE_FRAMES;
+
+	for (int i = 0; i < frames && tracer.IsRunning(); i++) {
+		if (NES_FAILED(emu.Execute(NULL, NULL, &controllers))) { break; }
+	}
+
+	tracer.Stop();
+
+	if (!tracer.IsTriggered()) {
+		fprintf(stderr, "Trace: the trigger did not fire in %d frames\n", frames);
+		return false;
+	}
+
+	std::ofstream out(trconf->out, std::ofstream::out|std::ofstream::binary);
+
+	if (!out.is_open() || NES_FAILED(tracer.Save(out))) {
+		fprintf(stderr, "Trace: could not write %s\n", trconf->out);
+		return false;
+	}
+
+	fprintf(stderr, "Trace: %lu instructions written to %s\n", tracer.NumEntries(), trconf->out);
+	return true;
+}
+
+bool nst_trace_decode(const char *filename) {
+	// Print the trace as text, oldest instruction first
+	std::ifstream file;
+	Tracer::Header header;
+
+	if (!nst_trace_open(file, filename, header)) { return false; }
+
+	printf("# %lu instructions\n", (unsigned long)header.count);
+	printf("# frame  cycle line dot  pc    op       registers\n");
+
+	for (unsigned long i = 0; i < header.count; i++) {
+		Tracer::Entry entry;
+		char line[96];
+
+		if (NES_FAILED(Tracer::ReadEntry(file, entry))) {
+			fprintf(stderr, "Trace: %s is cut short after %lu instructions\n", filename, i);
+			return false;
+		}
+
+		nst_trace_format(line, sizeof(line), entry, header.clock);
+		printf("%s\n", line);
+	}
+
+	return true;
+}
+
+int nst_trace_diff(const char *filename1, const char *filename2) {
+	// Walk both traces until an instruction differs in any field
+	std::ifstream file1, file2;
+	Tracer::Header header1, header2;
+
+	if (!nst_trace_open(file1, filename1, header1) || !nst_trace_open(file2, filename2, header2)) { return -1; }
+
+	Tracer::Entry context[TRACE_CONTEXT];
+	unsigned long count = header1.count < header2.count ? header1.count : header2.count;
+
+	for (unsigned long i = 0; i < count; i++) {
+		Tracer::Entry a, b;
+
+		if (NES_FAILED(Tracer::ReadEntry(file1, a)) || NES_FAILED(Tracer::ReadEntry(file2, b))) {
+			fprintf(stderr, "Trace: a trace is cut short after %lu instructions\n", i);
+			return -1;
+		}
+
+		const char *fields[] = { "frame", "cycle", "pc", "opcode", "a", "x", "y", "sp", "p", "scanline", "dot" };
+		bool differs[] = {
+			a.frame != b.frame, a.cycle / header1.clock != b.cycle / header2.clock, a.pc != b.pc,
+			a.opcode != b.opcode, a.a != b.a, a.x != b.x, a.y != b.y, a.sp != b.sp, a.p != b.p,
+			a.scanline != b.scanline, a.dot != b.dot
+		};
+
+		bool same = true;
+		for (size_t f = 0; f < sizeof(differs) / sizeof(differs[0]); f++) { same = same && !differs[f]; }
+
+		if (same) {
+			context[i % TRACE_CONTEXT] = a;
+			continue;
+		}
+
+		char line[96];
+		printf("Traces differ at instruction %lu\n", i);
+
+		for (unsigned long j = i > TRACE_CONTEXT ? i - TRACE_CONTEXT : 0; j < i; j++) {
+			nst_trace_format(line, sizeof(line), context[j % TRACE_CONTEXT], header1.clock);
+			printf("  %s\n", line);
+		}
+
+		nst_trace_format(line, sizeof(line), a, header1.clock);
+		printf("- %s\n", line);
+		nst_trace_format(line, sizeof(line), b, header2.clock);
+		printf("+ %s\n", line);
+
+		printf("Differs in:");
+		for (size_t f = 0; f < sizeof(differs) / sizeof(differs[0]); f++) {
+			if (differs[f]) { printf(" %s", fields[f]); }
+		}
+		printf("\n");
+
+		return 1;
+	}
+
+	if (header1.count != header2.count) {
+		printf("Traces match for %lu instructions, then %s ends\n", count,
+			header1.count < header2.count ? filename1 : filename2);
+		return 1;
+	}
+
+	printf("Traces match (%lu instructions)\n", count);
+	return 0;
+}
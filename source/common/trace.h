@@ -0,0 +1,26 @@
+#ifndef _TRACE_H_
+#define _TRACE_H_
+
+#define TRACE_FRAMES 600 // Frames to run a ROM for while tracing
+#define TRACE_CONTEXT 8 // Instructions shown before the first divergence
+
+// A trace holds the last instructions the CPU executed before the run ended,
+// or those that followed the trigger when a count is given. Traces are saved
+// in the core's binary format and decoded to one line per instruction, so
+// two decoded traces can also be compared with diff.
+
+typedef struct {
+	const char *rom;
+	const char *out;
+	int frames; // Frames to run, 0 for TRACE_FRAMES
+	unsigned long size; // Entries kept, 0 for the core default
+	unsigned long count; // Entries to record after the trigger, 0 for no limit
+	int pc; // Start at this address, -1 for no address trigger
+	int frame; // Start at this frame, -1 for no frame trigger
+} trace_conf_t;
+
+bool nst_trace_record(const trace_conf_t *trconf);
+bool nst_trace_decode(const char *filename);
+int nst_trace_diff(const char *filename1, const char *filename2); // 0 if equal, 1 if not, -1 on error
+
+#endif
@@ -0,0 +1,437 @@
+/*
+ * Nestopia UE
+ *
+ * Copyright (C) 2012-2018 R. Danbrook
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ *
+ */
+
+// Batch movie verification: every movie in a manifest is played headlessly
+// in its own emulator, without video filtering or sound output, and the
+// final picture and RAM are compared against the hashes in the manifest.
+// The image database and the ROM files are loaded once and only read from
+// by the workers.
+
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <SDL.h>
+#include <zlib.h>
+
+#include "nstcommon.h"
+#include "config.h"
+#include "verify.h"
+
+#include "core/api/NstApiCheats.hpp"
+
+extern settings_t conf;
+extern nstpaths_t nstpaths;
+
+enum {
+	VERIFY_ERROR,
+	VERIFY_NEW,
+	VERIFY_PASS,
+	VERIFY_FAIL
+};
+
+typedef struct {
+	int line; // Line in the manifest
+	std::string moviename;
+	std::string romname;
+	std::string movie;
+	const std::string *rom; // Shared ROM image, NULL if it could not be read
+	bool baseline; // Manifest has hashes to compare against
+	unsigned int framehash;
+	unsigned int ramhash;
+
+	// Results, only written by the worker that took the entry
+	int status;
+	const char *error;
+	unsigned long frames;
+	double seconds;
+	unsigned int gotframe;
+	unsigned int gotram;
+} verify_entry_t;
+
+typedef struct {
+	std::vector<verify_entry_t> entries;
+	std::map<std::string, std::string> roms;
+	Emulator *database; // Holds the image database shared by all workers
+	SDL_atomic_t next;
+} verify_t;
+
+// Reads straight from a ROM image in memory so workers can share it
+class verify_membuf : public std::streambuf {
+public:
+	verify_membuf(const std::string& data) {
+		char *begin = const_cast<char*>(data.data());
+		setg(begin, begin, begin + data.size());
+	}
+
+protected:
+	pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) {
+		char *pos;
+
+		if (dir == std::ios_base::beg) { pos = eback() + off; }
+		else if (dir == std::ios_base::cur) { pos = gptr() + off; }
+		else { pos = egptr() + off; }
+
+		if (!(which & std::ios_base::in) || pos < eback() || pos > egptr()) { return pos_type(off_type(-1)); }
+
+		setg(eback(), pos, egptr());
+		return pos_type(off_type(pos - eback()));
+	}
+
+	pos_type seekpos(pos_type pos, std::ios_base::openmode which) {
+		return seekoff(off_type(pos), std::ios_base::beg, which);
+	}
+};
+
+static double nst_verify_time() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1000000000.0;
+}
+
+static std::string nst_verify_path(const std::string& dir, const std::string& path) {
+	// Paths in the manifest are relative to the manifest itself
+	if (path.empty() || path[0] == '/') { return path; }
+	return dir + path;
+}
+
+static Emulator* nst_verify_database() {
+	// Load the image database once for all workers to share
+	const char *dirs[3] = { nstpaths.nstdir, DATADIR "/", getenv("PWD") };
+
+	for (int i = 0; i < 3; i++) {
+		if (!dirs[i]) { continue; }
+
+		std::string dbpath = std::string(dirs[i]) + (i == 2 ? "/" : "") + "NstDatabase.xml";
+		std::ifstream dbfile(dbpath.c_str(), std::ifstream::in|std::ifstream::binary);
+
+		if (dbfile.is_open()) {
+			Emulator *emu = new Emulator;
+			Cartridge::Database database(*emu);
+
+			if (NES_SUCCEEDED(database.Load(dbfile)) && NES_SUCCEEDED(database.Enable(true))) { return emu; }
+
+			delete emu;
+		}
+	}
+
+	fprintf(stderr, "Verify: NstDatabase.xml not found, running without it\n");
+	return NULL;
+}
+
+static bool nst_verify_manifest(verify_t *v, const char *filename, std::vector<std::string>& lines) {
+	// Read the manifest and every ROM it refers to
+	std::ifstream manifest(filename, std::ifstream::in);
+
+	if (!manifest.is_open()) {
+		fprintf(stderr, "Verify: could not open %s\n", filename);
+		return false;
+	}
+
+	std::string dir(filename);
+	dir = dir.find('/') == std::string::npos ? "" : dir.substr(0, dir.rfind('/') + 1);
+
+	std::string line;
+
+	while (std::getline(manifest, line)) {
+		lines.push_back(line);
+
+		std::istringstream fields(line);
+		std::string framehash, ramhash;
+		verify_entry_t entry;
+
+		if (!(fields >> entry.moviename) || entry.moviename[0] == '#') { continue; }
+
+		if (!(fields >> entry.romname)) {
+			fprintf(stderr, "Verify: no ROM for %s on line %d\n", entry.moviename.c_str(), (int)lines.size());
+			return false;
+		}
+
+		entry.line = lines.size() - 1;
+		entry.movie = nst_verify_path(dir, entry.moviename);
+		entry.baseline = (bool)(fields >> framehash >> ramhash);
+		entry.framehash = entry.baseline ? strtoul(framehash.c_str(), NULL, 16) : 0;
+		entry.ramhash = entry.baseline ? strtoul(ramhash.c_str(), NULL, 16) : 0;
+		entry.status = VERIFY_ERROR;
+		entry.error = NULL;
+		entry.frames = 0;
+		entry.seconds = 0;
+		entry.gotframe = entry.gotram = 0;
+
+		std::string rompath = nst_verify_path(dir, entry.romname);
+		std::map<std::string, std::string>::iterator rom = v->roms.find(rompath);
+
+		if (rom == v->roms.end()) {
+			std::ifstream romfile(rompath.c_str(), std::ifstream::in|std::ifstream::binary);
+			rom = v->roms.insert(std::make_pair(rompath, std::string())).first;
+
+			if (romfile.is_open()) {
+				rom->second.assign((std::istreambuf_iterator<char>(romfile)), std::istreambuf_iterator<char>());
+			}
+		}
+
+		entry.rom = rom->second.empty() ? NULL : &rom->second;
+		v->entries.push_back(entry);
+	}
+
+	return true;
+}
+
+static void nst_verify_movie(verify_t *v, verify_entry_t *entry) {
+	// Play one movie through to the end in a private emulator
+	Emulator emu;
+	Machine machine(emu);
+	Movie movie(emu);
+
+	if (!entry->rom) {
+		entry->error = "could not read ROM";
+		return;
+	}
+
+	if (v->database) { Cartridge::Database(emu).Share(*v->database); }
+
+	double start = nst_verify_time();
+
+	verify_membuf rombuf(*entry->rom);
+	std::istream rom(&rombuf);
+
+	if (NES_FAILED(machine.Load(rom, nst_default_system()))) {
+		entry->error = "could not load ROM";
+		return;
+	}
+
+	machine.SetRamPowerState(conf.misc_power_state);
+	machine.Power(true);
+
+	std::ifstream moviefile(entry->movie.c_str(), std::ifstream::in|std::ifstream::binary);
+
+	if (!moviefile.is_open()) {
+		entry->error = "could not open movie";
+		return;
+	}
+
+	Nes::Result result = movie.Play(moviefile);
+
+	if (result == Nes::RESULT_ERR_WRONG_MODE) {
+		// Recorded in the other region
+		machine.SetMode(machine.GetMode() == Machine::NTSC ? Machine::PAL : Machine::NTSC);
+		moviefile.clear();
+		moviefile.seekg(0);
+		result = movie.Play(moviefile);
+	}
+
+	if (NES_FAILED(result)) {
+		entry->error = "could not play movie";
+		return;
+	}
+
+	while (movie.IsPlaying() && entry->frames < VERIFY_MAX_FRAMES) {
+		if (NES_FAILED(emu.Execute(NULL, NULL, NULL))) {
+			entry->error = "emulation failed";
+			return;
+		}
+		entry->frames++;
+	}
+
+	if (movie.IsPlaying()) {
+		entry->error = "movie too long";
+		return;
+	}
+
+	entry->seconds = nst_verify_time() - start;
+
+	// Hash the picture as 16 bit little endian palette indices
+	std::vector<unsigned short> pixels(Video::Output::WIDTH * Video::Output::HEIGHT);
+	std::vector<unsigned char> bytes(pixels.size() * 2);
+
+	Video(emu).GetPixels(&pixels[0]);
+
+	for (size_t i = 0; i < pixels.size(); i++) {
+		bytes[i * 2] = pixels[i] & 0xff;
+		bytes[i * 2 + 1] = pixels[i] >> 8;
+	}
+
+	entry->gotframe = crc32(0, &bytes[0], bytes.size());
+	entry->gotram = crc32(0, Cheats(emu).GetRam(), Cheats::RAM_SIZE);
+
+	if (!entry->baseline) { entry->status = VERIFY_NEW; }
+	else if (entry->gotframe == entry->framehash && entry->gotram == entry->ramhash) { entry->status = VERIFY_PASS; }
+	else { entry->status = VERIFY_FAIL; }
+}
+
+static int nst_verify_worker(void *data) {
+	// Worker thread, takes movies off the list until none are left
+	verify_t *v = (verify_t*)data;
+
+	while (true) {
+		int i = SDL_AtomicAdd(&v->next, 1);
+		if (i >= (int)v->entries.size()) { break; }
+		nst_verify_movie(v, &v->entries[i]);
+	}
+
+	return 0;
+}
+
+static void nst_verify_string(FILE *fp, const std::string& str) {
+	// Write out a JSON string
+	fputc('"', fp);
+
+	for (size_t i = 0; i < str.size(); i++) {
+		unsigned char c = str[i];
+		if (c == '"' || c == '\\') { fprintf(fp, "\\%c", c); }
+		else if (c < 0x20) { fprintf(fp, "\\u%04x", c); }
+		else { fputc(c, fp); }
+	}
+
+	fputc('"', fp);
+}
+
+static void nst_verify_report(FILE *fp, verify_t *v, const verify_conf_t *vconf, int jobs, double seconds) {
+	// Write out the JSON report
+	static const char *statuses[] = { "error", "new", "pass", "fail" };
+	int count[4] = { 0, 0, 0, 0 };
+
+	for (size_t i = 0; i < v->entries.size(); i++) { count[v->entries[i].status]++; }
+
+	fprintf(fp, "{\n  \"manifest\": ");
+	nst_verify_string(fp, vconf->manifest);
+	fprintf(fp, ",\n  \"jobs\": %d,\n  \"seconds\": %.3f,\n", jobs, seconds);
+	fprintf(fp, "  \"passed\": %d,\n  \"failed\": %d,\n  \"new\": %d,\n  \"errors\": %d,\n",
+		count[VERIFY_PASS], count[VERIFY_FAIL], count[VERIFY_NEW], count[VERIFY_ERROR]);
+	fprintf(fp, "  \"movies\": [");
+
+	for (size_t i = 0; i < v->entries.size(); i++) {
+		verify_entry_t *entry = &v->entries[i];
+
+		fprintf(fp, "%s\n    {\"movie\": ", i ? "," : "");
+		nst_verify_string(fp, entry->moviename);
+		fprintf(fp, ", \"rom\": ");
+		nst_verify_string(fp, entry->romname);
+		fprintf(fp, ", \"status\": \"%s\"", statuses[entry->status]);
+
+		if (entry->status == VERIFY_ERROR) {
+			fprintf(fp, ", \"error\": \"%s\"}", entry->error);
+			continue;
+		}
+
+		fprintf(fp, ", \"frames\": %lu, \"seconds\": %.3f, \"fps\": %.1f",
+			entry->frames, entry->seconds, entry->seconds > 0 ? entry->frames / entry->seconds : 0.0);
+		fprintf(fp, ", \"framehash\": \"%08x\", \"ramhash\": \"%08x\"", entry->gotframe, entry->gotram);
+		fprintf(fp, ", \"mismatches\": [");
+
+		if (entry->status == VERIFY_FAIL) {
+			bool frame = entry->gotframe != entry->framehash;
+			bool ram = entry->gotram != entry->ramhash;
+			fprintf(fp, "%s%s%s", frame ? "\"frame\"" : "", frame && ram ? ", " : "", ram ? "\"ram\"" : "");
+		}
+
+		fprintf(fp, "]}");
+	}
+
+	fprintf(fp, "\n  ]\n}\n");
+}
+
+static bool nst_verify_update(verify_t *v, const char *filename, std::vector<std::string>& lines) {
+	// Put the hashes of this run into the manifest
+	for (size_t i = 0; i < v->entries.size(); i++) {
+		verify_entry_t *entry = &v->entries[i];
+		if (entry->status == VERIFY_ERROR) { continue; }
+
+		char hashes[32];
+		snprintf(hashes, sizeof(hashes), " %08x %08x", entry->gotframe, entry->gotram);
+		lines[entry->line] = entry->moviename + " " + entry->romname + hashes;
+	}
+
+	std::ofstream manifest(filename, std::ofstream::out|std::ofstream::trunc);
+	if (!manifest.is_open()) { return false; }
+
+	for (size_t i = 0; i < lines.size(); i++) { manifest << lines[i] << "\n"; }
+
+	return manifest.good();
+}
+
+bool nst_verify_run(const verify_conf_t *vconf) {
+	// Verify every movie in the manifest and write out a report
+	verify_t v;
+	std::vector<std::string> lines;
+
+	if (!nst_verify_manifest(&v, vconf->manifest, lines)) { return false; }
+
+	int jobs = vconf->jobs > 0 ? vconf->jobs : SDL_GetCPUCount();
+	if (jobs > (int)v.entries.size()) { jobs = v.entries.size(); }
+	if (jobs < 1) { jobs = 1; }
+
+	v.database = nst_verify_database();
+	SDL_AtomicSet(&v.next, 0);
+
+	double start = nst_verify_time();
+
+	std::vector<SDL_Thread*> workers;
+
+	for (int i = 0; i < jobs; i++) {
+		char name[16];
+		snprintf(name, sizeof(name), "verify%d", i);
+		SDL_Thread *worker = SDL_CreateThread(nst_verify_worker, name, &v);
+		if (worker) { workers.push_back(worker); }
+	}
+
+	// Carry on here if no threads could be started at all
+	if (workers.empty()) { nst_verify_worker(&v); }
+
+	for (size_t i = 0; i < workers.size(); i++) { SDL_WaitThread(workers[i], NULL); }
+
+	double seconds = nst_verify_time() - start;
+
+	delete v.database;
+
+	FILE *fp = vconf->report ? fopen(vconf->report, "w") : stdout;
+
+	if (!fp) {
+		fprintf(stderr, "Verify: could not write %s\n", vconf->report);
+		return false;
+	}
+
+	nst_verify_report(fp, &v, vconf, workers.empty() ? 1 : workers.size(), seconds);
+	if (fp != stdout) { fclose(fp); }
+
+	if (vconf->update && !nst_verify_update(&v, vconf->manifest, lines)) {
+		fprintf(stderr, "Verify: could not update %s\n", vconf->manifest);
+		return false;
+	}
+
+	// Mismatches are expected when updating, only errors count then
+	bool passed = true;
+	for (size_t i = 0; i < v.entries.size(); i++) {
+		if (v.entries[i].status == VERIFY_ERROR) { passed = false; }
+		if (v.entries[i].status == VERIFY_FAIL && !vconf->update) { passed = false; }
+	}
+
+	return passed;
+}
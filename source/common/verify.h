@@ -0,0 +1,19 @@
+#ifndef _VERIFY_H_
+#define _VERIFY_H_
+
+#define VERIFY_MAX_FRAMES 5184000 // Give up on movies longer than a day at 60 fps
+
+// The manifest lists one movie per line as "movie rom [framehash ramhash]",
+// relative paths are taken from the directory of the manifest. Lines that
+// are empty or start with '#' are skipped.
+
+typedef struct {
+	const char *manifest;
+	const char *report; // JSON report file, NULL for stdout
+	int jobs; // Worker threads, 0 for one per CPU
+	bool update; // Write the hashes of this run back to the manifest
+} verify_conf_t;
+
+bool nst_verify_run(const verify_conf_t *vconf);
+
+#endif
@@ -23,8 +23,11 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
+#include <SDL.h>
+
 #include "core/api/NstApiEmulator.hpp"
 #include "core/api/NstApiInput.hpp"
 #include "core/api/NstApiVideo.hpp"
@@ -34,13 +37,20 @@
 #include "video.h"
 #include "config.h"
 #include "font.h"
-#include "png.h"
+#include "capture.h"
+#include "shmout.h"
 
 using namespace Nes::Api;
 
 static int overscan_offset, overscan_height;
 
-static uint32_t videobuf[VIDBUF_MAXSIZE]; // Maximum possible internal size
+// Triple buffer: the emulator draws into the back buffer and swaps it with
+// the middle one when done, the display swaps the middle one with the front
+// buffer whenever a fresh frame is waiting. Neither side ever waits.
+static uint32_t vidbufs[VIDBUF_COUNT][VIDBUF_MAXSIZE];
+static uint32_t *videobuf = vidbufs[0];
+static int backbuf = 0, frontbuf = 1, lastbuf = 1;
+static SDL_atomic_t midbuf = { 2 };
 
 static Video::RenderState::Filter filter;
 static Video::RenderState renderstate;
@@ -163,7 +173,48 @@ void nst_ogl_deinit() {
 	if (vbo) { glDeleteBuffers(1, &vbo); }
 }
 
+static void video_disp_stats(int xscale, int yscale) {
+	// Display where the time of the last frame went, in microseconds
+	Machine::Stats stats;
+	if (NES_FAILED(Machine(emulator).GetStats(stats))) { return; }
+	
+	unsigned us[Machine::Stats::NUM_SECTIONS];
+	for (int i = 0; i < Machine::Stats::NUM_SECTIONS; i++) { us[i] = stats.time[i] / 1000; }
+	
+	char lines[6][40];
+	snprintf(lines[0], sizeof(lines[0]), "FRAME %u CPU %u PPU %u",
+		(unsigned)stats.frameTime / 1000, us[Machine::Stats::SECTION_CPU], us[Machine::Stats::SECTION_PPU]);
+	snprintf(lines[1], sizeof(lines[1]), "APU %u BLIT %u OTHER %u",
+		us[Machine::Stats::SECTION_APU], us[Machine::Stats::SECTION_BLIT], us[Machine::Stats::SECTION_OTHER]);
+	snprintf(lines[2], sizeof(lines[2]), "VID %u SND %u REW %u MOV %u",
+		us[Machine::Stats::SECTION_VIDEO_LOCK], us[Machine::Stats::SECTION_SOUND_LOCK],
+		us[Machine::Stats::SECTION_REWINDER], us[Machine::Stats::SECTION_MOVIE]);
+	snprintf(lines[3], sizeof(lines[3]), "INS %u BANK %u DMC %u",
+		(unsigned)stats.instructions, (unsigned)stats.bankSwitches, (unsigned)stats.dmcDmas);
+	snprintf(lines[4], sizeof(lines[4]), "IRQ %u NMI %u",
+		(unsigned)stats.irqs, (unsigned)stats.nmis);
+	snprintf(lines[5], sizeof(lines[5]), "PPU R%u W%u APU R%u W%u",
+		(unsigned)stats.reads[Machine::Stats::REGION_PPU], (unsigned)stats.writes[Machine::Stats::REGION_PPU],
+		(unsigned)stats.reads[Machine::Stats::REGION_APU], (unsigned)stats.writes[Machine::Stats::REGION_APU]);
+	
+	for (int i = 0; i < 6; i++) {
+		nst_video_text_draw(lines[i], 8 * xscale, (16 + i * 10) * yscale, true);
+	}
+}
+
+static void video_publish() {
+	// Hand the finished frame over to the display
+	lastbuf = backbuf;
+	backbuf = SDL_AtomicSet(&midbuf, backbuf | VIDBUF_FRESH) & 3;
+	videobuf = vidbufs[backbuf];
+}
+
 void nst_ogl_render() {
+	// Take the newest frame, or show the last one again
+	if (SDL_AtomicGet(&midbuf) & VIDBUF_FRESH) {
+		frontbuf = SDL_AtomicSet(&midbuf, frontbuf) & 3;
+	}
+	
 	// Render the scene
 	glTexImage2D(GL_TEXTURE_2D,
 				0,
@@ -173,7 +224,7 @@ void nst_ogl_render() {
 				0,
 				GL_BGRA,
 				GL_UNSIGNED_BYTE,
-		videobuf + overscan_offset);
+		vidbufs[frontbuf] + overscan_offset);
 	
 	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 	glClear(GL_COLOR_BUFFER_BIT);
@@ -501,6 +552,14 @@ long video_lock_screen(void*& ptr) {
 }
 
 void video_unlock_screen(void*) {
+	// Frame dumps are taken before any text is drawn on top
+	if (nst_capture_dumping()) {
+		nst_capture_frame(videobuf + overscan_offset, basesize.w, overscan_height);
+	}
+	
+	if (nst_shmout_active()) {
+		nst_shmout_video(videobuf + overscan_offset, basesize.w, overscan_height);
+	}
 	
 	int xscale = renderstate.width / Video::Output::WIDTH;;
 	int yscale = renderstate.height / Video::Output::HEIGHT;
@@ -513,51 +572,20 @@ void video_unlock_screen(void*) {
 	if (osdtext.drawtime) {
 		nst_video_text_draw(osdtext.timebuf, 208 * xscale, 218 * yscale, false);
 	}
-}
-
-void video_screenshot_flip(unsigned char *pixels, int width, int height, int bytes) {
-	// Flip the pixels
-	int rowsize = width * bytes;
-	unsigned char *row = (unsigned char*)malloc(rowsize);
-	unsigned char *low = pixels;
-	unsigned char *high = &pixels[(height - 1) * rowsize];
-	
-	for (; low < high; low += rowsize, high -= rowsize) {
-		memcpy(row, low, rowsize);
-		memcpy(low, high, rowsize);
-		memcpy(high, row, rowsize);
-	}
-	free(row);
+	
+	if (conf.timing_stats) { video_disp_stats(xscale, yscale); }
+	
+	video_publish();
 }
 
 void video_screenshot(const char* filename) {
-	// Take a screenshot in .png format
-	unsigned char *pixels;
-	pixels = (unsigned char*)malloc(sizeof(unsigned char) * rendersize.w * rendersize.h * 4);
-	
-	// Read the pixels and flip them vertically
-	glReadPixels(0, 0, rendersize.w, rendersize.h, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
-	video_screenshot_flip(pixels, rendersize.w, rendersize.h, 4);
-	
-	if (filename == NULL) {
-		// Set the filename
-		char sshotpath[512];
-		snprintf(sshotpath, sizeof(sshotpath), "%sscreenshots/%s-%ld-%d.png", nstpaths.nstdir, nstpaths.gamename, time(NULL), rand() % 899 + 100);
-		
-		// Save the file
-		lodepng_encode32_file(sshotpath, (const unsigned char*)pixels, rendersize.w, rendersize.h);
-		fprintf(stderr, "Screenshot: %s\n", sshotpath);
-	}
-	else {
-		lodepng_encode32_file(filename, (const unsigned char*)pixels, rendersize.w, rendersize.h);
-	}
-	
-	free(pixels);
+	// Take a screenshot of the last finished frame in .png format
+	nst_capture_screenshot(filename, vidbufs[lastbuf] + overscan_offset, basesize.w, overscan_height);
 }
 
 void video_clear_buffer() {
-	// Write black to the video buffer
-	memset(videobuf, 0x00000000, VIDBUF_MAXSIZE);
+	// Write black to the video buffers
+	memset(vidbufs, 0x00000000, sizeof(vidbufs));
 }
 
 void video_disp_nsf() {
@@ -575,7 +603,7 @@ void video_disp_nsf() {
 	snprintf(currentsong, sizeof(currentsong), "%d / %d", nsf.GetCurrentSong() +1, nsf.GetNumSongs());
 	nst_video_text_draw(currentsong, 4 * xscale, 52 * yscale, false);
 	
-	nst_ogl_render();
+	video_publish();
 }
 
 void nst_video_disp_inputconf(int type, int pnum, int bnum) {
@@ -607,7 +635,7 @@ void nst_video_disp_inputconf(int type, int pnum, int bnum) {
 	nst_video_text_draw(textbuf, 4 * xscale, 64 * yscale, false);
 	nst_video_text_draw(buttontext, 112 * xscale, 128 * yscale, false);
 	
-	nst_ogl_render();
+	video_publish();
 }
 
 void nst_video_print(const char *text, int xpos, int ypos, int seconds, bool bg) {
@@ -8,7 +8,9 @@
 #define OVERSCAN_BOTTOM 8
 #define OVERSCAN_TOP 8
 
-#define VIDBUF_MAXSIZE 31457280
+#define VIDBUF_MAXSIZE (1024 * 960) // Largest filter output, HqX and xBR at 4x
+#define VIDBUF_COUNT 3 // Back, middle and front buffers
+#define VIDBUF_FRESH 4 // Set on the middle buffer index when it holds an unseen frame
 
 #include <epoxy/gl.h>
 #ifdef _APPLE
@@ -0,0 +1,213 @@
+/*
+ * Nestopia UE
+ *
+ * Copyright (C) 2012-2018 R. Danbrook
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ *
+ */
+
+// Sound recording to .wav. The emulation thread copies each frame's samples
+// into a single producer, single consumer ring and never waits. A worker
+// empties the ring to disk, and when it falls behind whole frames are
+// dropped and counted instead.
+
+#include <string.h>
+
+#include <SDL.h>
+
+#include "nstcommon.h"
+#include "config.h"
+#include "pacer.h"
+#include "wavrec.h"
+
+static int16_t ring[WAVREC_RING_SIZE];
+static SDL_atomic_t ringread, ringwrite;
+static SDL_atomic_t dropped;
+static SDL_atomic_t running;
+
+static SDL_Thread *worker;
+static FILE *wavfile;
+static bool recording = false;
+static int channels;
+static unsigned rate;
+static unsigned frames; // Recorded, emulation thread only
+static unsigned bytes; // Written, worker only while it runs
+static bool full;
+
+static void nst_wav_put(unsigned char *p, unsigned v, int size) {
+	for (int i = 0; i < size; i++) { p[i] = (v >> (i * 8)) & 0xff; }
+}
+
+void nst_wav_header(FILE *file, unsigned rate, int channels, unsigned bytes) {
+	// Canonical 44 byte header for 16-bit PCM
+	unsigned char h[44];
+	memcpy(h, "RIFF\0\0\0\0WAVEfmt ", 16);
+	nst_wav_put(h + 4, 36 + bytes, 4);
+	nst_wav_put(h + 16, 16, 4);
+	nst_wav_put(h + 20, 1, 2);
+	nst_wav_put(h + 22, channels, 2);
+	nst_wav_put(h + 24, rate, 4);
+	nst_wav_put(h + 28, rate * channels * 2, 4);
+	nst_wav_put(h + 32, channels * 2, 2);
+	nst_wav_put(h + 34, 16, 2);
+	memcpy(h + 36, "data", 4);
+	nst_wav_put(h + 40, bytes, 4);
+	fwrite(h, 1, sizeof(h), file);
+}
+
+unsigned nst_wav_rate(unsigned bytes, int channels, unsigned frames, bool pal) {
+	// Each frame carries a whole number of samples, so the sound actually ran
+	// a little off the nominal rate. Declare the real one to keep the pitch.
+	double seconds = frames * (pal ? PACER_PERIOD_PAL : PACER_PERIOD_NTSC) / 1e9;
+	return (unsigned)((double)bytes / 2 / channels / seconds + 0.5);
+}
+
+static void nst_wavrec_drain() {
+	// Write out everything in the ring
+	unsigned read = SDL_AtomicGet(&ringread);
+	unsigned write = SDL_AtomicGet(&ringwrite);
+	unsigned char le[4096 * 2];
+
+	while (read != write) {
+		unsigned count = write - read;
+		if (count > sizeof(le) / 2) { count = sizeof(le) / 2; }
+
+		for (unsigned i = 0; i < count; i++) {
+			nst_wav_put(le + i * 2, (uint16_t)ring[(read + i) & (WAVREC_RING_SIZE - 1)], 2);
+		}
+
+		if (bytes + count * 2 > WAVREC_MAX_BYTES) {
+			if (!full) { fprintf(stderr, "Audio recording: file is full, the rest is not recorded\n"); }
+			full = true;
+		}
+		else if (fwrite(le, 2, count, wavfile) != count) {
+			if (!full) { fprintf(stderr, "Audio recording: write failed\n"); }
+			full = true;
+		}
+		else {
+			bytes += count * 2;
+		}
+
+		read += count;
+		SDL_AtomicSet(&ringread, read);
+	}
+}
+
+static int nst_wavrec_worker(void *data) {
+	// Worker thread, empties the ring until told to stop
+	int warned = 0;
+
+	while (true) {
+		bool stop = !SDL_AtomicGet(&running);
+
+		nst_wavrec_drain();
+
+		int lost = SDL_AtomicGet(&dropped);
+		if (lost != warned) {
+			fprintf(stderr, "Audio recording: disk too slow, %d samples dropped\n", lost);
+			warned = lost;
+		}
+
+		if (stop) { break; }
+		SDL_Delay(WAVREC_POLL_MS);
+	}
+
+	return 0;
+}
+
+bool nst_wavrec_start(const char *filename) {
+	// Start recording the sound to a file
+	nst_wavrec_stop();
+
+	wavfile = fopen(filename, "wb");
+	if (!wavfile) {
+		fprintf(stderr, "Audio recording: could not open %s\n", filename);
+		return false;
+	}
+
+	channels = conf.audio_stereo ? 2 : 1;
+	rate = conf.audio_sample_rate;
+	frames = bytes = 0;
+	full = false;
+
+	// Sizes are filled in when done
+	nst_wav_header(wavfile, rate, channels, 0);
+
+	SDL_AtomicSet(&ringread, 0);
+	SDL_AtomicSet(&ringwrite, 0);
+	SDL_AtomicSet(&dropped, 0);
+	SDL_AtomicSet(&running, 1);
+
+	worker = SDL_CreateThread(nst_wavrec_worker, "wavrec", NULL);
+
+	if (!worker) {
+		fprintf(stderr, "Audio recording: could not start worker thread: %s\n", SDL_GetError());
+		fclose(wavfile);
+		wavfile = NULL;
+		return false;
+	}
+
+	recording = true;
+	fprintf(stderr, "Audio recording: %s\n", filename);
+
+	return true;
+}
+
+void nst_wavrec_stop() {
+	// Let the worker finish and complete the header
+	if (!recording) { return; }
+
+	recording = false;
+	SDL_AtomicSet(&running, 0);
+	SDL_WaitThread(worker, NULL);
+	worker = NULL;
+
+	if (frames && !full) { rate = nst_wav_rate(bytes, channels, frames, nst_pal()); }
+
+	fseek(wavfile, 0, SEEK_SET);
+	nst_wav_header(wavfile, rate, channels, bytes);
+
+	if (fclose(wavfile)) { fprintf(stderr, "Audio recording: write failed\n"); }
+	wavfile = NULL;
+
+	fprintf(stderr, "Audio recording: %u frames, %u Hz, %d samples dropped\n", frames, rate, SDL_AtomicGet(&dropped));
+}
+
+bool nst_wavrec_recording() {
+	return recording;
+}
+
+void nst_wavrec_audio(const int16_t *samples, int count) {
+	// Queue a frame of sound, or drop all of it if there is no room
+	if (!recording) { return; }
+
+	unsigned total = count * channels;
+	unsigned write = SDL_AtomicGet(&ringwrite);
+	unsigned space = WAVREC_RING_SIZE - (write - SDL_AtomicGet(&ringread));
+
+	if (total > space) {
+		SDL_AtomicAdd(&dropped, total);
+		return;
+	}
+
+	for (unsigned i = 0; i < total; i++) {
+		ring[(write + i) & (WAVREC_RING_SIZE - 1)] = samples[i];
+	}
+
+	SDL_AtomicSet(&ringwrite, write + total);
+	frames++;
+}
@@ -0,0 +1,19 @@
+#ifndef _WAVREC_H_
+#define _WAVREC_H_
+
+#include <stdio.h>
+#include <stdint.h>
+
+#define WAVREC_RING_SIZE (1 << 18) // Samples, several seconds of slack for a slow disk
+#define WAVREC_POLL_MS 20 // How often the worker empties the ring
+#define WAVREC_MAX_BYTES 0xfffff000U // Keep the RIFF sizes in 32 bits
+
+void nst_wav_header(FILE *file, unsigned rate, int channels, unsigned bytes);
+unsigned nst_wav_rate(unsigned bytes, int channels, unsigned frames, bool pal);
+
+bool nst_wavrec_start(const char *filename);
+void nst_wavrec_stop();
+bool nst_wavrec_recording();
+void nst_wavrec_audio(const int16_t *samples, int frames);
+
+#endif
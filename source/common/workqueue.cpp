@@ -0,0 +1,116 @@
+/*
+ * Nestopia UE
+ *
+ * Copyright (C) 2012-2018 R. Danbrook
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ *
+ */
+
+#include <stddef.h>
+
+#include "workqueue.h"
+
+static int nst_workqueue_worker(void *data) {
+	// Worker thread, runs queued jobs in order until stopped and empty
+	workqueue_t *queue = (workqueue_t*)data;
+	SDL_LockMutex(queue->mutex);
+
+	while (true) {
+		while (queue->written == queue->queued && queue->running) { SDL_CondWait(queue->cond, queue->mutex); }
+		if (queue->written == queue->queued) { break; }
+
+		unsigned slot = queue->written % queue->size;
+
+		SDL_UnlockMutex(queue->mutex);
+		queue->process(slot);
+		SDL_LockMutex(queue->mutex);
+
+		queue->written++;
+		SDL_CondBroadcast(queue->cond);
+	}
+
+	SDL_UnlockMutex(queue->mutex);
+	return 0;
+}
+
+bool nst_workqueue_start(workqueue_t *queue, const char *name) {
+	// Start the worker, size and process must already be set
+	queue->queued = queue->written = 0;
+
+	queue->mutex = SDL_CreateMutex();
+	queue->cond = SDL_CreateCond();
+	queue->running = true;
+
+	queue->worker = SDL_CreateThread(nst_workqueue_worker, name, queue);
+
+	if (!queue->worker) { queue->running = false; }
+	return queue->running;
+}
+
+void nst_workqueue_stop(workqueue_t *queue) {
+	// Let the worker finish what is pending, then stop it
+	if (queue->worker) {
+		SDL_LockMutex(queue->mutex);
+		queue->running = false;
+		SDL_CondBroadcast(queue->cond);
+		SDL_UnlockMutex(queue->mutex);
+
+		SDL_WaitThread(queue->worker, NULL);
+		queue->worker = NULL;
+	}
+
+	if (queue->cond) { SDL_DestroyCond(queue->cond); queue->cond = NULL; }
+	if (queue->mutex) { SDL_DestroyMutex(queue->mutex); queue->mutex = NULL; }
+}
+
+int nst_workqueue_slot(workqueue_t *queue, bool wait) {
+	// Get the next free slot, or -1 if they are all in use
+	SDL_LockMutex(queue->mutex);
+	while (wait && queue->queued - queue->written == queue->size) { SDL_CondWait(queue->cond, queue->mutex); }
+	bool full = queue->queued - queue->written == queue->size;
+	SDL_UnlockMutex(queue->mutex);
+
+	// Slots in [queued, written + size) are owned by the caller until queued is bumped
+	return full ? -1 : (int)(queue->queued % queue->size);
+}
+
+void nst_workqueue_submit(workqueue_t *queue) {
+	// Hand the slot that was just filled over to the worker
+	SDL_LockMutex(queue->mutex);
+	queue->queued++;
+	SDL_CondBroadcast(queue->cond);
+	SDL_UnlockMutex(queue->mutex);
+}
+
+void nst_workqueue_flush(workqueue_t *queue) {
+	// Wait for everything queued to be done
+	if (!queue->mutex) { return; }
+
+	SDL_LockMutex(queue->mutex);
+	while (queue->written != queue->queued) { SDL_CondWait(queue->cond, queue->mutex); }
+	SDL_UnlockMutex(queue->mutex);
+}
+
+unsigned nst_workqueue_written(workqueue_t *queue) {
+	// Number of jobs done so far
+	if (!queue->mutex) { return queue->written; }
+
+	SDL_LockMutex(queue->mutex);
+	unsigned written = queue->written;
+	SDL_UnlockMutex(queue->mutex);
+	return written;
+}
@@ -0,0 +1,25 @@
+#ifndef _WORKQUEUE_H_
+#define _WORKQUEUE_H_
+
+#include <SDL.h>
+
+// A ring of job slots emptied in order by one worker thread. The slots
+// themselves live with the user, only their indices are passed around.
+typedef struct {
+	unsigned size; // Number of slots
+	void (*process)(unsigned slot); // Runs one job, on the worker thread
+	unsigned queued, written; // Jobs in [written, queued) are pending
+	bool running;
+	SDL_Thread *worker;
+	SDL_mutex *mutex;
+	SDL_cond *cond;
+} workqueue_t;
+
+bool nst_workqueue_start(workqueue_t *queue, const char *name);
+void nst_workqueue_stop(workqueue_t *queue);
+int nst_workqueue_slot(workqueue_t *queue, bool wait);
+void nst_workqueue_submit(workqueue_t *queue);
+void nst_workqueue_flush(workqueue_t *queue);
+unsigned nst_workqueue_written(workqueue_t *queue);
+
+#endif
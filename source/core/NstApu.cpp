@@ -24,7 +24,9 @@
 
 #include <cstring>
 #include "NstCpu.hpp"
+#include "NstCodeDataLogger.hpp"
 #include "NstState.hpp"
+#include "NstProfiler.hpp"
 #include "api/NstApiSound.hpp"
 #include "NstSoundRenderer.inl"
 
@@ -772,6 +774,7 @@ namespace Nes
 		inline void Apu::Update(const Cycle target)
 		{
 			NST_ASSERT( cycles.fixed );
+			NST_PROFILE_SCOPE( Profiler::SECTION_APU );
 			(*this.*updater)( target * cycles.fixed );
 		}
 
@@ -859,8 +862,14 @@ namespace Nes
 			{
 				dword streamed = 0;
 
-				if (Sound::Output::lockCallback( *stream ))
+				NST_PROFILE_ENTER( Profiler::SECTION_SOUND_LOCK );
+				const bool locked = Sound::Output::lockCallback( *stream );
+				NST_PROFILE_LEAVE();
+
+				if (locked)
 				{
+					NST_PROFILE_ENTER( Profiler::SECTION_APU );
+
 					streamed = stream->length[0] + stream->length[1];
 
 					if (settings.bits == 16)
@@ -878,7 +887,11 @@ namespace Nes
 							FlushSound<byte,true>();
 					}
 
+					NST_PROFILE_LEAVE();
+
+					NST_PROFILE_ENTER( Profiler::SECTION_SOUND_LOCK );
 					Sound::Output::unlockCallback( *stream );
+					NST_PROFILE_LEAVE();
 				}
 
 				if (const dword rate = synchronizer.Clock( streamed, settings.rate, cpu ))
@@ -2309,6 +2322,7 @@ namespace Nes
 		void Apu::Dmc::DoDMA(Cpu& cpu,const Cycle clock,const uint readAddress)
 		{
 			NST_VERIFY( !dma.buffered && (!readAddress || !cpu.IsWriteCycle(clock)) );
+			NST_PROFILE_EVENT( Profiler::EVENT_DMC_DMAS );
 
 			if (!readAddress)
 			{
@@ -2333,7 +2347,10 @@ namespace Nes
 				cpu.StealCycles( cpu.GetClock(1) );
 			}
 
-			dma.buffer = cpu.Peek( dma.address );
+			if (CodeDataLogger* const cdl = cpu.GetCdl())
+				dma.buffer = cdl->PeekSample( dma.address );
+			else
+				dma.buffer = cpu.Peek( dma.address );
 			cpu.StealCycles( cpu.GetClock() );
 			dma.address = 0x8000 | ((dma.address + 1U) & 0x7FFF);
 			dma.buffered = true;
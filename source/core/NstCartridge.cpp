@@ -47,12 +47,10 @@ namespace Nes
 		: nmt(NMT_DEFAULT), battery(false), wramAuto(false) {}
 
 		Cartridge::Cartridge(Context& context)
-		: Image(CARTRIDGE), board(NULL), vs(NULL), favoredSystem(context.favoredSystem)
+		: Image(CARTRIDGE), board(NULL), vs(NULL), favoredSystem(context.favoredSystem), clone(false)
 		{
 			try
 			{
-				ProfileEx profileEx;
-
 				switch (Stream::In(&context.stream).Peek32())
 				{
 					case INES_ID:
@@ -145,6 +143,47 @@ namespace Nes
 			}
 		}
 
+		Cartridge::Cartridge(const Cartridge& source,Cpu& cpu,Apu& apu,Ppu& ppu)
+		:
+		Image         (CARTRIDGE),
+		board         (NULL),
+		vs            (NULL),
+		prg           (source.prg),
+		chr           (source.chr),
+		profile       (source.profile),
+		profileEx     (source.profileEx),
+		prgCrc        (source.prgCrc),
+		favoredSystem (source.favoredSystem),
+		clone         (true)
+		{
+			// the ROM is shared with the source so it can only be
+			// done for boards that never write to it
+
+			try
+			{
+				if (source.board->WritesTo( prg ) || source.board->WritesTo( chr ))
+					throw RESULT_ERR_UNSUPPORTED;
+
+				Chips chips;
+				GetChips( profile, chips );
+
+				board = source.board->Clone( cpu, apu, ppu, prg, chr, profileEx.trainer, chips );
+
+				if (source.vs)
+					vs = VsSystem::Create( cpu, ppu, static_cast<PpuModel>(profile.system.ppu), prgCrc );
+			}
+			catch (...)
+			{
+				Destroy();
+				throw;
+			}
+		}
+
+		bool Cartridge::IsCloneOf(const Image& image) const
+		{
+			return image.GetType() == CARTRIDGE && static_cast<const Cartridge&>(image).prg.Mem() == prg.Mem();
+		}
+
 		void Cartridge::Destroy()
 		{
 			VsSystem::Destroy( vs );
@@ -215,6 +254,20 @@ namespace Nes
 			}
 		}
 
+		void Cartridge::GetChips(const Profile& profile,Chips& chips)
+		{
+			for (Profile::Board::Chips::const_iterator i(profile.board.chips.begin()), end(profile.board.chips.end()); i != end; ++i)
+			{
+				Chips::Type& type = chips.Add( i->type.c_str() );
+
+				for (Profile::Board::Pins::const_iterator j(i->pins.begin()), end(i->pins.end()); j != end; ++j)
+					type.Pin(j->number) = j->function.c_str();
+
+				for (Profile::Board::Samples::const_iterator j(i->samples.begin()), end(i->samples.end()); j != end; ++j)
+					type.Sample(j->id) = j->file.c_str();
+			}
+		}
+
 		Result Cartridge::SetupBoard
 		(
 			Ram& prg,
@@ -248,17 +301,7 @@ namespace Nes
 			}
 
 			Chips chips;
-
-			for (Profile::Board::Chips::const_iterator i(profile.board.chips.begin()), end(profile.board.chips.end()); i != end; ++i)
-			{
-				Chips::Type& type = chips.Add( i->type.c_str() );
-
-				for (Profile::Board::Pins::const_iterator j(i->pins.begin()), end(i->pins.end()); j != end; ++j)
-					type.Pin(j->number) = j->function.c_str();
-
-				for (Profile::Board::Samples::const_iterator j(i->samples.begin()), end(i->samples.end()); j != end; ++j)
-					type.Sample(j->id) = j->file.c_str();
-			}
+			GetChips( profile, chips );
 
 			Boards::Board::Context b
 			(
@@ -365,7 +408,11 @@ namespace Nes
 				if (board)
 				{
 					board->Sync( Boards::Board::EVENT_POWER_OFF, NULL );
-					board->Save( savefile );
+
+					// battery data belongs to the source cartridge
+
+					if (!clone)
+						board->Save( savefile );
 				}
 
 				return true;
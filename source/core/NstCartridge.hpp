@@ -43,11 +43,14 @@ namespace Nes
 			class Board;
 		}
 
+		class Chips;
+
 		class Cartridge : public Image
 		{
 		public:
 
 			explicit Cartridge(Context&);
+			Cartridge(const Cartridge&,Cpu&,Apu&,Ppu&);
 
 			void BeginFrame(const Api::Input&,Input::Controllers*);
 
@@ -87,6 +90,8 @@ namespace Nes
 
 			class VsSystem;
 
+			static void GetChips(const Profile&,Chips&);
+
 			static Result SetupBoard
 			(
 				Ram&,
@@ -113,15 +118,18 @@ namespace Nes
 			System GetDesiredSystem(Region,CpuModel*,PpuModel*) const;
 
 			ExternalDevice QueryExternalDevice(ExternalDeviceType);
+			bool IsCloneOf(const Image&) const;
 
 			Boards::Board* board;
 			VsSystem* vs;
 			Ram prg;
 			Ram chr;
 			Profile profile;
+			ProfileEx profileEx;
 			dword prgCrc;
 			File savefile;
 			const FavoredSystem favoredSystem;
+			const ibool clone;
 
 		public:
 
@@ -134,6 +142,21 @@ namespace Nes
 			{
 				return prgCrc;
 			}
+
+			const Boards::Board& GetBoard() const
+			{
+				return *board;
+			}
+
+			const Ram& GetPrg() const
+			{
+				return prg;
+			}
+
+			const Ram& GetChr() const
+			{
+				return chr;
+			}
 		};
 	}
 }
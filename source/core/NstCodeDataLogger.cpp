@@ -0,0 +1,287 @@
+////////////////////////////////////////////////////////////////////////////////////////
+//
+// Nestopia - NES/Famicom emulator written in C++
+//
+// Copyright (C) 2003-2008 Martin Freij
+//
+// This file is part of Nestopia.
+//
+// Nestopia is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Nestopia is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Nestopia; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////////////
+
+
+#include <cstring>
+#include "NstCpu.hpp"
+#include "NstPpu.hpp"
+#include "NstCartridge.hpp"
+#include "board/NstBoard.hpp"
+#include "NstCodeDataLogger.hpp"
+
+namespace Nes
+{
+	namespace Core
+	{
+		#ifdef NST_MSVC_OPTIMIZE
+		#pragma optimize("s", on)
+		#endif
+
+		// instruction length in bytes, and whether data is read through a pointer
+		const byte CodeDataLogger::opcodes[0x100] =
+		{
+			0x1,0x6,0x1,0x6,0x2,0x2,0x2,0x2,0x1,0x2,0x1,0x2,0x3,0x3,0x3,0x3,
+			0x2,0x6,0x1,0x6,0x2,0x2,0x2,0x2,0x1,0x3,0x1,0x3,0x3,0x3,0x3,0x3,
+			0x3,0x6,0x1,0x6,0x2,0x2,0x2,0x2,0x1,0x2,0x1,0x2,0x3,0x3,0x3,0x3,
+			0x2,0x6,0x1,0x6,0x2,0x2,0x2,0x2,0x1,0x3,0x1,0x3,0x3,0x3,0x3,0x3,
+			0x1,0x6,0x1,0x6,0x2,0x2,0x2,0x2,0x1,0x2,0x1,0x2,0x3,0x3,0x3,0x3,
+			0x2,0x6,0x1,0x6,0x2,0x2,0x2,0x2,0x1,0x3,0x1,0x3,0x3,0x3,0x3,0x3,
+			0x1,0x6,0x1,0x6,0x2,0x2,0x2,0x2,0x1,0x2,0x1,0x2,0x3,0x3,0x3,0x3,
+			0x2,0x6,0x1,0x6,0x2,0x2,0x2,0x2,0x1,0x3,0x1,0x3,0x3,0x3,0x3,0x3,
+			0x2,0x6,0x2,0x6,0x2,0x2,0x2,0x2,0x1,0x2,0x1,0x2,0x3,0x3,0x3,0x3,
+			0x2,0x6,0x1,0x6,0x2,0x2,0x2,0x2,0x1,0x3,0x1,0x3,0x3,0x3,0x3,0x3,
+			0x2,0x6,0x2,0x6,0x2,0x2,0x2,0x2,0x1,0x2,0x1,0x2,0x3,0x3,0x3,0x3,
+			0x2,0x6,0x1,0x6,0x2,0x2,0x2,0x2,0x1,0x3,0x1,0x3,0x3,0x3,0x3,0x3,
+			0x2,0x6,0x2,0x6,0x2,0x2,0x2,0x2,0x1,0x2,0x1,0x2,0x3,0x3,0x3,0x3,
+			0x2,0x6,0x1,0x6,0x2,0x2,0x2,0x2,0x1,0x3,0x1,0x3,0x3,0x3,0x3,0x3,
+			0x2,0x6,0x2,0x6,0x2,0x2,0x2,0x2,0x1,0x2,0x1,0x2,0x3,0x3,0x3,0x3,
+			0x2,0x6,0x1,0x6,0x2,0x2,0x2,0x2,0x1,0x3,0x1,0x3,0x3,0x3,0x3,0x3
+		};
+
+		CodeDataLogger::CodeDataLogger(Cpu& c,Ppu& p,const Cartridge& cartridge)
+		:
+		pc       (0),
+		opcode   (NOP),
+		jump     (false),
+		sampling (false),
+		running  (false),
+		cpu      (c),
+		ppu      (p),
+		prg      (cartridge.GetBoard().GetPrg()),
+		chr      (p.GetChrMem()),
+		prgSize  (cartridge.GetPrg().Size()),
+		chrSize  (cartridge.GetChr().Size()),
+		log      (new byte [prgSize + chrSize])
+		{
+			Clear();
+			std::memset( installed, false, sizeof(installed) );
+		}
+
+		CodeDataLogger::~CodeDataLogger()
+		{
+			if (running)
+				Stop();
+
+			delete [] log;
+		}
+
+		void CodeDataLogger::Start()
+		{
+			running = true;
+			Install();
+
+			cpu.SetCdl( this );
+			ppu.SetCdl( this );
+		}
+
+		void CodeDataLogger::Stop()
+		{
+			running = false;
+			Uninstall();
+
+			cpu.SetCdl( NULL );
+			ppu.SetCdl( NULL );
+		}
+
+		void CodeDataLogger::Reset()
+		{
+			// the CPU map was rebuilt, so none of the wrappers are left
+			std::memset( installed, false, sizeof(installed) );
+
+			if (running)
+				Install();
+		}
+
+		void CodeDataLogger::Clear()
+		{
+			std::memset( log, 0, prgSize + chrSize );
+		}
+
+		void CodeDataLogger::Install()
+		{
+			// boards map their ports on reset, so this is done again after every one
+
+			const Io::Port port( this, &CodeDataLogger::Peek_Prg, &CodeDataLogger::Poke_Prg );
+
+			for (uint i=0x8000; i < 0x10000; ++i)
+			{
+				if (!installed[i - 0x8000])
+				{
+					Io::Port& slot = cpu.Map( i );
+
+					ports[i - 0x8000] = slot;
+					slot = port;
+					installed[i - 0x8000] = true;
+				}
+			}
+		}
+
+		void CodeDataLogger::Uninstall()
+		{
+			// a wrapper something else has since wrapped in turn is left in
+			// place, passing accesses through, as that one still calls it
+
+			const Io::Port port( this, &CodeDataLogger::Peek_Prg, &CodeDataLogger::Poke_Prg );
+
+			for (uint i=0x8000; i < 0x10000; ++i)
+			{
+				Io::Port& slot = cpu.Map( i );
+
+				if (slot == port)
+				{
+					slot = ports[i - 0x8000];
+					installed[i - 0x8000] = false;
+				}
+			}
+		}
+
+		void CodeDataLogger::Save(StdStream const stdStream) const
+		{
+			Stream::Out( stdStream ).Write( log, prgSize + chrSize );
+		}
+
+		void CodeDataLogger::Load(StdStream const stdStream)
+		{
+			byte* const data = new byte [prgSize + chrSize];
+
+			try
+			{
+				Stream::In stream( stdStream );
+				stream.Read( data, prgSize + chrSize );
+
+				// a longer file was logged with a different ROM
+
+				if (!stream.Eof())
+					throw RESULT_ERR_CORRUPT_FILE;
+			}
+			catch (...)
+			{
+				delete [] data;
+				throw RESULT_ERR_CORRUPT_FILE;
+			}
+
+			std::memcpy( log, data, prgSize + chrSize );
+			delete [] data;
+		}
+
+		void CodeDataLogger::GetCoverage(const Rom rom,dword offset,const dword length,Coverage& coverage) const
+		{
+			NST_ASSERT( offset + length <= GetSize(rom) );
+
+			coverage.size = length;
+			coverage.logged = 0;
+			coverage.code = 0;
+			coverage.data = 0;
+			coverage.pcm = 0;
+			coverage.drawn = 0;
+			coverage.read = 0;
+
+			const byte* NST_RESTRICT flags = log + (rom == Api::CodeDataLogger::PRG ? 0 : prgSize) + offset;
+
+			for (const byte* const end = flags + length; flags != end; ++flags)
+			{
+				if (const uint flag = *flags)
+				{
+					coverage.logged++;
+
+					if (rom == Api::CodeDataLogger::PRG)
+					{
+						coverage.code += bool(flag & Api::CodeDataLogger::PRG_CODE);
+						coverage.data += bool(flag & Api::CodeDataLogger::PRG_DATA);
+						coverage.pcm  += bool(flag & Api::CodeDataLogger::PRG_PCM);
+					}
+					else
+					{
+						coverage.drawn += bool(flag & Api::CodeDataLogger::CHR_DRAWN);
+						coverage.read  += bool(flag & Api::CodeDataLogger::CHR_READ);
+					}
+				}
+			}
+		}
+
+		uint CodeDataLogger::PeekSample(const uint address)
+		{
+			sampling = true;
+			const uint data = cpu.Peek( address );
+			sampling = false;
+
+			return data;
+		}
+
+		#ifdef NST_MSVC_OPTIMIZE
+		#pragma optimize("", on)
+		#endif
+
+		NES_PEEK_A(CodeDataLogger,Prg)
+		{
+			const uint data = ports[address - 0x8000].Peek( address );
+			const uint page = address >> 13 & 0x3;
+
+			if (running && prg.GetSource( page ) == 0)
+			{
+				const dword offset = prg.GetBank<SIZE_8K>( address & 0x6000 ) << 13 | (address & 0x1FFF);
+
+				if (offset < prgSize)
+				{
+					// classify the read by where it falls relative to the instruction
+					// being executed, bytes past its end being dummy reads
+
+					const uint step = (address - pc) & 0xFFFF;
+					uint flags;
+
+					if (sampling)
+					{
+						flags = Api::CodeDataLogger::PRG_PCM;
+					}
+					else if (step == 0)
+					{
+						opcode = data;
+						flags = Api::CodeDataLogger::PRG_CODE|Api::CodeDataLogger::PRG_OPCODE|(jump ? Api::CodeDataLogger::PRG_INDIRECT_CODE : 0);
+					}
+					else if (step < (opcodes[opcode] & LENGTH))
+					{
+						flags = Api::CodeDataLogger::PRG_CODE;
+					}
+					else if (step < 3)
+					{
+						return data;
+					}
+					else
+					{
+						flags = Api::CodeDataLogger::PRG_DATA|((opcodes[opcode] & INDIRECT) ? Api::CodeDataLogger::PRG_INDIRECT_DATA : 0);
+					}
+
+					log[offset] |= flags | page << 2;
+				}
+			}
+
+			return data;
+		}
+
+		NES_POKE_AD(CodeDataLogger,Prg)
+		{
+			ports[address - 0x8000].Poke( address, data );
+		}
+	}
+}
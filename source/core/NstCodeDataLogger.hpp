@@ -0,0 +1,148 @@
+////////////////////////////////////////////////////////////////////////////////////////
+//
+// Nestopia - NES/Famicom emulator written in C++
+//
+// Copyright (C) 2003-2008 Martin Freij
+//
+// This file is part of Nestopia.
+//
+// Nestopia is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Nestopia is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Nestopia; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef NST_CODEDATALOGGER_H
+#define NST_CODEDATALOGGER_H
+
+#ifdef NST_PRAGMA_ONCE
+#pragma once
+#endif
+
+#include "NstIoPort.hpp"
+#include "NstMemory.hpp"
+#include "NstStream.hpp"
+#include "api/NstApiCodeDataLogger.hpp"
+
+namespace Nes
+{
+	namespace Core
+	{
+		class Cpu;
+		class Ppu;
+		class Cartridge;
+
+		class CodeDataLogger
+		{
+		public:
+
+			typedef Api::CodeDataLogger::Rom Rom;
+			typedef Api::CodeDataLogger::Coverage Coverage;
+
+			CodeDataLogger(Cpu&,Ppu&,const Cartridge&);
+			~CodeDataLogger();
+
+			void Start();
+			void Stop();
+			void Reset();
+			void Clear();
+
+			void Save(StdStream) const;
+			void Load(StdStream);
+
+			void GetCoverage(Rom,dword,dword,Coverage&) const;
+
+			uint PeekSample(uint);
+
+			inline void BeginInstruction(uint,uint);
+			inline void LogChr(uint,uint);
+
+			enum
+			{
+				CHR_ACCESS_BG     = Api::CodeDataLogger::CHR_DRAWN|Api::CodeDataLogger::CHR_BG,
+				CHR_ACCESS_SPRITE = Api::CodeDataLogger::CHR_DRAWN|Api::CodeDataLogger::CHR_SPRITE,
+				CHR_ACCESS_READ   = Api::CodeDataLogger::CHR_READ
+			};
+
+		private:
+
+			typedef Memory<SIZE_32K,SIZE_8K,2> Prg;
+			typedef Memory<SIZE_8K,SIZE_1K,2> Chr;
+
+			enum
+			{
+				LENGTH = 0x3,
+				INDIRECT = 0x4,
+				JMP_IND = 0x6C,
+				NOP = 0xEA
+			};
+
+			void Install();
+			void Uninstall();
+
+			NES_DECL_PEEK( Prg );
+			NES_DECL_POKE( Prg );
+
+			uint pc;
+			uint opcode;
+			ibool jump;
+			ibool sampling;
+			ibool running;
+			Cpu& cpu;
+			Ppu& ppu;
+			const Prg& prg;
+			const Chr& chr;
+			const dword prgSize;
+			const dword chrSize;
+			byte* const log;
+			Io::Port ports[SIZE_32K];
+			bool installed[SIZE_32K];
+
+			static const byte opcodes[0x100];
+
+		public:
+
+			bool IsRunning() const
+			{
+				return running;
+			}
+
+			dword GetSize(Rom rom) const
+			{
+				return rom == Api::CodeDataLogger::PRG ? prgSize : chrSize;
+			}
+		};
+
+		inline void CodeDataLogger::BeginInstruction(uint address,uint last)
+		{
+			// the opcode is picked up when fetched, if it is fetched from ROM
+			pc = address;
+			opcode = NOP;
+			jump = (last == JMP_IND);
+		}
+
+		inline void CodeDataLogger::LogChr(uint address,uint access)
+		{
+			if (chr.GetSource( address >> 10 ) == 0)
+			{
+				const dword offset = chr.GetBank<SIZE_1K>( address & 0x1C00 ) << 10 | (address & 0x3FF);
+
+				if (offset < chrSize)
+					log[prgSize + offset] |= access;
+			}
+		}
+	}
+}
+
+#endif
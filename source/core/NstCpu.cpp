@@ -26,6 +26,10 @@
 #include <cstdlib>
 #include "NstCpu.hpp"
 #include "NstHook.hpp"
+#include "NstProfiler.hpp"
+#include "NstTracer.hpp"
+#include "NstCodeDataLogger.hpp"
+#include "NstDebugger.hpp"
 #include "NstState.hpp"
 #include "api/NstApiUser.hpp"
 
@@ -150,9 +154,12 @@ namespace Nes
 
 		Cpu::Cpu()
 		:
-		model ( CPU_RP2A03 ),
-		apu   ( *this ),
-		map   ( this, &Cpu::Peek_Overflow, &Cpu::Poke_Overflow )
+		tracer   ( NULL ),
+		cdl      ( NULL ),
+		debugger ( NULL ),
+		model    ( CPU_RP2A03 ),
+		apu      ( *this ),
+		map      ( this, &Cpu::Peek_Overflow, &Cpu::Poke_Overflow )
 		{
 			cycles.UpdateTable( GetModel() );
 			Reset( false, false );
@@ -757,18 +764,22 @@ namespace Nes
 		inline uint Cpu::IoMap::Peek8(const uint address) const
 		{
 			NST_ASSERT( address < FULL_SIZE );
+			NST_PROFILE_READ( address );
 			return ports[address].Peek( address );
 		}
 
 		inline uint Cpu::IoMap::Peek16(const uint address) const
 		{
 			NST_ASSERT( address < FULL_SIZE-1 );
+			NST_PROFILE_READ( address );
+			NST_PROFILE_READ( address + 1 );
 			return ports[address].Peek( address ) | ports[address + 1].Peek( address + 1 ) << 8;
 		}
 
 		inline void Cpu::IoMap::Poke8(const uint address,const uint data) const
 		{
 			NST_ASSERT( address < FULL_SIZE );
+			NST_PROFILE_WRITE( address );
 			ports[address].Poke( address, data );
 		}
 
@@ -1865,7 +1876,10 @@ namespace Nes
 				flags.i = Flags::I;
 
 				cycles.count += cycles.clock[INT_CYCLES-1];
-				pc = map.Peek16( vector == NMI_VECTOR ? NMI_VECTOR : FetchIRQISRVector() );
+
+				const uint isr = (vector == NMI_VECTOR ? NMI_VECTOR : FetchIRQISRVector());
+				NST_PROFILE_EVENT( isr == NMI_VECTOR ? Profiler::EVENT_NMIS : Profiler::EVENT_IRQS );
+				pc = map.Peek16( isr );
 
 				apu.Clock();
 			}
@@ -1903,6 +1917,12 @@ namespace Nes
 
 			Clock();
 
+			if (tracer || cdl || debugger)
+			{
+				RunDebug();
+				return;
+			}
+
 			switch (hooks.Size())
 			{
 				case 0:  Run0(); break;
@@ -1970,6 +1990,7 @@ namespace Nes
 		inline void Cpu::ExecuteOp()
 		{
 			cycles.offset = cycles.count;
+			NST_PROFILE_EVENT( Profiler::EVENT_INSTRUCTIONS );
 			(*this.*opcodes[opcode=FetchPc8()])();
 		}
 
@@ -2034,6 +2055,40 @@ namespace Nes
 			while (cycles.count < cycles.frame);
 		}
 
+		void Cpu::RunDebug()
+		{
+			do
+			{
+				do
+				{
+					const uint address = pc;
+
+					cycles.offset = cycles.count;
+					NST_PROFILE_EVENT( Profiler::EVENT_INSTRUCTIONS );
+
+					if (debugger)
+						debugger->BeginInstruction( address );
+
+					if (cdl)
+						cdl->BeginInstruction( address, opcode );
+
+					opcode = FetchPc8();
+
+					if (tracer)
+						tracer->Record( address, opcode, a, x, y, sp, flags.Pack(), cycles.offset );
+
+					(*this.*opcodes[opcode])();
+
+					for (const Hook *hook = hooks.Ptr(), *const end = hook+hooks.Size(); hook != end; ++hook)
+						hook->Execute();
+				}
+				while (cycles.count < cycles.round);
+
+				Clock();
+			}
+			while (cycles.count < cycles.frame);
+		}
+
 		uint Cpu::Peek(const uint address) const
 		{
 			return map.Peek8( address );
@@ -2044,6 +2099,16 @@ namespace Nes
 			return map.Poke8( address, data );
 		}
 
+		void Cpu::GetRegisters(Registers& registers) const
+		{
+			registers.pc = pc;
+			registers.a = a;
+			registers.x = x;
+			registers.y = y;
+			registers.sp = sp;
+			registers.p = flags.Pack();
+		}
+
 		////////////////////////////////////////////////////////////////////////////////////////
 		// opcodes
 		////////////////////////////////////////////////////////////////////////////////////////
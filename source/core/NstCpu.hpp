@@ -38,6 +38,9 @@ namespace Nes
 	namespace Core
 	{
 		class Hook;
+		class Tracer;
+		class CodeDataLogger;
+		class Debugger;
 
 		class Cpu
 		{
@@ -65,6 +68,16 @@ namespace Nes
 				LEVEL_HIGHEST = 10
 			};
 
+			struct Registers
+			{
+				uint pc;
+				uint a;
+				uint x;
+				uint y;
+				uint sp;
+				uint p;
+			};
+
 			void Reset(bool);
 			void SetRamPowerState(uint);
 			void Boot(bool);
@@ -78,6 +91,8 @@ namespace Nes
 			uint Peek(uint) const;
 			void Poke(uint,uint) const;
 
+			void GetRegisters(Registers&) const;
+
 			bool IsOddCycle() const;
 			bool IsWriteCycle(Cycle) const;
 
@@ -132,6 +147,7 @@ namespace Nes
 			void Run0();
 			void Run1();
 			void Run2();
+			void RunDebug();
 
 			inline void ExecuteOp();
 			inline uint FetchPc8();
@@ -479,6 +495,9 @@ namespace Nes
 			Flags flags;
 			Interrupt interrupt;
 			Hooks hooks;
+			Tracer* tracer;
+			CodeDataLogger* cdl;
+			Debugger* debugger;
 			uint opcode;
 			word jammed;
 			word model;
@@ -499,6 +518,26 @@ namespace Nes
 				return apu;
 			}
 
+			void SetTracer(Tracer* t)
+			{
+				tracer = t;
+			}
+
+			void SetCdl(CodeDataLogger* c)
+			{
+				cdl = c;
+			}
+
+			CodeDataLogger* GetCdl() const
+			{
+				return cdl;
+			}
+
+			void SetDebugger(Debugger* d)
+			{
+				debugger = d;
+			}
+
 			Cycle Update(uint readAddress=0)
 			{
 				apu.ClockDMA( readAddress );
@@ -0,0 +1,290 @@
+////////////////////////////////////////////////////////////////////////////////////////
+//
+// Nestopia - NES/Famicom emulator written in C++
+//
+// Copyright (C) 2003-2008 Martin Freij
+//
+// This file is part of Nestopia.
+//
+// Nestopia is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Nestopia is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Nestopia; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////////////
+
+
+#include <cstring>
+#include "NstCpu.hpp"
+#include "NstDebugger.hpp"
+
+namespace Nes
+{
+	namespace Core
+	{
+		#ifdef NST_MSVC_OPTIMIZE
+		#pragma optimize("s", on)
+		#endif
+
+		Debugger::Debugger(Cpu& c)
+		:
+		cpu        (c),
+		pc         (0),
+		fetch      (false),
+		busy       (false),
+		pending    (0),
+		count      (0),
+		callback   (NULL),
+		userData   (NULL),
+		numWatched (0)
+		{
+			std::memset( flags, 0, sizeof(flags) );
+		}
+
+		Debugger::~Debugger()
+		{
+			cpu.SetDebugger( NULL );
+
+			for (uint i=0; i < SIZE_64K; ++i)
+			{
+				if (flags[i] & INSTALLED)
+					Uninstall( i );
+			}
+		}
+
+		void Debugger::SetCallback(const Callback c,void* const u)
+		{
+			callback = c;
+			userData = u;
+		}
+
+		void Debugger::Set(const uint first,const uint last,const uint set)
+		{
+			NST_ASSERT( first <= last && last < SIZE_64K );
+
+			if (!(set & Api::Debugger::BREAK_ALL))
+				return;
+
+			for (uint i=first; i <= last; ++i)
+			{
+				if (!(flags[i] & Api::Debugger::BREAK_ALL))
+					++count;
+
+				flags[i] |= set & Api::Debugger::BREAK_ALL;
+
+				if (!(flags[i] & INSTALLED))
+					Install( i );
+			}
+
+			Watch();
+			cpu.SetDebugger( this );
+		}
+
+		void Debugger::Clear(const uint first,const uint last,const uint clear)
+		{
+			NST_ASSERT( first <= last && last < SIZE_64K );
+
+			for (uint i=first; i <= last; ++i)
+			{
+				if (flags[i] & Api::Debugger::BREAK_ALL)
+				{
+					flags[i] &= ~(clear & Api::Debugger::BREAK_ALL);
+
+					if (!(flags[i] & Api::Debugger::BREAK_ALL))
+					{
+						--count;
+						Uninstall( i );
+					}
+				}
+			}
+
+			Watch();
+
+			if (!count)
+			{
+				pending = 0;
+				cpu.SetDebugger( NULL );
+			}
+		}
+
+		void Debugger::Reset()
+		{
+			// the CPU map was rebuilt, so none of the traps are left
+
+			pending = 0;
+			fetch = false;
+
+			for (uint i=0; i < SIZE_64K; ++i)
+			{
+				flags[i] &= ~uint(INSTALLED);
+
+				if (flags[i])
+					Install( i );
+			}
+
+			Sync();
+		}
+
+		void Debugger::Sync()
+		{
+			// RAM was changed behind the CPU's back, e.g. by a state load
+
+			pending = 0;
+			Snapshot();
+		}
+
+		void Debugger::Snapshot()
+		{
+			for (uint i=0; i < numWatched; ++i)
+				shadow[i] = cpu.GetRam()[watched[i] & 0x7FF];
+		}
+
+		void Debugger::Watch()
+		{
+			// The CPU goes straight to RAM for zero page and stack accesses,
+			// so writes to watched RAM are also caught by comparing it with
+			// a copy at every instruction boundary.
+
+			numWatched = 0;
+
+			for (uint i=0; i < SIZE_2K; ++i)
+			{
+				for (uint address=i; address < 0x2000; address += SIZE_2K)
+				{
+					if (flags[address] & Api::Debugger::BREAK_WRITE)
+					{
+						watched[numWatched++] = address;
+						break;
+					}
+				}
+			}
+
+			Snapshot();
+		}
+
+		void Debugger::Install(const uint address)
+		{
+			Io::Port& slot = cpu.Map( address );
+
+			ports[address] = slot;
+			slot = Io::Port( this, &Debugger::Peek_Trap, &Debugger::Poke_Trap );
+			flags[address] |= INSTALLED;
+		}
+
+		void Debugger::Uninstall(const uint address)
+		{
+			// a trap something else has since wrapped in turn is left in
+			// place, passing accesses through, as that one still calls it
+
+			Io::Port& slot = cpu.Map( address );
+
+			if (slot == Io::Port( this, &Debugger::Peek_Trap, &Debugger::Poke_Trap ))
+			{
+				slot = ports[address];
+				flags[address] &= ~uint(INSTALLED);
+			}
+		}
+
+		#ifdef NST_MSVC_OPTIMIZE
+		#pragma optimize("", on)
+		#endif
+
+		void Debugger::Report(const Api::Debugger::Break type,const uint address,const uint data,const uint from)
+		{
+			if (!callback)
+				return;
+
+			Event event;
+
+			event.type = type;
+			event.address = address;
+			event.data = data;
+			event.pc = from;
+			event.dropped = 0;
+
+			// executions are reported right away, before the instruction does
+			// anything, the rest when the instruction doing them has completed
+
+			if (type == Api::Debugger::BREAK_EXEC)
+			{
+				busy = true;
+				callback( userData, event );
+				busy = false;
+			}
+			else if (pending < MAX_PENDING)
+				events[pending++] = event;
+			else
+				++events[MAX_PENDING-1].dropped;
+		}
+
+		void Debugger::Scan()
+		{
+			for (uint i=0; i < numWatched; ++i)
+			{
+				const uint data = cpu.GetRam()[watched[i] & 0x7FF];
+
+				if (shadow[i] != data)
+				{
+					shadow[i] = data;
+					Report( Api::Debugger::BREAK_WRITE, watched[i], data, pc );
+				}
+			}
+		}
+
+		void Debugger::Deliver()
+		{
+			const uint n = pending;
+			pending = 0;
+
+			busy = true;
+
+			for (uint i=0; i < n && callback; ++i)
+				callback( userData, events[i] );
+
+			busy = false;
+		}
+
+		NES_PEEK_A(Debugger,Trap)
+		{
+			const uint data = ports[address].Peek( address );
+
+			if (fetch && address == pc)
+			{
+				fetch = false;
+
+				if (flags[address] & Api::Debugger::BREAK_EXEC)
+				{
+					Report( Api::Debugger::BREAK_EXEC, address, data, pc );
+					return data;
+				}
+			}
+
+			if (flags[address] & Api::Debugger::BREAK_READ)
+				Report( Api::Debugger::BREAK_READ, address, data, pc );
+
+			return data;
+		}
+
+		NES_POKE_AD(Debugger,Trap)
+		{
+			ports[address].Poke( address, data );
+
+			if (flags[address] & Api::Debugger::BREAK_WRITE)
+			{
+				Report( Api::Debugger::BREAK_WRITE, address, data, pc );
+
+				if (address < 0x2000)
+					Snapshot();
+			}
+		}
+	}
+}
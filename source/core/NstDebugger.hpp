@@ -0,0 +1,126 @@
+////////////////////////////////////////////////////////////////////////////////////////
+//
+// Nestopia - NES/Famicom emulator written in C++
+//
+// Copyright (C) 2003-2008 Martin Freij
+//
+// This file is part of Nestopia.
+//
+// Nestopia is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Nestopia is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Nestopia; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef NST_DEBUGGER_H
+#define NST_DEBUGGER_H
+
+#ifdef NST_PRAGMA_ONCE
+#pragma once
+#endif
+
+#include "NstIoPort.hpp"
+#include "api/NstApiDebugger.hpp"
+
+namespace Nes
+{
+	namespace Core
+	{
+		class Cpu;
+
+		class Debugger
+		{
+		public:
+
+			typedef Api::Debugger::Event Event;
+			typedef Api::Debugger::Callback Callback;
+
+			explicit Debugger(Cpu&);
+			~Debugger();
+
+			void SetCallback(Callback,void*);
+			void Set(uint,uint,uint);
+			void Clear(uint,uint,uint);
+			void Reset();
+			void Sync();
+
+			inline void BeginInstruction(uint);
+
+		private:
+
+			enum
+			{
+				INSTALLED = 0x80,
+				MAX_PENDING = 8
+			};
+
+			void Install(uint);
+			void Uninstall(uint);
+			void Watch();
+			void Snapshot();
+			void Report(Api::Debugger::Break,uint,uint,uint);
+			void Scan();
+			void Deliver();
+
+			NES_DECL_PEEK( Trap );
+			NES_DECL_POKE( Trap );
+
+			Cpu& cpu;
+			uint pc;
+			ibool fetch;
+			ibool busy;
+			uint pending;
+			dword count;
+			Callback callback;
+			void* userData;
+			uint numWatched;
+			Event events[MAX_PENDING];
+			byte flags[SIZE_64K];
+			Io::Port ports[SIZE_64K];
+			word watched[SIZE_2K];
+			byte shadow[SIZE_2K];
+
+		public:
+
+			bool IsBusy() const
+			{
+				return busy;
+			}
+
+			uint Get(uint address) const
+			{
+				return flags[address & 0xFFFF] & uint(Api::Debugger::BREAK_ALL);
+			}
+
+			dword NumBreakpoints() const
+			{
+				return count;
+			}
+		};
+
+		inline void Debugger::BeginInstruction(uint address)
+		{
+			if (numWatched)
+				Scan();
+
+			if (pending)
+				Deliver();
+
+			pc = address;
+			fetch = true;
+		}
+	}
+}
+
+#endif
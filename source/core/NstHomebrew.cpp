@@ -47,6 +47,9 @@ namespace Nes
 		, stdErrAddress(0)
 		, stdErrSet(false)
 		, stdErrPort(NULL)
+		, capture(NULL)
+		, exited(false)
+		, exitCode(0)
 		{}
 
 		Homebrew::~Homebrew()
@@ -56,6 +59,14 @@ namespace Nes
 
 		void Homebrew::Reset()
 		{
+			exited = false;
+
+			// the cpu reset has dropped the links
+
+			exitPort = NULL;
+			stdOutPort = NULL;
+			stdErrPort = NULL;
+
 			ActivateExitPort();
 			ActivateStdOutPort();
 			ActivateStdErrPort();
@@ -68,6 +79,18 @@ namespace Nes
 			ClearStdErrPort();
 		}
 
+		void Homebrew::Capture(std::ostream* const stream)
+		{
+			capture = stream;
+			exited = false;
+		}
+
+		bool Homebrew::GetExitCode(uint& code) const
+		{
+			code = exitCode;
+			return exited;
+		}
+
 		Result Homebrew::SetExitPort
 		(
 			const word address,
@@ -221,6 +244,16 @@ namespace Nes
 
 		NES_POKE_D(Homebrew,Exit)
 		{
+			if (capture)
+			{
+				if (!exited)
+				{
+					exited = true;
+					exitCode = data;
+				}
+				return;
+			}
+
 			std::exit( data );
 		}
 
@@ -231,6 +264,12 @@ namespace Nes
 
 		NES_POKE_D(Homebrew,StdOut)
 		{
+			if (capture)
+			{
+				*capture << (static_cast<unsigned char>(data & 0xFF));
+				return;
+			}
+
 			std::cout << (static_cast<unsigned char>(data & 0xFF));
 
 			if (data == '\n')
@@ -244,6 +283,12 @@ namespace Nes
 
 		NES_POKE_D(Homebrew,StdErr)
 		{
+			if (capture)
+			{
+				*capture << (static_cast<unsigned char>(data & 0xFF));
+				return;
+			}
+
 			std::cerr << (static_cast<unsigned char>(data & 0xFF));
 
 			if (data == '\n')
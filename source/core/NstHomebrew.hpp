@@ -33,6 +33,8 @@
 #pragma once
 #endif
 
+#include <iosfwd>
+
 namespace Nes
 {
 	namespace Core
@@ -58,6 +60,9 @@ namespace Nes
 
 			dword NumPorts () const;
 
+			void Capture (std::ostream*);
+			bool GetExitCode (uint&) const;
+
 		private:
 
 			NES_DECL_PEEK( Exit );
@@ -86,6 +91,10 @@ namespace Nes
 			word stdErrAddress;
 			ibool stdErrSet;
 			const Io::Port* stdErrPort;
+
+			std::ostream* capture;
+			ibool exited;
+			uint exitCode;
 		};
 	}
 }
@@ -70,6 +70,14 @@ namespace Nes
 			throw RESULT_ERR_INVALID_FILE;
 		}
 
+		Image* Image::Clone(const Image& image,Cpu& cpu,Apu& apu,Ppu& ppu)
+		{
+			if (image.type == CARTRIDGE)
+				return new Cartridge( static_cast<const Cartridge&>(image), cpu, apu, ppu );
+
+			throw RESULT_ERR_UNSUPPORTED;
+		}
+
 		void Image::Unload(Image* image)
 		{
 			delete image;
@@ -86,6 +86,7 @@ namespace Nes
 			};
 
 			static Image* Load(Context&);
+			static Image* Clone(const Image&,Cpu&,Apu&,Ppu&);
 			static void Unload(Image*);
 
 			virtual void Reset(bool) = 0;
@@ -115,6 +116,11 @@ namespace Nes
 				return NULL;
 			}
 
+			virtual bool IsCloneOf(const Image&) const
+			{
+				return false;
+			}
+
 		protected:
 
 			explicit Image(Type);
@@ -23,10 +23,18 @@
 //
 ////////////////////////////////////////////////////////////////////////////////////////
 
+#include <sstream>
+#include "NstLog.hpp"
 #include "NstMachine.hpp"
+#include "NstState.hpp"
 #include "NstCartridge.hpp"
 #include "NstCheats.hpp"
 #include "NstHomebrew.hpp"
+#include "NstTracer.hpp"
+#include "NstCodeDataLogger.hpp"
+#include "NstDebugger.hpp"
+#include "NstRamSearch.hpp"
+#include "NstMemoryDiff.hpp"
 #include "NstNsf.hpp"
 #include "NstImageDatabase.hpp"
 #include "input/NstInpDevice.hpp"
@@ -52,7 +60,14 @@ namespace Nes
 		image         (NULL),
 		cheats        (NULL),
 		homebrew      (NULL),
+		tracer        (NULL),
+		cdl           (NULL),
+		debugger      (NULL),
+		search        (NULL),
+		diff          (NULL),
 		imageDatabase (NULL),
+		imageDatabaseShared (false),
+		clone         (false),
 		ppu           (cpu)
 		{
 		}
@@ -61,9 +76,12 @@ namespace Nes
 		{
 			Unload();
 
-			delete imageDatabase;
+			if (!imageDatabaseShared)
+				delete imageDatabase;
 			delete cheats;
 			delete homebrew;
+			delete tracer;
+			delete debugger;
 			delete expPort;
 
 			for (uint ports=extPort->NumPorts(), i=0; i < ports; ++i)
@@ -152,12 +170,24 @@ namespace Nes
 
 			tracker.Unload();
 
+			delete cdl;
+			cdl = NULL;
+
+			delete search;
+			search = NULL;
+
+			delete diff;
+			diff = NULL;
+
 			Image::Unload( image );
 			image = NULL;
 
 			state &= (Api::Machine::NTSC|Api::Machine::PAL);
 
-			Api::Machine::eventCallback( Api::Machine::EVENT_UNLOAD, result );
+			if (clone)
+				clone = false;
+			else
+				Api::Machine::eventCallback( Api::Machine::EVENT_UNLOAD, result );
 
 			return result;
 		}
@@ -254,7 +284,8 @@ namespace Nes
 				state &= ~uint(Api::Machine::ON);
 				frame = 0;
 
-				Api::Machine::eventCallback( Api::Machine::EVENT_POWER_OFF, result );
+				if (!clone)
+					Api::Machine::eventCallback( Api::Machine::EVENT_POWER_OFF, result );
 			}
 
 			return result;
@@ -295,6 +326,9 @@ namespace Nes
 					if (image)
 						image->Reset( hard );
 
+					if (cdl)
+						cdl->Reset();
+
 					if (cheats)
 						cheats->Reset();
 
@@ -308,16 +342,26 @@ namespace Nes
 					image->Reset( true );
 				}
 
+				if (debugger)
+					debugger->Reset();
+
 				cpu.Boot( hard );
 
 				if (state & Api::Machine::ON)
 				{
-					Api::Machine::eventCallback( hard ? Api::Machine::EVENT_RESET_HARD : Api::Machine::EVENT_RESET_SOFT );
+					if (!clone)
+						Api::Machine::eventCallback( hard ? Api::Machine::EVENT_RESET_HARD : Api::Machine::EVENT_RESET_SOFT );
 				}
 				else
 				{
 					state |= Api::Machine::ON;
-					Api::Machine::eventCallback( Api::Machine::EVENT_POWER_ON );
+
+				#ifdef NST_PROFILE
+					profiler.frames = 0;
+				#endif
+
+					if (!clone)
+						Api::Machine::eventCallback( Api::Machine::EVENT_POWER_ON );
 				}
 			}
 			catch (...)
@@ -343,7 +387,8 @@ namespace Nes
 
 			UpdateModels();
 
-			Api::Machine::eventCallback( (state & Api::Machine::NTSC) ? Api::Machine::EVENT_MODE_NTSC : Api::Machine::EVENT_MODE_PAL );
+			if (!clone)
+				Api::Machine::eventCallback( (state & Api::Machine::NTSC) ? Api::Machine::EVENT_MODE_NTSC : Api::Machine::EVENT_MODE_PAL );
 		}
 
 		void Machine::InitializeInputDevices() const
@@ -480,6 +525,9 @@ namespace Nes
 				}
 
 				loader.End();
+
+				if (debugger)
+					debugger->Sync();
 			}
 			catch (...)
 			{
@@ -492,6 +540,67 @@ namespace Nes
 			return true;
 		}
 
+		void Machine::CloneImage(const Machine& source)
+		{
+			NST_ASSERT( this != &source && source.image );
+
+			const uint region = Api::Machine::NTSC|Api::Machine::PAL;
+
+			if (image && image->IsCloneOf( *source.image ) && !((state ^ source.state) & region))
+				return;
+
+			Unload();
+
+			state = (state & ~region) | (source.state & region);
+
+			{
+				Log::Suppressor logSupressor;
+				image = Image::Clone( *source.image, cpu, cpu.GetApu(), ppu );
+			}
+
+			state |= source.state & (Api::Machine::CARTRIDGE|Api::Machine::VS|Api::Machine::PC10);
+			clone = true;
+
+			UpdateModels();
+		}
+
+		void Machine::CloneState(const Machine& source)
+		{
+			NST_ASSERT( this != &source && image && image->IsCloneOf( *source.image ) );
+
+			if (!(state & Api::Machine::ON))
+				Reset( true );
+
+			std::stringstream stream;
+
+			{
+				State::Saver saver( &static_cast<std::ostream&>(stream), false, false );
+				source.SaveState( saver );
+			}
+
+			tracker.Resync();
+
+			State::Loader loader( &static_cast<std::istream&>(stream), false );
+			LoadState( loader, true );
+		}
+
+		Result Machine::ShareImageDatabase(const Machine& source)
+		{
+			if (source.imageDatabase == NULL)
+				return RESULT_ERR_NOT_READY;
+
+			if (imageDatabase == source.imageDatabase)
+				return RESULT_NOP;
+
+			if (!imageDatabaseShared)
+				delete imageDatabase;
+
+			imageDatabase = source.imageDatabase;
+			imageDatabaseShared = true;
+
+			return RESULT_OK;
+		}
+
 		#ifdef NST_MSVC_OPTIMIZE
 		#pragma optimize("", on)
 		#endif
@@ -518,7 +627,14 @@ namespace Nes
 				if (cheats)
 					cheats->BeginFrame( tracker.IsFrameLocked() );
 
-				cpu.ExecuteFrame( sound );
+				if (tracer)
+					cpu.SetTracer( tracer->BeginFrame( frame, cpu.GetModel(), cpu.GetFrameCycles(), ppu.IsShortFrame() ) ? tracer : NULL );
+
+				{
+					NST_PROFILE_SCOPE( Profiler::SECTION_CPU );
+					cpu.ExecuteFrame( sound );
+				}
+
 				ppu.EndFrame();
 
 				renderer.bgColor = ppu.output.bgColor;
@@ -534,13 +650,26 @@ namespace Nes
 				extPort->EndFrame();
 				expPort->EndFrame();
 
+				if (search)
+					search->EndFrame();
+
+				if (diff)
+					diff->EndFrame( frame );
+
 				frame++;
 			}
 			else
 			{
 				static_cast<Nsf*>(image)->BeginFrame();
 
-				cpu.ExecuteFrame( sound );
+				if (tracer)
+					cpu.SetTracer( tracer->BeginFrame( frame, cpu.GetModel(), cpu.GetFrameCycles(), false ) ? tracer : NULL );
+
+				{
+					NST_PROFILE_SCOPE( Profiler::SECTION_CPU );
+					cpu.ExecuteFrame( sound );
+				}
+
 				cpu.EndFrame();
 
 				image->VSync();
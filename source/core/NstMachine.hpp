@@ -31,6 +31,7 @@
 #include "NstPpu.hpp"
 #include "NstTracker.hpp"
 #include "NstVideoRenderer.hpp"
+#include "NstProfiler.hpp"
 
 #ifdef NST_PRAGMA_ONCE
 #pragma once
@@ -60,6 +61,11 @@ namespace Nes
 		class Image;
 		class Cheats;
 		class Homebrew;
+		class Tracer;
+		class CodeDataLogger;
+		class Debugger;
+		class RamSearch;
+		class MemoryDiff;
 		class ImageDatabase;
 
 		class Machine
@@ -101,6 +107,9 @@ namespace Nes
 			void   SwitchMode();
 			bool   LoadState(State::Loader&,bool);
 			void   SaveState(State::Saver&) const;
+			void   CloneImage(const Machine&);
+			void   CloneState(const Machine&);
+			Result ShareImageDatabase(const Machine&);
 			void   InitializeInputDevices() const;
 			Result UpdateColorMode();
 			Result UpdateColorMode(ColorMode);
@@ -131,10 +140,20 @@ namespace Nes
 			Image* image;
 			Cheats* cheats;
 			Homebrew* homebrew;
+			Tracer* tracer;
+			CodeDataLogger* cdl;
+			Debugger* debugger;
+			RamSearch* search;
+			MemoryDiff* diff;
 			ImageDatabase* imageDatabase;
+			ibool imageDatabaseShared;
+			ibool clone;
 			Tracker tracker;
 			Ppu ppu;
 			Video::Renderer renderer;
+		#ifdef NST_PROFILE
+			Profiler profiler;
+		#endif
 
 			uint Is(uint a) const
 			{
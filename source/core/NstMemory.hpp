@@ -26,6 +26,7 @@
 #define NST_MEMORY_H
 
 #include "NstRam.hpp"
+#include "NstProfiler.hpp"
 
 #ifdef NST_PRAGMA_ONCE
 #pragma once
@@ -261,6 +262,11 @@ namespace Nes
 				return sources[pages.ref[page]].Writable();
 			}
 
+			uint GetSource(uint page) const
+			{
+				return pages.ref[page];
+			}
+
 			const byte& Peek(uint address) const
 			{
 				return pages.mem[address >> MEM_PAGE_SHIFT][address & MEM_PAGE_MASK];
@@ -469,6 +475,7 @@ namespace Nes
 		void Memory<SPACE,U,V>::SwapBank(dword bank)
 		{
 			NST_COMPILE_ASSERT( (SPACE >= ADDRESS + SIZE) && SIZE && (SIZE % MEM_PAGE_SIZE == 0) );
+			NST_PROFILE_EVENT( Profiler::EVENT_BANK_SWITCHES );
 
 			enum
 			{
@@ -491,6 +498,7 @@ namespace Nes
 		{
 			NST_COMPILE_ASSERT( SIZE && (SIZE % MEM_PAGE_SIZE == 0) );
 			NST_ASSERT( SPACE >= address + SIZE );
+			NST_PROFILE_EVENT( Profiler::EVENT_BANK_SWITCHES );
 
 			enum
 			{
@@ -512,6 +520,7 @@ namespace Nes
 		void Memory<SPACE,U,V>::SwapBanks(dword bank0,dword bank1)
 		{
 			NST_COMPILE_ASSERT( (SPACE >= ADDRESS + SIZE * 2) && SIZE && (SIZE % MEM_PAGE_SIZE == 0) );
+			NST_PROFILE_EVENT( Profiler::EVENT_BANK_SWITCHES );
 
 			enum
 			{
@@ -534,6 +543,7 @@ namespace Nes
 		void Memory<SPACE,U,V>::SwapBanks(dword bank0,dword bank1,dword bank2,dword bank3)
 		{
 			NST_COMPILE_ASSERT( (SPACE >= ADDRESS + SIZE * 4) && SIZE && (SIZE % MEM_PAGE_SIZE == 0) );
+			NST_PROFILE_EVENT( Profiler::EVENT_BANK_SWITCHES );
 
 			enum
 			{
@@ -558,6 +568,7 @@ namespace Nes
 		void Memory<SPACE,U,V>::SwapBanks(dword bank0,dword bank1,dword bank2,dword bank3,dword bank4,dword bank5,dword bank6,dword bank7)
 		{
 			NST_COMPILE_ASSERT( (SPACE >= ADDRESS + SIZE * 4) && SIZE && (SIZE % MEM_PAGE_SIZE == 0) );
+			NST_PROFILE_EVENT( Profiler::EVENT_BANK_SWITCHES );
 
 			enum
 			{
@@ -587,6 +598,7 @@ namespace Nes
 		{
 			NST_COMPILE_ASSERT( SIZE && (SIZE % MEM_PAGE_SIZE == 0) );
 			NST_ASSERT( SPACE >= address + SIZE * 2 );
+			NST_PROFILE_EVENT( Profiler::EVENT_BANK_SWITCHES );
 
 			enum
 			{
@@ -610,6 +622,7 @@ namespace Nes
 		{
 			NST_COMPILE_ASSERT( SIZE && (SIZE % MEM_PAGE_SIZE == 0) );
 			NST_ASSERT( SPACE >= address + SIZE * 4 );
+			NST_PROFILE_EVENT( Profiler::EVENT_BANK_SWITCHES );
 
 			enum
 			{
@@ -635,6 +648,7 @@ namespace Nes
 		{
 			NST_COMPILE_ASSERT( SIZE && (SIZE % MEM_PAGE_SIZE == 0) );
 			NST_ASSERT( SPACE >= address + SIZE * 4 );
+			NST_PROFILE_EVENT( Profiler::EVENT_BANK_SWITCHES );
 
 			enum
 			{
@@ -663,6 +677,7 @@ namespace Nes
 		void Memory<SPACE,U,V>::SourceProxy::SwapBank(dword bank) const
 		{
 			NST_COMPILE_ASSERT( (SPACE >= ADDRESS + SIZE) && SIZE && (SIZE % MEM_PAGE_SIZE == 0) );
+			NST_PROFILE_EVENT( Profiler::EVENT_BANK_SWITCHES );
 
 			enum
 			{
@@ -687,6 +702,7 @@ namespace Nes
 		{
 			NST_COMPILE_ASSERT( SIZE && (SIZE % MEM_PAGE_SIZE == 0) );
 			NST_ASSERT( SPACE >= address + SIZE );
+			NST_PROFILE_EVENT( Profiler::EVENT_BANK_SWITCHES );
 
 			enum
 			{
@@ -0,0 +1,167 @@
+////////////////////////////////////////////////////////////////////////////////////////
+//
+// Nestopia - NES/Famicom emulator written in C++
+//
+// Copyright (C) 2003-2008 Martin Freij
+//
+// This file is part of Nestopia.
+//
+// Nestopia is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Nestopia is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Nestopia; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////////////
+
+
+#include <cstring>
+#include "NstCore.hpp"
+#include "NstMemoryDiff.hpp"
+
+namespace Nes
+{
+	namespace Core
+	{
+		#ifdef NST_MSVC_OPTIMIZE
+		#pragma optimize("s", on)
+		#endif
+
+		MemoryDiff::MemoryDiff(const Callback c,void* const u,const uint g)
+		:
+		callback   (c),
+		userData   (u),
+		gap        (g),
+		numRegions (0),
+		full       (true),
+		busy       (false)
+		{
+		}
+
+		MemoryDiff::~MemoryDiff()
+		{
+			for (uint i=0; i < numRegions; ++i)
+				delete [] regions[i].shadow;
+		}
+
+		void MemoryDiff::Add(const Api::MemoryDiff::Region id,const byte* const mem,const dword size)
+		{
+			NST_ASSERT( numRegions < MAX_REGIONS && mem && size );
+
+			Region& region = regions[numRegions];
+
+			region.id = id;
+			region.mem = mem;
+			region.shadow = new byte [size];
+			region.size = size;
+
+			++numRegions;
+			spans.Reserve( numRegions * 16 );
+		}
+
+		void MemoryDiff::Resync()
+		{
+			full = true;
+		}
+
+		#ifdef NST_MSVC_OPTIMIZE
+		#pragma optimize("", on)
+		#endif
+
+		void MemoryDiff::Compare(const uint index)
+		{
+			const Region& region = regions[index];
+			const byte* const mem = region.mem;
+			byte* const shadow = region.shadow;
+			const dword size = region.size;
+
+			Span span;
+			span.region = region.id;
+
+			for (dword i=0; i < size; )
+			{
+				// Runs of unchanged blocks are skipped with memcmp(), which
+				// the C library does with wide vector compares, so only the
+				// blocks holding a change are walked byte by byte.
+
+				if (i % BLOCK == 0 && i + BLOCK <= size && std::memcmp( mem + i, shadow + i, BLOCK ) == 0)
+				{
+					i += BLOCK;
+					continue;
+				}
+
+				if (mem[i] == shadow[i])
+				{
+					++i;
+					continue;
+				}
+
+				dword end = i + 1;
+
+				for (dword j=end, same=0; j < size; ++j)
+				{
+					if (mem[j] != shadow[j])
+					{
+						end = j + 1;
+						same = 0;
+					}
+					else if (++same > gap)
+					{
+						break;
+					}
+				}
+
+				span.offset = i;
+				span.length = end - i;
+				span.data = mem + i;
+				spans.Append( span );
+
+				std::memcpy( shadow + i, mem + i, end - i );
+				i = end;
+			}
+		}
+
+		void MemoryDiff::EndFrame(const dword frame)
+		{
+			spans.Clear();
+
+			if (full)
+			{
+				full = false;
+
+				for (uint i=0; i < numRegions; ++i)
+				{
+					Span span;
+
+					span.region = regions[i].id;
+					span.offset = 0;
+					span.length = regions[i].size;
+					span.data = regions[i].mem;
+					spans.Append( span );
+
+					std::memcpy( regions[i].shadow, regions[i].mem, regions[i].size );
+				}
+			}
+			else
+			{
+				for (uint i=0; i < numRegions; ++i)
+					Compare( i );
+			}
+
+			if (spans.Size())
+			{
+				busy = true;
+				callback( userData, frame, spans.Begin(), spans.Size() );
+				busy = false;
+			}
+		}
+	}
+}
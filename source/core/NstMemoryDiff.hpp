@@ -0,0 +1,91 @@
+////////////////////////////////////////////////////////////////////////////////////////
+//
+// Nestopia - NES/Famicom emulator written in C++
+//
+// Copyright (C) 2003-2008 Martin Freij
+//
+// This file is part of Nestopia.
+//
+// Nestopia is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Nestopia is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Nestopia; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef NST_MEMORYDIFF_H
+#define NST_MEMORYDIFF_H
+
+#ifdef NST_PRAGMA_ONCE
+#pragma once
+#endif
+
+#include "NstVector.hpp"
+#include "api/NstApiMemoryDiff.hpp"
+
+namespace Nes
+{
+	namespace Core
+	{
+		class MemoryDiff
+		{
+		public:
+
+			typedef Api::MemoryDiff::Span Span;
+			typedef Api::MemoryDiff::Callback Callback;
+
+			MemoryDiff(Callback,void*,uint);
+			~MemoryDiff();
+
+			void Add(Api::MemoryDiff::Region,const byte*,dword);
+			void Resync();
+			void EndFrame(dword);
+
+		private:
+
+			enum
+			{
+				MAX_REGIONS = 4,
+				BLOCK = 32
+			};
+
+			void Compare(uint);
+
+			struct Region
+			{
+				Api::MemoryDiff::Region id;
+				const byte* mem;
+				byte* shadow;
+				dword size;
+			};
+
+			const Callback callback;
+			void* const userData;
+			const uint gap;
+			uint numRegions;
+			ibool full;
+			ibool busy;
+			Region regions[MAX_REGIONS];
+			Vector<Span> spans;
+
+		public:
+
+			bool IsBusy() const
+			{
+				return busy;
+			}
+		};
+	}
+}
+
+#endif
@@ -25,7 +25,9 @@
 #include <cstring>
 #include "NstCpu.hpp"
 #include "NstPpu.hpp"
+#include "NstCodeDataLogger.hpp"
 #include "NstState.hpp"
+#include "NstProfiler.hpp"
 
 namespace Nes
 {
@@ -625,9 +627,14 @@ namespace Nes
 			return (*this)[3][address];
 		}
 
-		NST_FORCE_INLINE uint Ppu::Chr::FetchPattern(uint address) const
+		NST_FORCE_INLINE uint Ppu::Chr::FetchPattern(uint address,const uint access) const
 		{
-			return accessor.Fetch( address & 0x1FFF );
+			address &= 0x1FFF;
+
+			if (cdl)
+				cdl->LogChr( address, access );
+
+			return accessor.Fetch( address );
 		}
 
 		NST_FORCE_INLINE uint Ppu::Nmt::FetchName(uint address) const
@@ -695,12 +702,12 @@ namespace Nes
 
 		NST_FORCE_INLINE uint Ppu::FetchSpPattern() const
 		{
-			return chr.FetchPattern( io.address );
+			return chr.FetchPattern( io.address, CodeDataLogger::CHR_ACCESS_SPRITE );
 		}
 
 		NST_FORCE_INLINE void Ppu::FetchBgPattern0()
 		{
-			const uint pattern = chr.FetchPattern( io.address );
+			const uint pattern = chr.FetchPattern( io.address, CodeDataLogger::CHR_ACCESS_BG );
 
 			tiles.pattern[1] = pattern >> 0 & 0x55;
 			tiles.pattern[0] = pattern >> 1 & 0x55;
@@ -708,7 +715,7 @@ namespace Nes
 
 		NST_FORCE_INLINE void Ppu::FetchBgPattern1()
 		{
-			const uint pattern = chr.FetchPattern( io.address );
+			const uint pattern = chr.FetchPattern( io.address, CodeDataLogger::CHR_ACCESS_BG );
 
 			tiles.pattern[0] |= pattern << 0 & 0xAA;
 			tiles.pattern[1] |= pattern << 1 & 0xAA;
@@ -984,7 +991,7 @@ namespace Nes
 				UpdateAddressLine(scroll.address & 0x3fff);
 
 			io.latch = (address & 0x3F00) != 0x3F00 ? io.buffer : palette.ram[address & 0x1F] & Coloring();
-			io.buffer = (address >= 0x2000 ? nmt.FetchName( address ) : chr.FetchPattern( address ));
+			io.buffer = (address >= 0x2000 ? nmt.FetchName( address ) : chr.FetchPattern( address, CodeDataLogger::CHR_ACCESS_READ ));
 
 			return io.latch;
 		}
@@ -1338,8 +1345,8 @@ namespace Nes
 
 				const uint patterns[2] =
 				{
-					chr.FetchPattern( address | 0x0 ),
-					chr.FetchPattern( address | 0x8 )
+					chr.FetchPattern( address | 0x0, CodeDataLogger::CHR_ACCESS_SPRITE ),
+					chr.FetchPattern( address | 0x8, CodeDataLogger::CHR_ACCESS_SPRITE )
 				};
 
 				LoadSprite( patterns[0], patterns[1], buffer );
@@ -1408,6 +1415,7 @@ namespace Nes
 		NST_NO_INLINE void Ppu::Run()
 		{
 			NST_VERIFY( cycles.count != cycles.hClock );
+			NST_PROFILE_SCOPE( Profiler::SECTION_PPU );
 
 			if (regs.ctrl[1] & Regs::CTRL1_BG_SP_ENABLED)
 			{
@@ -43,6 +43,8 @@ namespace Nes
 {
 	namespace Core
 	{
+		class CodeDataLogger;
+
 		class Ppu
 		{
 		public:
@@ -128,7 +130,12 @@ namespace Nes
 
 			struct Chr : ChrMem
 			{
-				NST_FORCE_INLINE uint FetchPattern(uint) const;
+				Chr()
+				: cdl(NULL) {}
+
+				NST_FORCE_INLINE uint FetchPattern(uint,uint) const;
+
+				CodeDataLogger* cdl;
 			};
 
 			struct Nmt : NmtMem
@@ -479,6 +486,11 @@ namespace Nes
 				return palette;
 			}
 
+			const Oam& GetOam() const
+			{
+				return oam;
+			}
+
 			uint GetPixel(uint i) const
 			{
 				NST_ASSERT( i < Video::Screen::PIXELS );
@@ -496,6 +508,11 @@ namespace Nes
 				return chr;
 			}
 
+			void SetCdl(CodeDataLogger* cdl)
+			{
+				chr.cdl = cdl;
+			}
+
 			NmtMem& GetNmtMem()
 			{
 				return nmt;
@@ -0,0 +1,132 @@
+////////////////////////////////////////////////////////////////////////////////////////
+//
+// Nestopia - NES/Famicom emulator written in C++
+//
+// Copyright (C) 2003-2008 Martin Freij
+//
+// This file is part of Nestopia.
+//
+// Nestopia is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Nestopia is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Nestopia; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////////////
+
+#include "NstCore.hpp"
+#include "NstProfiler.hpp"
+
+#ifdef NST_PROFILE
+
+#include <cstring>
+
+#ifdef NST_WIN32
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+
+#include <windows.h>
+
+#else
+
+#include <time.h>
+
+#endif
+
+namespace Nes
+{
+	namespace Core
+	{
+		#ifdef NST_MSVC_OPTIMIZE
+		#pragma optimize("s", on)
+		#endif
+
+		NST_PROFILE_TLS Profiler* Profiler::current = NULL;
+
+		Profiler::Profiler()
+		:
+		section    (SECTION_OTHER),
+		depth      (0),
+		mark       (0),
+		start      (0),
+		lastTime   (0),
+		totalTicks (0),
+		totalTime  (0),
+		frames     (0)
+		{
+			std::memset( &counters, 0, sizeof(counters) );
+			std::memset( &last, 0, sizeof(last) );
+		}
+
+		qaword Profiler::Clock()
+		{
+		#ifdef NST_WIN32
+
+			static LARGE_INTEGER frequency;
+
+			if (!frequency.QuadPart)
+				::QueryPerformanceFrequency( &frequency );
+
+			LARGE_INTEGER count;
+			::QueryPerformanceCounter( &count );
+
+			return qaword(count.QuadPart / frequency.QuadPart) * 1000000000UL +
+				qaword(count.QuadPart % frequency.QuadPart) * 1000000000UL / qaword(frequency.QuadPart);
+
+		#else
+
+			timespec time;
+			clock_gettime( CLOCK_MONOTONIC, &time );
+
+			return qaword(time.tv_sec) * 1000000000UL + time.tv_nsec;
+
+		#endif
+		}
+
+		#ifdef NST_MSVC_OPTIMIZE
+		#pragma optimize("", on)
+		#endif
+
+		void Profiler::BeginFrame()
+		{
+			std::memset( &counters, 0, sizeof(counters) );
+
+			current = this;
+			section = SECTION_OTHER;
+			depth = 0;
+			start = Clock();
+			mark = Ticks();
+		}
+
+		void Profiler::EndFrame()
+		{
+			const qaword now = Ticks();
+			counters.ticks[section] += now - mark;
+
+			// time stamp counter rate is learned from the wall clock as frames go by
+
+			lastTime = Clock() - start;
+			totalTime += lastTime;
+
+			for (uint i=0; i < NUM_SECTIONS; ++i)
+				totalTicks += counters.ticks[i];
+
+			last = counters;
+			++frames;
+
+			current = NULL;
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,251 @@
+////////////////////////////////////////////////////////////////////////////////////////
+//
+// Nestopia - NES/Famicom emulator written in C++
+//
+// Copyright (C) 2003-2008 Martin Freij
+//
+// This file is part of Nestopia.
+//
+// Nestopia is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Nestopia is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Nestopia; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef NST_PROFILER_H
+#define NST_PROFILER_H
+
+#ifdef NST_PRAGMA_ONCE
+#pragma once
+#endif
+
+#ifdef NST_PROFILE
+
+#if NST_MSVC >= 1400 && (defined(_M_IX86) || defined(_M_X64))
+#include <intrin.h>
+#define NST_PROFILE_RDTSC() __rdtsc()
+#elif NST_GCC >= 405 && (defined(__i386__) || defined(__x86_64__))
+#define NST_PROFILE_RDTSC() __builtin_ia32_rdtsc()
+#endif
+
+#if NST_MSVC
+#define NST_PROFILE_TLS __declspec(thread)
+#else
+#define NST_PROFILE_TLS __thread
+#endif
+
+namespace Nes
+{
+	namespace Core
+	{
+		class Profiler
+		{
+		public:
+
+			Profiler();
+
+			enum Section
+			{
+				SECTION_OTHER,
+				SECTION_CPU,
+				SECTION_PPU,
+				SECTION_APU,
+				SECTION_BLIT,
+				SECTION_VIDEO_LOCK,
+				SECTION_SOUND_LOCK,
+				SECTION_REWINDER,
+				SECTION_MOVIE,
+				NUM_SECTIONS
+			};
+
+			enum Event
+			{
+				EVENT_INSTRUCTIONS,
+				EVENT_BANK_SWITCHES,
+				EVENT_IRQS,
+				EVENT_NMIS,
+				EVENT_DMC_DMAS,
+				NUM_EVENTS
+			};
+
+			enum
+			{
+				REGION_SHIFT = 13,
+				NUM_REGIONS = 8,
+				MAX_DEPTH = 16
+			};
+
+			struct Counters
+			{
+				qaword ticks[NUM_SECTIONS];
+				dword events[NUM_EVENTS];
+				dword reads[NUM_REGIONS];
+				dword writes[NUM_REGIONS];
+			};
+
+			void BeginFrame();
+			void EndFrame();
+
+			static qaword Clock();
+
+			static qaword Ticks()
+			{
+			#ifdef NST_PROFILE_RDTSC
+				return NST_PROFILE_RDTSC();
+			#else
+				return Clock();
+			#endif
+			}
+
+			void Enter(Section next)
+			{
+				const qaword now = Ticks();
+				counters.ticks[section] += now - mark;
+				mark = now;
+
+				if (depth < MAX_DEPTH)
+					stack[depth] = section;
+
+				++depth;
+				section = next;
+			}
+
+			void Leave()
+			{
+				const qaword now = Ticks();
+				counters.ticks[section] += now - mark;
+				mark = now;
+
+				if (depth)
+				{
+					--depth;
+					section = (depth < MAX_DEPTH ? Section(stack[depth]) : SECTION_OTHER);
+				}
+			}
+
+			// nothing is counted outside a frame, where there's no profiler
+			// of the running emulator to count into
+
+			static void EnterCurrent(Section next)
+			{
+				if (current)
+					current->Enter( next );
+			}
+
+			static void LeaveCurrent()
+			{
+				if (current)
+					current->Leave();
+			}
+
+			static void Count(Event event)
+			{
+				if (current)
+					++current->counters.events[event];
+			}
+
+			static void CountRead(uint address)
+			{
+				if (current)
+					++current->counters.reads[address >> REGION_SHIFT];
+			}
+
+			static void CountWrite(uint address)
+			{
+				if (current)
+					++current->counters.writes[address >> REGION_SHIFT];
+			}
+
+			class Scope
+			{
+				Profiler* const profiler;
+
+			public:
+
+				explicit Scope(Section section)
+				: profiler(current)
+				{
+					if (profiler)
+						profiler->Enter( section );
+				}
+
+				~Scope()
+				{
+					if (profiler)
+						profiler->Leave();
+				}
+			};
+
+			class Frame
+			{
+				Profiler* const profiler;
+
+			public:
+
+				explicit Frame(Profiler& p)
+				: profiler(current ? NULL : &p)
+				{
+					if (profiler)
+						profiler->BeginFrame();
+				}
+
+				~Frame()
+				{
+					if (profiler)
+						profiler->EndFrame();
+				}
+			};
+
+			static NST_PROFILE_TLS Profiler* current;
+
+		private:
+
+			Section section;
+			uint depth;
+			qaword mark;
+			qaword start;
+			byte stack[MAX_DEPTH];
+
+		public:
+
+			Counters counters;
+			Counters last;
+			qaword lastTime;
+			qaword totalTicks;
+			qaword totalTime;
+			dword frames;
+		};
+	}
+}
+
+#define NST_PROFILE_SCOPE(section_) const Profiler::Scope profileScope( section_ )
+#define NST_PROFILE_ENTER(section_) Profiler::EnterCurrent( section_ )
+#define NST_PROFILE_LEAVE() Profiler::LeaveCurrent()
+#define NST_PROFILE_FRAME(profiler_) const Profiler::Frame profileFrame( profiler_ )
+#define NST_PROFILE_EVENT(event_) Profiler::Count( event_ )
+#define NST_PROFILE_READ(address_) Profiler::CountRead( address_ )
+#define NST_PROFILE_WRITE(address_) Profiler::CountWrite( address_ )
+
+#else
+
+#define NST_PROFILE_SCOPE(section_)
+#define NST_PROFILE_ENTER(section_)
+#define NST_PROFILE_LEAVE()
+#define NST_PROFILE_FRAME(profiler_)
+#define NST_PROFILE_EVENT(event_)
+#define NST_PROFILE_READ(address_)
+#define NST_PROFILE_WRITE(address_)
+
+#endif
+
+#endif
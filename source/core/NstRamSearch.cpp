@@ -0,0 +1,198 @@
+////////////////////////////////////////////////////////////////////////////////////////
+//
+// Nestopia - NES/Famicom emulator written in C++
+//
+// Copyright (C) 2003-2008 Martin Freij
+//
+// This file is part of Nestopia.
+//
+// Nestopia is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Nestopia is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Nestopia; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////////////
+
+
+#include <cstring>
+#include "NstCore.hpp"
+#include "NstAssert.hpp"
+#include "NstRamSearch.hpp"
+
+namespace Nes
+{
+	namespace Core
+	{
+		#ifdef NST_MSVC_OPTIMIZE
+		#pragma optimize("s", on)
+		#endif
+
+		RamSearch::RamSearch(const byte* const m,const dword s,const uint w,const bool sign)
+		:
+		mem        (m),
+		size       (s),
+		width      (w),
+		mask       (w < 4 ? (1UL << w * 8) - 1 : 0xFFFFFFFF),
+		bias       (sign ? 1UL << (w * 8 - 1) : 0),
+		length     (s >= w ? s - w + 1 : 0),
+		count      (length),
+		candidates (new dword [(length + BITS - 1) / BITS + (s + 3) / 4]),
+		previous   (reinterpret_cast<byte*>(candidates + (length + BITS - 1) / BITS))
+		{
+			NST_ASSERT( w == 1 || w == 2 || w == 4 );
+
+			const dword words = (length + BITS - 1) / BITS;
+
+			for (dword i=0; i < words; ++i)
+				candidates[i] = 0xFFFFFFFF;
+
+			if (length % BITS)
+				candidates[words-1] = (1UL << length % BITS) - 1;
+
+			scheduled.frames = 0;
+			scheduled.compare = Api::RamSearch::COMPARE_EQUAL;
+			scheduled.operand = Api::RamSearch::OPERAND_PREVIOUS;
+			scheduled.value = 0;
+
+			Snapshot();
+		}
+
+		RamSearch::~RamSearch()
+		{
+			delete [] candidates;
+		}
+
+		void RamSearch::Schedule(const dword frames,const Compare compare,const Operand operand,const dword value)
+		{
+			scheduled.frames = frames;
+			scheduled.compare = compare;
+			scheduled.operand = operand;
+			scheduled.value = value;
+		}
+
+		dword RamSearch::Next(const dword from) const
+		{
+			for (dword i=from / BITS, n=(length + BITS - 1) / BITS; i < n; ++i)
+			{
+				dword bits = candidates[i];
+
+				if (i == from / BITS)
+					bits &= 0xFFFFFFFF << from % BITS;
+
+				if (bits)
+				{
+					dword address = i * BITS;
+
+					while (!(bits & 0x1))
+					{
+						bits >>= 1;
+						++address;
+					}
+
+					return address;
+				}
+			}
+
+			return NONE;
+		}
+
+		dword RamSearch::GetValue(const dword address,const bool old) const
+		{
+			NST_ASSERT( address < length );
+
+			return Read( (old ? previous : mem) + address );
+		}
+
+		#ifdef NST_MSVC_OPTIMIZE
+		#pragma optimize("", on)
+		#endif
+
+		inline dword RamSearch::Read(const byte* const data) const
+		{
+			dword value = 0;
+
+			for (uint i=width; i--; )
+				value = value << 8 | data[i];
+
+			return value;
+		}
+
+		inline bool RamSearch::Test(const Compare compare,const dword a,const dword b)
+		{
+			switch (compare)
+			{
+				case Api::RamSearch::COMPARE_NOT_EQUAL:     return a != b;
+				case Api::RamSearch::COMPARE_LESS:          return a <  b;
+				case Api::RamSearch::COMPARE_LESS_EQUAL:    return a <= b;
+				case Api::RamSearch::COMPARE_GREATER:       return a >  b;
+				case Api::RamSearch::COMPARE_GREATER_EQUAL: return a >= b;
+				default:                                    return a == b;
+			}
+		}
+
+		void RamSearch::Snapshot()
+		{
+			std::memcpy( previous, mem, size );
+		}
+
+		void RamSearch::Filter(const Compare compare,const Operand operand,dword value)
+		{
+			// The candidates are a bitset, so whole words of rejected addresses
+			// are skipped at once. Signed values are compared as unsigned ones
+			// with the sign bit flipped, which keeps their order.
+
+			const bool changed = (compare == Api::RamSearch::COMPARE_CHANGED_BY);
+			const bool constant = (!changed && operand == Api::RamSearch::OPERAND_VALUE);
+
+			value = (value & mask) ^ (changed ? 0 : bias);
+
+			for (dword i=0, n=(length + BITS - 1) / BITS; i < n; ++i)
+			{
+				dword bits = candidates[i];
+
+				if (!bits)
+					continue;
+
+				for (dword bit=0; bit < BITS && (bits >> bit); ++bit)
+				{
+					if (bits & (1UL << bit))
+					{
+						const dword address = i * BITS + bit;
+						dword current = Read( mem + address );
+						dword reference;
+
+						if (changed)
+						{
+							current = (current - Read( previous + address )) & mask;
+							reference = value;
+						}
+						else
+						{
+							current ^= bias;
+							reference = constant ? value : Read( previous + address ) ^ bias;
+						}
+
+						if (!Test( changed ? Api::RamSearch::COMPARE_EQUAL : compare, current, reference ))
+						{
+							bits &= ~(1UL << bit);
+							--count;
+						}
+					}
+				}
+
+				candidates[i] = bits;
+			}
+
+			Snapshot();
+		}
+	}
+}
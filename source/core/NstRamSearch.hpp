@@ -0,0 +1,131 @@
+////////////////////////////////////////////////////////////////////////////////////////
+//
+// Nestopia - NES/Famicom emulator written in C++
+//
+// Copyright (C) 2003-2008 Martin Freij
+//
+// This file is part of Nestopia.
+//
+// Nestopia is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Nestopia is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Nestopia; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef NST_RAMSEARCH_H
+#define NST_RAMSEARCH_H
+
+#ifdef NST_PRAGMA_ONCE
+#pragma once
+#endif
+
+#include "api/NstApiRamSearch.hpp"
+
+namespace Nes
+{
+	namespace Core
+	{
+		class RamSearch
+		{
+		public:
+
+			typedef Api::RamSearch::Compare Compare;
+			typedef Api::RamSearch::Operand Operand;
+
+			enum
+			{
+				NONE = 0xFFFFFFFF
+			};
+
+			RamSearch(const byte*,dword,uint,bool);
+			~RamSearch();
+
+			void Snapshot();
+			void Filter(Compare,Operand,dword);
+			void Schedule(dword,Compare,Operand,dword);
+			dword Next(dword) const;
+			dword GetValue(dword,bool) const;
+
+			inline void EndFrame();
+
+		private:
+
+			enum
+			{
+				BITS = 32
+			};
+
+			inline dword Read(const byte*) const;
+			static inline bool Test(Compare,dword,dword);
+
+			const byte* const mem;
+			const dword size;
+			const uint width;
+			const dword mask;
+			const dword bias;
+			const dword length;
+			dword count;
+			dword* const candidates;
+			byte* const previous;
+
+			struct Scheduled
+			{
+				dword frames;
+				Compare compare;
+				Operand operand;
+				dword value;
+			};
+
+			Scheduled scheduled;
+
+		public:
+
+			dword NumCandidates() const
+			{
+				return count;
+			}
+
+			dword NumScheduled() const
+			{
+				return scheduled.frames;
+			}
+
+			dword Size() const
+			{
+				return size;
+			}
+
+			bool IsSigned() const
+			{
+				return bias != 0;
+			}
+
+			uint Width() const
+			{
+				return width;
+			}
+		};
+
+		inline void RamSearch::EndFrame()
+		{
+			if (scheduled.frames)
+			{
+				--scheduled.frames;
+				Filter( scheduled.compare, scheduled.operand, scheduled.value );
+			}
+		}
+	}
+}
+
+#endif
@@ -41,8 +41,129 @@ namespace Nes
 			#pragma optimize("s", on)
 			#endif
 
+			Layout::Layout()
+			{
+			}
+
+			Layout::~Layout()
+			{
+			}
+
+			void Layout::Clear()
+			{
+				chunks.Clear();
+				blocks.Clear();
+			}
+
+			void Layout::AddChunk(const dword pos,const dword length)
+			{
+				// chunks are closed inner-most first, keep them sorted by position
+
+				Mark* it = chunks.End();
+
+				while (it != chunks.Begin() && it[-1].pos > pos)
+					--it;
+
+				const Mark mark = {pos,length};
+				chunks.Insert( it, mark );
+			}
+
+			void Layout::AddBlock(const dword pos,const dword length)
+			{
+				NST_ASSERT( !blocks.Size() || blocks.Back().pos < pos );
+
+				const Mark mark = {pos,length};
+				blocks.Append( mark );
+			}
+
+			void Layout::Write(const byte* const data,const dword size,StdStream p,const bool compress) const
+			{
+				Stream::Out stream( p );
+
+				if (!Zlib::AVAILABLE || !compress || !blocks.Size())
+				{
+					stream.Write( data, size );
+					return;
+				}
+
+				Vector<dword> packed( blocks.Size() );
+				Vector<byte> output;
+
+				{
+					Vector<byte> buffer;
+
+					for (dword i=0; i < blocks.Size(); ++i)
+					{
+						const Mark& block = blocks[i];
+						buffer.Resize( block.length - 1 );
+
+						packed[i] = Zlib::Compress( data + block.pos + 1, block.length, buffer.Begin(), buffer.Size(), Zlib::BEST_COMPRESSION );
+
+						if (packed[i])
+							output.Append( buffer.Begin(), packed[i] );
+					}
+				}
+
+				Vector<dword> lengths( chunks.Size() );
+
+				for (dword i=0; i < chunks.Size(); ++i)
+				{
+					const Mark& chunk = chunks[i];
+					lengths[i] = chunk.length;
+
+					for (dword j=0; j < blocks.Size(); ++j)
+					{
+						if (packed[j] && blocks[j].pos >= chunk.pos + 4 + 4 && blocks[j].pos < chunk.pos + 4 + 4 + chunk.length)
+							lengths[i] -= blocks[j].length - packed[j];
+					}
+				}
+
+				const byte* next = output.Begin();
+				dword offset = 0;
+
+				for (dword c=0, b=0; c < chunks.Size() || b < blocks.Size(); )
+				{
+					if (b == blocks.Size() || (c < chunks.Size() && chunks[c].pos < blocks[b].pos))
+					{
+						const dword pos = chunks[c].pos + 4;
+
+						stream.Write( data + offset, pos - offset );
+						stream.Write32( lengths[c++] );
+
+						offset = pos + 4;
+					}
+					else if (packed[b])
+					{
+						const dword pos = blocks[b].pos;
+
+						if (pos > offset)
+							stream.Write( data + offset, pos - offset );
+
+						stream.Write8( ZLIB_COMPRESSION );
+						stream.Write( next, packed[b] );
+
+						next += packed[b];
+						offset = pos + 1 + blocks[b++].length;
+					}
+					else
+					{
+						++b;
+					}
+				}
+
+				if (size > offset)
+					stream.Write( data + offset, size - offset );
+			}
+
+			Hash::Hash(dword e)
+			: count(0), excluded(e)
+			{
+				lanes[0] = 0x9E3779B9;
+				lanes[1] = 0x7F4A7C15;
+			}
+
 			Saver::Saver(StdStream p,bool c,bool i,dword append)
-			: stream(p), chunks(CHUNK_RESERVE), useCompression(c), internal(i)
+			: stream(p), chunks(CHUNK_RESERVE), layout(NULL), hash(NULL), skip(0), useCompression(c), internal(i)
 			{
 				NST_COMPILE_ASSERT( CHUNK_RESERVE >= 2 );
 
@@ -57,6 +178,22 @@ namespace Nes
 				}
 			}
 
+			Saver::Saver(StdStream p,Layout& l)
+			: stream(p), chunks(CHUNK_RESERVE), layout(&l), hash(NULL), skip(0), useCompression(false), internal(false)
+			{
+				chunks.SetTo(1);
+				chunks.Front() = 0;
+
+				layout->Clear();
+			}
+
+			Saver::Saver(Hash& h)
+			: stream(&h), chunks(CHUNK_RESERVE), layout(NULL), hash(&h), skip(0), useCompression(false), internal(false)
+			{
+				chunks.SetTo(1);
+				chunks.Front() = 0;
+			}
+
 			Saver::~Saver()
 			{
 				NST_VERIFY( chunks.Size() == 1 );
@@ -66,22 +203,146 @@ namespace Nes
 			#pragma optimize("", on)
 			#endif
 
+			inline void Hash::Mix(dword k)
+			{
+				// MurmurHash3 rounds over two interleaved lanes
+
+				k = (k * 0xCC9E2D51) & 0xFFFFFFFF;
+				k = ((k << 15 | k >> 17) * 0x1B873593) & 0xFFFFFFFF;
+
+				dword& h = lanes[count++ & 0x1];
+
+				h = (h ^ k) & 0xFFFFFFFF;
+				h = ((h << 13 | h >> 19) * 5 + 0xE6546B64) & 0xFFFFFFFF;
+			}
+
+			void Hash::Update(dword data)
+			{
+				Mix( data & 0xFFFFFFFF );
+			}
+
+			void Hash::Update(const byte* NST_RESTRICT data,const dword length)
+			{
+				const byte* const end = data + (length & ~dword(0x3));
+
+				if (!(count & 0x1) && length >= 8)
+				{
+					// same rounds as Mix() with both lanes kept in registers
+
+					dword h0 = lanes[0], h1 = lanes[1];
+
+					for (const byte* const pairs = data + (length & ~dword(0x7)); data != pairs; data += 8)
+					{
+						dword k0 = data[0] | uint(data[1]) << 8 | dword(data[2]) << 16 | dword(data[3]) << 24;
+						dword k1 = data[4] | uint(data[5]) << 8 | dword(data[6]) << 16 | dword(data[7]) << 24;
+
+						k0 = (k0 * 0xCC9E2D51) & 0xFFFFFFFF;
+						k1 = (k1 * 0xCC9E2D51) & 0xFFFFFFFF;
+						k0 = ((k0 << 15 | k0 >> 17) * 0x1B873593) & 0xFFFFFFFF;
+						k1 = ((k1 << 15 | k1 >> 17) * 0x1B873593) & 0xFFFFFFFF;
+
+						h0 ^= k0;
+						h1 ^= k1;
+						h0 = ((h0 << 13 | h0 >> 19) * 5 + 0xE6546B64) & 0xFFFFFFFF;
+						h1 = ((h1 << 13 | h1 >> 19) * 5 + 0xE6546B64) & 0xFFFFFFFF;
+					}
+
+					lanes[0] = h0;
+					lanes[1] = h1;
+					count += (length >> 2) & ~dword(0x1);
+				}
+
+				for (; data != end; data += 4)
+					Mix( data[0] | uint(data[1]) << 8 | dword(data[2]) << 16 | dword(data[3]) << 24 );
+
+				if (const uint tail = length & 0x3)
+				{
+					dword last = 0;
+
+					for (uint i=0; i < tail; ++i)
+						last |= dword(data[i]) << (i * 8);
+
+					Mix( last );
+				}
+
+				Mix( length & 0xFFFFFFFF );
+			}
+
+			void Hash::Digest(dword& hi,dword& lo) const
+			{
+				dword h[2] =
+				{
+					(lanes[0] ^ count) & 0xFFFFFFFF,
+					(lanes[1] ^ count) & 0xFFFFFFFF
+				};
+
+				h[0] = (h[0] + h[1]) & 0xFFFFFFFF;
+				h[1] = (h[1] + h[0]) & 0xFFFFFFFF;
+
+				for (uint i=0; i < 2; ++i)
+				{
+					h[i] ^= h[i] >> 16;
+					h[i] = (h[i] * 0x85EBCA6B) & 0xFFFFFFFF;
+					h[i] ^= h[i] >> 13;
+					h[i] = (h[i] * 0xC2B2AE35) & 0xFFFFFFFF;
+					h[i] ^= h[i] >> 16;
+				}
+
+				h[0] = (h[0] + h[1]) & 0xFFFFFFFF;
+				h[1] = (h[1] + h[0]) & 0xFFFFFFFF;
+
+				hi = h[1];
+				lo = h[0];
+			}
+
 			Saver& Saver::Begin(dword chunk)
 			{
-				stream.Write32( chunk );
-				stream.Write32( 0 );
+				if (hash)
+				{
+					if (skip || chunk == hash->excluded)
+						++skip;
+					else
+						hash->Update( chunk );
+				}
+				else
+				{
+					stream.Write32( chunk );
+					stream.Write32( 0 );
+				}
+
 				chunks.Append( 0 );
 
 				return *this;
 			}
 
+			dword Saver::Tell() const
+			{
+				dword pos = (chunks.Size() - 1) * (4 + 4);
+
+				for (dword i=0; i < chunks.Size(); ++i)
+					pos += chunks[i];
+
+				return pos;
+			}
+
 			Saver& Saver::End()
 			{
 				NST_ASSERT( chunks.Size() > 1 );
 
+				if (layout)
+					layout->AddChunk( Tell() - (4 + 4 + chunks.Back()), chunks.Back() );
+
 				const dword written = chunks.Pop();
 				chunks.Back() += 4 + 4 + written;
 
+				if (hash)
+				{
+					if (skip)
+						--skip;
+
+					return *this;
+				}
+
 				stream.Seek( -idword(written + 4) );
 				stream.Write32( written );
 				stream.Seek( written );
@@ -92,35 +353,88 @@ namespace Nes
 			Saver& Saver::Write8(uint data)
 			{
 				chunks.Back() += 1;
-				stream.Write8( data );
+
+				if (hash)
+				{
+					if (!skip)
+						hash->Update( data );
+				}
+				else
+				{
+					stream.Write8( data );
+				}
+
 				return *this;
 			}
 
 			Saver& Saver::Write16(uint data)
 			{
 				chunks.Back() += 2;
-				stream.Write16( data );
+
+				if (hash)
+				{
+					if (!skip)
+						hash->Update( data );
+				}
+				else
+				{
+					stream.Write16( data );
+				}
+
 				return *this;
 			}
 
 			Saver& Saver::Write32(dword data)
 			{
 				chunks.Back() += 4;
-				stream.Write32( data );
+
+				if (hash)
+				{
+					if (!skip)
+						hash->Update( data );
+				}
+				else
+				{
+					stream.Write32( data );
+				}
+
 				return *this;
 			}
 
 			Saver& Saver::Write64(qaword data)
 			{
 				chunks.Back() += 8;
-				stream.Write64( data );
+
+				if (hash)
+				{
+					if (!skip)
+					{
+						hash->Update( dword(data & 0xFFFFFFFF) );
+						hash->Update( dword(data >> 32) );
+					}
+				}
+				else
+				{
+					stream.Write64( data );
+				}
+
 				return *this;
 			}
 
 			Saver& Saver::Write(const byte* data,dword length)
 			{
 				chunks.Back() += length;
-				stream.Write( data, length );
+
+				if (hash)
+				{
+					if (!skip)
+						hash->Update( data, length );
+				}
+				else
+				{
+					stream.Write( data, length );
+				}
+
 				return *this;
 			}
 
@@ -128,6 +442,14 @@ namespace Nes
 			{
 				NST_VERIFY( length );
 
+				if (hash)
+				{
+					if (!skip)
+						hash->Update( data, length );
+
+					return *this;
+				}
+
 				if (Zlib::AVAILABLE && useCompression && length > 1)
 				{
 					Vector<byte> buffer( length - 1 );
@@ -140,6 +462,10 @@ namespace Nes
 						return *this;
 					}
 				}
+				else if (layout && length > 1)
+				{
+					layout->AddBlock( Tell(), length );
+				}
 
 				chunks.Back() += 1 + length;
 				stream.Write8( NO_COMPRESSION );
@@ -213,6 +539,18 @@ namespace Nes
 					stream.Seek( back );
 			}
 
+			void Loader::Seek(const dword left)
+			{
+				// move within the current chunk to where the given number of bytes remain
+
+				NST_ASSERT( chunks.Size() );
+
+				if (const idword offset = idword(chunks.Back()) - idword(left))
+					stream.Seek( offset );
+
+				chunks.Back() = left;
+			}
+
 			void Loader::CheckRead(dword length)
 			{
 				if (chunks.Back() >= length)
@@ -41,11 +41,61 @@ namespace Nes
 	{
 		namespace State
 		{
+			class Layout
+			{
+			public:
+
+				Layout();
+				~Layout();
+
+				void Clear();
+				void Write(const byte*,dword,StdStream,bool) const;
+
+			private:
+
+				friend class Saver;
+
+				struct Mark
+				{
+					dword pos;
+					dword length;
+				};
+
+				void AddChunk(dword,dword);
+				void AddBlock(dword,dword);
+
+				Vector<Mark> chunks;
+				Vector<Mark> blocks;
+			};
+
+			class Hash
+			{
+			public:
+
+				explicit Hash(dword=0);
+
+				void Update(dword);
+				void Update(const byte*,dword);
+				void Digest(dword&,dword&) const;
+
+			private:
+
+				friend class Saver;
+
+				void Mix(dword);
+
+				dword lanes[2];
+				dword count;
+				const dword excluded;
+			};
+
 			class Saver
 			{
 			public:
 
 				Saver(StdStream,bool,bool,dword=0);
+				Saver(StdStream,Layout&);
+				explicit Saver(Hash&);
 				~Saver();
 
 				Saver& Begin(dword);
@@ -61,6 +111,8 @@ namespace Nes
 
 				Stream::Out stream;
 
+				dword Tell() const;
+
 			private:
 
 				enum
@@ -69,6 +121,9 @@ namespace Nes
 				};
 
 				Vector<dword> chunks;
+				Layout* const layout;
+				Hash* const hash;
+				dword skip;
 				const bool useCompression;
 				const bool internal;
 
@@ -112,6 +167,7 @@ namespace Nes
 				void  Uncompress(byte*,dword);
 				void  End();
 				void  End(dword);
+				void  Seek(dword);
 
 				template<uint N>
 				class Data
@@ -0,0 +1,250 @@
+////////////////////////////////////////////////////////////////////////////////////////
+//
+// Nestopia - NES/Famicom emulator written in C++
+//
+// Copyright (C) 2003-2008 Martin Freij
+//
+// This file is part of Nestopia.
+//
+// Nestopia is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Nestopia is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Nestopia; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////////////
+
+#include "NstCore.hpp"
+#include "NstStream.hpp"
+#include "NstTracer.hpp"
+
+namespace Nes
+{
+	namespace Core
+	{
+		#ifdef NST_MSVC_OPTIMIZE
+		#pragma optimize("s", on)
+		#endif
+
+		enum
+		{
+			TRACE_VERSION = 1,
+			TRACE_BLOCK = 256
+		};
+
+		Tracer::Tracer()
+		:
+		entries   (NULL),
+		size      (0),
+		pos       (0),
+		count     (0),
+		remaining (0),
+		state     (STOPPED),
+		frame     (0),
+		model     (CPU_RP2A03),
+		offset    (0),
+		ppuRecip  (0),
+		firstLine (0),
+		preLine   (0),
+		skip      (0),
+		busy      (false)
+		{
+		}
+
+		Tracer::~Tracer()
+		{
+			delete [] entries;
+		}
+
+		void Tracer::Start(const dword length,const Trigger& t,const dword limit)
+		{
+			NST_ASSERT( length );
+
+			if (size != length)
+			{
+				delete [] entries;
+				entries = NULL;
+				size = 0;
+
+				entries = new Entry [length];
+				size = length;
+			}
+
+			pos = 0;
+			count = 0;
+			remaining = limit;
+			trigger = t;
+			state = WAITING;
+		}
+
+		void Tracer::Stop()
+		{
+			state = STOPPED;
+		}
+
+		bool Tracer::BeginFrame(const dword number,const CpuModel cpuModel,const Cycle frameCycles,const bool shortFrame)
+		{
+			if (state == WAITING && trigger.type == Api::Tracer::TRIGGER_FRAME)
+			{
+				if (number < trigger.frame)
+					return false;
+
+				state = RECORDING;
+			}
+
+			if (state == STOPPED)
+				return false;
+
+			frame = number;
+			model = cpuModel;
+
+			// Frames begin with vblank. Positions are worked out from the
+			// cycle count rather than by catching up the PPU, which would
+			// clock DMC fetches at points the untraced run does not.
+
+			dword clock, hvsync, vsync, vint;
+
+			switch (model)
+			{
+				case CPU_RP2A07:
+
+					clock = PPU_RP2C07_CC;
+					hvsync = PPU_RP2C07_HVSYNC;
+					vsync = PPU_RP2C07_VSYNC;
+					vint = PPU_RP2C07_VINT;
+					break;
+
+				case CPU_DENDY:
+
+					clock = PPU_DENDY_CC;
+					hvsync = PPU_DENDY_HVSYNC;
+					vsync = PPU_DENDY_VSYNC;
+					vint = PPU_DENDY_VINT;
+					break;
+
+				default:
+
+					clock = PPU_RP2C02_CC;
+					hvsync = PPU_RP2C02_HVSYNC_0;
+					vsync = PPU_RP2C02_VSYNC;
+					vint = PPU_RP2C02_VINT;
+					break;
+			}
+
+			// the first frame after power-on is a short one that ends with vblank
+			offset = (frameCycles + clock < hvsync ? hvsync - frameCycles : 0) + (model == CPU_RP2A03 ? 0 : clock - 1);
+			ppuRecip = dword(((qaword(1) << 32) + clock - 1) / clock);
+			firstLine = vsync - vint - 1;
+			preLine = vint;
+			skip = shortFrame ? vint * 341 + 340 : ~dword(0);
+
+			return true;
+		}
+
+		void Tracer::Pack(const Entry& entry,byte* const data)
+		{
+			data[0]  = entry.frame >>  0 & 0xFF;
+			data[1]  = entry.frame >>  8 & 0xFF;
+			data[2]  = entry.frame >> 16 & 0xFF;
+			data[3]  = entry.frame >> 24 & 0xFF;
+			data[4]  = entry.cycle >>  0 & 0xFF;
+			data[5]  = entry.cycle >>  8 & 0xFF;
+			data[6]  = entry.cycle >> 16 & 0xFF;
+			data[7]  = entry.cycle >> 24 & 0xFF;
+			data[8]  = entry.pc & 0xFF;
+			data[9]  = entry.pc >> 8;
+			data[10] = entry.opcode;
+			data[11] = entry.a;
+			data[12] = entry.x;
+			data[13] = entry.y;
+			data[14] = entry.sp;
+			data[15] = entry.p;
+			data[16] = uint(entry.scanline) & 0xFF;
+			data[17] = uint(entry.scanline) >> 8 & 0xFF;
+			data[18] = entry.dot & 0xFF;
+			data[19] = entry.dot >> 8;
+		}
+
+		void Tracer::Save(StdStream const stdStream) const
+		{
+			Stream::Out stream( stdStream );
+
+			const byte header[8] =
+			{
+				Ascii<'N'>::V,
+				Ascii<'T'>::V,
+				Ascii<'R'>::V,
+				0x1A,
+				TRACE_VERSION,
+				byte(model),
+				byte(model == CPU_RP2A07 ? CPU_RP2A07_CC : model == CPU_DENDY ? CPU_DENDY_CC : CPU_RP2A03_CC),
+				0
+			};
+
+			stream.Write( header );
+			stream.Write32( count );
+
+			byte block[TRACE_BLOCK * Api::Tracer::ENTRY_SIZE];
+
+			for (dword i=0; i < count; )
+			{
+				uint n = 0;
+
+				for (; n < TRACE_BLOCK && i < count; ++n, ++i)
+					Pack( GetEntry(i), block + n * Api::Tracer::ENTRY_SIZE );
+
+				stream.Write( block, n * Api::Tracer::ENTRY_SIZE );
+			}
+		}
+
+		void Tracer::ReadHeader(StdStream const stdStream,Header& header)
+		{
+			Stream::In stream( stdStream );
+
+			byte data[8];
+			stream.Read( data );
+
+			if (data[0] != Ascii<'N'>::V || data[1] != Ascii<'T'>::V || data[2] != Ascii<'R'>::V || data[3] != 0x1A)
+				throw RESULT_ERR_INVALID_FILE;
+
+			if (data[4] != TRACE_VERSION || data[5] > CPU_DENDY)
+				throw RESULT_ERR_UNSUPPORTED_FILE_VERSION;
+
+			header.model = data[5];
+			header.clock = data[6];
+			header.count = stream.Read32();
+		}
+
+		void Tracer::ReadEntry(StdStream const stdStream,Entry& entry)
+		{
+			Stream::In stream( stdStream );
+
+			byte data[Api::Tracer::ENTRY_SIZE];
+			stream.Read( data );
+
+			entry.frame = data[0] | uint(data[1]) << 8 | dword(data[2]) << 16 | dword(data[3]) << 24;
+			entry.cycle = data[4] | uint(data[5]) << 8 | dword(data[6]) << 16 | dword(data[7]) << 24;
+			entry.pc = data[8] | uint(data[9]) << 8;
+			entry.opcode = data[10];
+			entry.a = data[11];
+			entry.x = data[12];
+			entry.y = data[13];
+			entry.sp = data[14];
+			entry.p = data[15];
+			entry.scanline = short(data[16] | uint(data[17]) << 8);
+			entry.dot = data[18] | uint(data[19]) << 8;
+		}
+
+		#ifdef NST_MSVC_OPTIMIZE
+		#pragma optimize("", on)
+		#endif
+	}
+}
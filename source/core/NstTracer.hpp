@@ -0,0 +1,192 @@
+////////////////////////////////////////////////////////////////////////////////////////
+//
+// Nestopia - NES/Famicom emulator written in C++
+//
+// Copyright (C) 2003-2008 Martin Freij
+//
+// This file is part of Nestopia.
+//
+// Nestopia is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Nestopia is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Nestopia; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef NST_TRACER_H
+#define NST_TRACER_H
+
+#ifdef NST_PRAGMA_ONCE
+#pragma once
+#endif
+
+#include "NstStream.hpp"
+#include "api/NstApiTracer.hpp"
+
+namespace Nes
+{
+	namespace Core
+	{
+		class Tracer
+		{
+		public:
+
+			typedef Api::Tracer::Entry Entry;
+			typedef Api::Tracer::Trigger Trigger;
+			typedef Api::Tracer::Header Header;
+
+			Tracer();
+			~Tracer();
+
+			void Start(dword,const Trigger&,dword);
+			void Stop();
+			bool BeginFrame(dword,CpuModel,Cycle,bool);
+
+			void Save(StdStream) const;
+			static void ReadHeader(StdStream,Header&);
+			static void ReadEntry(StdStream,Entry&);
+
+			inline void Record(uint,uint,uint,uint,uint,uint,uint,Cycle);
+
+		private:
+
+			enum
+			{
+				RECORDING,
+				WAITING,
+				STOPPED
+			};
+
+			static void Pack(const Entry&,byte*);
+			inline void Position(Cycle,Entry&) const;
+
+			Entry* entries;
+			dword size;
+			dword pos;
+			dword count;
+			dword remaining;
+			uint state;
+			Trigger trigger;
+			dword frame;
+			CpuModel model;
+			Cycle offset;
+			dword ppuRecip;
+			dword firstLine;
+			dword preLine;
+			dword skip;
+			ibool busy;
+
+		public:
+
+			bool IsBusy() const
+			{
+				return busy;
+			}
+
+			bool IsRunning() const
+			{
+				return state != STOPPED;
+			}
+
+			bool IsTriggered() const
+			{
+				return state == RECORDING || count;
+			}
+
+			dword NumEntries() const
+			{
+				return count;
+			}
+
+			const Entry& GetEntry(dword index) const
+			{
+				NST_ASSERT( index < count );
+				return entries[(pos + size - count + index) % size];
+			}
+		};
+
+		inline void Tracer::Position(Cycle cycle,Entry& entry) const
+		{
+			// ppu cycle since the start of vblank, then line and dot
+			dword dot = dword(qaword(cycle + offset) * ppuRecip >> 32);
+			dot += (dot >= skip);
+
+			const dword line = dot / 341;
+
+			entry.scanline = line < preLine ? short(firstLine + line) : short(line - preLine) - 1;
+			entry.dot = dot - line * 341;
+		}
+
+		inline void Tracer::Record(uint pc,uint opcode,uint a,uint x,uint y,uint sp,uint p,Cycle cycle)
+		{
+			if (state > WAITING)
+				return;
+
+			Entry& entry = entries[pos];
+
+			entry.frame = frame;
+			entry.cycle = cycle;
+			entry.pc = pc;
+			entry.opcode = opcode;
+			entry.a = a;
+			entry.x = x;
+			entry.y = y;
+			entry.sp = sp;
+			entry.p = p;
+
+			Position( cycle, entry );
+
+			if (state == WAITING)
+			{
+				switch (trigger.type)
+				{
+					case Api::Tracer::TRIGGER_ADDRESS:
+
+						if (pc != trigger.address)
+							return;
+
+						break;
+
+					case Api::Tracer::TRIGGER_CONDITION:
+					{
+						// the trace can't be started, stopped or released from in here
+
+						busy = true;
+						const bool hit = trigger.condition( trigger.userData, entry );
+						busy = false;
+
+						if (!hit)
+							return;
+
+						break;
+					}
+
+					default:
+						break;
+				}
+
+				state = RECORDING;
+			}
+
+			if (++pos == size)
+				pos = 0;
+
+			if (count < size)
+				++count;
+
+			if (remaining && !--remaining)
+				state = STOPPED;
+		}
+	}
+}
+
+#endif
@@ -24,6 +24,7 @@
 
 #include <new>
 #include "NstMachine.hpp"
+#include "NstState.hpp"
 #include "NstTrackerMovie.hpp"
 #include "NstTrackerRewinder.hpp"
 #include "NstImage.hpp"
@@ -207,7 +208,7 @@ namespace Nes
 			return result;
 		}
 
-		Result Tracker::RecordMovie(Machine& emulator,std::iostream& stream,const bool append)
+		Result Tracker::RecordMovie(Machine& emulator,std::iostream& stream,const bool append,const dword hashInterval,const dword keyInterval)
 		{
 			if (!emulator.Is(Api::Machine::GAME))
 				return RESULT_ERR_NOT_READY;
@@ -230,7 +231,7 @@ namespace Nes
 					);
 				}
 
-				return movie->Record( stream, append ) ? RESULT_OK : RESULT_NOP;
+				return movie->Record( stream, append, hashInterval, keyInterval ) ? RESULT_OK : RESULT_NOP;
 			}
 			catch (Result r)
 			{
@@ -258,6 +259,111 @@ namespace Nes
 			UpdateRewinderState( true );
 		}
 
+		Result Tracker::SeekMovie(Machine& machine,const dword target)
+		{
+			if (!IsMoviePlaying() || !machine.Is(Api::Machine::ON))
+				return RESULT_ERR_NOT_READY;
+
+			Result result;
+
+			try
+			{
+				// restore the nearest key and play the rest without any output
+
+				for (dword remaining = movie->Seek( target ); remaining; --remaining)
+				{
+					if (NES_FAILED(result=Execute( machine, NULL, NULL, NULL )))
+						return result;
+
+					if (!movie)
+						return RESULT_ERR_INVALID_PARAM;
+				}
+
+				return RESULT_OK;
+			}
+			catch (Result r)
+			{
+				result = r;
+			}
+			catch (const std::bad_alloc&)
+			{
+				result = RESULT_ERR_OUT_OF_MEMORY;
+			}
+			catch (...)
+			{
+				result = RESULT_ERR_GENERIC;
+			}
+
+			StopMovie();
+
+			return result;
+		}
+
+		Result Tracker::LoadMovieIndex(std::istream& stream)
+		{
+			if (!IsMoviePlaying())
+				return RESULT_ERR_NOT_READY;
+
+			try
+			{
+				movie->LoadIndex( stream );
+			}
+			catch (Result result)
+			{
+				return result;
+			}
+			catch (const std::bad_alloc&)
+			{
+				return RESULT_ERR_OUT_OF_MEMORY;
+			}
+			catch (...)
+			{
+				return RESULT_ERR_GENERIC;
+			}
+
+			return RESULT_OK;
+		}
+
+		Result Tracker::SaveMovieIndex(Machine& machine,std::ostream& stream,const dword interval)
+		{
+			if (!IsMoviePlaying() || !machine.Is(Api::Machine::ON) || !interval)
+				return RESULT_ERR_NOT_READY;
+
+			Result result = RESULT_OK;
+
+			try
+			{
+				// play the movie through to the end, saving a key every interval frames
+
+				State::Saver index( &stream, true, false );
+				index.Begin( AsciiId<'N','S','I'>::V | 0x1AUL << 24 );
+
+				for (dword played=0; movie && NES_SUCCEEDED(result); ++played)
+				{
+					if (played && played % interval == 0)
+						movie->SaveIndex( index );
+
+					result = Execute( machine, NULL, NULL, NULL );
+				}
+
+				index.End();
+			}
+			catch (Result r)
+			{
+				result = r;
+			}
+			catch (const std::bad_alloc&)
+			{
+				result = RESULT_ERR_OUT_OF_MEMORY;
+			}
+			catch (...)
+			{
+				result = RESULT_ERR_GENERIC;
+			}
+
+			return result;
+		}
+
 		#ifdef NST_MSVC_OPTIMIZE
 		#pragma optimize("", on)
 		#endif
@@ -309,18 +415,25 @@ namespace Nes
 			{
 				++frame;
 
+				NST_PROFILE_FRAME( machine.profiler );
+
 				try
 				{
 					if (machine.Is(Api::Machine::GAME))
 					{
 						if (rewinder)
 						{
+							NST_PROFILE_SCOPE( Profiler::SECTION_REWINDER );
 							rewinder->Execute( video, sound, input );
 							return RESULT_OK;
 						}
 						else if (movie)
 						{
-							if (!movie->Execute())
+							NST_PROFILE_ENTER( Profiler::SECTION_MOVIE );
+							const bool executed = movie->Execute();
+							NST_PROFILE_LEAVE();
+
+							if (!executed)
 							{
 								StopMovie();
 							}
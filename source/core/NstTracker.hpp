@@ -74,7 +74,10 @@ namespace Nes
 			bool   IsRewinding() const;
 
 			Result PlayMovie(Machine&,std::istream&);
-			Result RecordMovie(Machine&,std::iostream&,bool);
+			Result RecordMovie(Machine&,std::iostream&,bool,dword=0,dword=0);
+			Result SeekMovie(Machine&,dword);
+			Result LoadMovieIndex(std::istream&);
+			Result SaveMovieIndex(Machine&,std::ostream&,dword);
 			void   StopMovie();
 			bool   IsMoviePlaying() const;
 			bool   IsMovieRecording() const;
@@ -24,10 +24,12 @@
 
 #include <new>
 #include <iostream>
+#include <sstream>
 #include "NstMachine.hpp"
 #include "NstState.hpp"
 #include "NstTrackerMovie.hpp"
 #include "NstZlib.hpp"
+#include "NstLog.hpp"
 #include "api/NstApiMovie.hpp"
 #include "api/NstApiUser.hpp"
 
@@ -46,11 +48,17 @@ namespace Nes
 			~Player();
 
 			void Relink();
+			dword Seek(Machine&,EmuLoadState,dword);
+			void LoadIndex(std::istream&);
+			bool SaveIndex(State::Saver&,Machine&,EmuSaveState) const;
 
 		private:
 
 			static dword Validate(State::Loader&,const Cpu&,dword,bool);
 
+			void ReadKey(Machine&,EmuLoadState,bool);
+			void Index();
+
 			enum
 			{
 				MAX_BUFFER_MASK = 0xFFFFFF,
@@ -76,13 +84,32 @@ namespace Nes
 				}
 			};
 
+			struct Key
+			{
+				dword frame;
+				dword offset;
+				dword skip;
+				dword pos[2];
+				dword data;
+				dword size;
+			};
+
 			NES_DECL_PEEK( Port );
 			NES_DECL_POKE( Port );
 
 			const Io::Port* ports[2];
 			dword frame;
+			dword length;
+			dword played;
+			dword hashPos;
+			dword keyOffset;
+			ibool indexed;
+			Vector<dword> hashes;
+			Vector<Key> keys;
+			Vector<byte> keyStates;
 			Buffer buffers[2];
 			Loader state;
+			const dword size;
 			Cpu& cpu;
 
 		public:
@@ -94,9 +121,17 @@ namespace Nes
 			}
 
 			Player(std::istream& stream,Cpu& c,const dword prgCrc)
-			: frame(0), state(stream), cpu(c)
+			:
+			frame     (0),
+			length    (0),
+			played    (0),
+			hashPos   (0),
+			keyOffset (0),
+			indexed   (false),
+			state     (stream),
+			size      (Validate(state,c,prgCrc,false)),
+			cpu       (c)
 			{
-				Validate( state, cpu, prgCrc, false );
 				Relink();
 			}
 
@@ -110,9 +145,9 @@ namespace Nes
 				state.End();
 			}
 
-			bool Execute(Machine& emulator,EmuLoadState loadState)
+			bool Execute(Machine& emulator,EmuLoadState loadState,EmuSaveState saveState)
 			{
-				NST_ASSERT( loadState );
+				NST_ASSERT( loadState && saveState );
 
 				if (buffers[0].pos > buffers[0].Size() || buffers[1].pos > buffers[1].Size())
 					throw RESULT_ERR_CORRUPT_FILE;
@@ -125,66 +160,316 @@ namespace Nes
 				{
 					NST_VERIFY( buffers[0].pos == buffers[0].Size() && buffers[1].pos == buffers[1].Size() );
 
+					const dword offset = size - state.Length();
 					const dword chunk = state.Begin();
 
 					if (chunk == AsciiId<'K','E','Y'>::V)
 					{
-						for (uint i=0; i < 2; ++i)
-						{
-							buffers[i].pos = 0;
-							buffers[i].Clear();
-						}
+						ReadKey( emulator, loadState, true );
+						keyOffset = offset;
+						state.End();
+						break;
+					}
+					else if (chunk)
+					{
+						state.End();
+					}
+					else
+					{
+						return false;
+					}
+				}
 
-						while (const dword subChunk = state.Begin())
+				if (hashPos < hashes.Size() && hashes[hashPos] == length - frame)
+				{
+					dword hi, lo;
+					HashState( emulator, saveState, hi, lo );
+
+					if (hi != hashes[hashPos+1] || lo != hashes[hashPos+2])
+						Log() << "Movie: state hash mismatch at frame " << ulong(played) << NST_LINEBREAK;
+
+					hashPos += 3;
+				}
+
+				++played;
+
+				return true;
+			}
+		};
+
+		Tracker::Movie::Player::~Player()
+		{
+			for (uint i=0; i < 2; ++i)
+				cpu.Unlink( 0x4016 + i, this, &Player::Peek_Port, &Player::Poke_Port );
+		}
+
+		void Tracker::Movie::Player::ReadKey(Machine& emulator,EmuLoadState loadState,const bool loadSav)
+		{
+			for (uint i=0; i < 2; ++i)
+			{
+				buffers[i].pos = 0;
+				buffers[i].Clear();
+			}
+
+			hashes.Clear();
+			hashPos = 0;
+
+			while (const dword subChunk = state.Begin())
+			{
+				switch (subChunk)
+				{
+					case AsciiId<'S','A','V'>::V:
+
+						if (loadSav)
+							(emulator.*loadState)( state, false );
+
+						break;
+
+					case AsciiId<'P','T','0'>::V:
+					case AsciiId<'P','T','1'>::V:
+					{
+						const uint i = (subChunk == AsciiId<'P','T','1'>::V);
+
+						buffers[i].Resize( state.Read32() & MAX_BUFFER_MASK );
+						state.Uncompress( buffers[i].Begin(), buffers[i].Size() );
+						break;
+					}
+
+					case AsciiId<'L','E','N'>::V:
+
+						frame = length = state.Read32();
+						NST_VERIFY( frame <= 0xFFFFF );
+						break;
+
+					case AsciiId<'H','S','H'>::V:
+
+						hashes.Resize( (state.Read32() & MAX_BUFFER_MASK) * 3 );
+
+						for (dword i=0; i < hashes.Size(); ++i)
+							hashes[i] = state.Read32();
+
+						break;
+				}
+
+				state.End();
+			}
+		}
+
+		void Tracker::Movie::Player::Index()
+		{
+			// collect every KEY that carries a state, from the trailing
+			// index when the recorder left one or else by walking them all
+
+			const dword left = state.Length();
+			keys.Clear();
+
+			if (size >= 4+4+4+4)
+			{
+				state.Seek( 4 );
+				const dword count = state.Read32();
+
+				if (count <= (size - (4+4+4+4)) / (4+4))
+				{
+					const dword idx = 4+4+4 + count * (4+4) + 4;
+
+					state.Seek( idx );
+
+					if (state.Check() == AsciiId<'I','D','X'>::V)
+					{
+						state.Begin();
+
+						if (state.Length() == idx - (4+4) && state.Read32() == count)
 						{
-							switch (subChunk)
+							for (dword i=0; i < count; ++i)
 							{
-								case AsciiId<'S','A','V'>::V:
+								const Key key = {0,0,0,{0,0},0,0};
+								keys.Append( key );
+
+								keys.Back().frame = state.Read32();
+								keys.Back().offset = state.Read32();
+							}
+						}
+
+						state.End();
+					}
+				}
+			}
 
-									(emulator.*loadState)( state, false );
-									break;
+			if (!keys.Size())
+			{
+				state.Seek( size );
 
-								case AsciiId<'P','T','0'>::V:
-								case AsciiId<'P','T','1'>::V:
-								{
-									const uint i = (subChunk == AsciiId<'P','T','1'>::V);
+				for (dword frames=0;;)
+				{
+					const dword offset = size - state.Length();
+					const dword chunk = state.Begin();
 
-									buffers[i].Resize( state.Read32() & MAX_BUFFER_MASK );
-									state.Uncompress( buffers[i].Begin(), buffers[i].Size() );
-									break;
-								}
+					if (!chunk)
+						break;
 
-								case AsciiId<'L','E','N'>::V:
+					if (chunk == AsciiId<'K','E','Y'>::V)
+					{
+						bool sav = false;
+						dword len = 0;
 
-									frame = state.Read32();
-									NST_VERIFY( frame <= 0xFFFFF );
-									break;
-							}
+						while (const dword subChunk = state.Begin())
+						{
+							if (subChunk == AsciiId<'S','A','V'>::V)
+								sav = true;
+							else if (subChunk == AsciiId<'L','E','N'>::V)
+								len = state.Read32();
 
 							state.End();
 						}
 
-						state.End();
-						break;
+						if (sav)
+						{
+							const Key key = {frames,offset,0,{0,0},0,0};
+							keys.Append( key );
+						}
+
+						frames += len + 1;
 					}
-					else if (chunk)
+
+					state.End();
+				}
+			}
+
+			state.Seek( left );
+			indexed = true;
+		}
+
+		void Tracker::Movie::Player::LoadIndex(std::istream& stream)
+		{
+			// merge the keys of a sidecar index into the ones in the movie
+
+			if (!indexed)
+				Index();
+
+			State::Loader index( &stream, false );
+
+			if (index.Begin() != (AsciiId<'N','S','I'>::V | 0x1AUL << 24))
+				throw RESULT_ERR_INVALID_FILE;
+
+			while (const dword chunk = index.Begin())
+			{
+				if (chunk == AsciiId<'K','E','Y'>::V)
+				{
+					Key key = {0,0,0,{0,0},0,0};
+
+					while (const dword subChunk = index.Begin())
 					{
-						state.End();
+						if (subChunk == AsciiId<'P','O','S'>::V)
+						{
+							key.frame = index.Read32();
+							key.offset = index.Read32();
+							key.skip = index.Read32();
+							key.pos[0] = index.Read32();
+							key.pos[1] = index.Read32();
+						}
+						else if (subChunk == AsciiId<'S','A','V'>::V && index.Length())
+						{
+							key.data = keyStates.Size();
+							key.size = index.Length();
+
+							keyStates.Resize( key.data + key.size );
+							index.Read( keyStates.Begin() + key.data, key.size );
+						}
+
+						index.End();
 					}
-					else
+
+					if (key.size && key.offset < size)
 					{
-						return false;
+						Key* it = keys.End();
+
+						while (it != keys.Begin() && it[-1].frame > key.frame)
+							--it;
+
+						keys.Insert( it, key );
 					}
 				}
 
-				return true;
+				index.End();
 			}
-		};
 
-		Tracker::Movie::Player::~Player()
+			index.End();
+		}
+
+		bool Tracker::Movie::Player::SaveIndex(State::Saver& index,Machine& emulator,EmuSaveState saveState) const
 		{
-			for (uint i=0; i < 2; ++i)
-				cpu.Unlink( 0x4016 + i, this, &Player::Peek_Port, &Player::Poke_Port );
+			// the next frame to be played, unless it starts a new KEY
+
+			if (!frame)
+				return false;
+
+			index.Begin( AsciiId<'K','E','Y'>::V );
+
+			index.Begin( AsciiId<'P','O','S'>::V )
+				.Write32( played )
+				.Write32( keyOffset )
+				.Write32( length + 1 - frame )
+				.Write32( buffers[0].pos )
+				.Write32( buffers[1].pos )
+			.End();
+
+			index.Begin( AsciiId<'S','A','V'>::V );
+			(emulator.*saveState)( index );
+			index.End();
+
+			index.End();
+
+			return true;
+		}
+
+		dword Tracker::Movie::Player::Seek(Machine& emulator,EmuLoadState loadState,const dword target)
+		{
+			if (!indexed)
+				Index();
+
+			const Key* key = NULL;
+
+			for (const Key* it = keys.Begin(); it != keys.End() && it->frame <= target; ++it)
+				key = it;
+
+			if (target >= played && (!key || key->frame <= played))
+				return target - played;
+
+			if (!key)
+				throw RESULT_ERR_INVALID_PARAM;
+
+			state.Seek( size - key->offset );
+
+			if (state.Begin() != AsciiId<'K','E','Y'>::V)
+				throw RESULT_ERR_CORRUPT_FILE;
+
+			ReadKey( emulator, loadState, !key->size );
+			state.End();
+
+			if (key->skip > length)
+				throw RESULT_ERR_CORRUPT_FILE;
+
+			if (key->size)
+			{
+				std::istringstream stream( std::string(reinterpret_cast<const char*>(keyStates.Begin() + key->data), key->size) );
+				State::Loader loader( &stream, false );
+
+				(emulator.*loadState)( loader, false );
+
+				for (uint i=0; i < 2; ++i)
+					buffers[i].pos = key->pos[i];
+
+				while (hashPos < hashes.Size() && hashes[hashPos] < key->skip)
+					hashPos += 3;
+			}
+
+			// the next Execute() counts this back down to the wanted frame
+
+			frame = length + 1 - key->skip;
+			keyOffset = key->offset;
+			played = key->frame;
+
+			return target - played;
 		}
 
 		dword Tracker::Movie::Player::Validate(State::Loader& state,const Cpu& cpu,const dword prgCrc,const bool end)
@@ -298,6 +583,11 @@ namespace Nes
 				{
 					return stream == &s;
 				}
+
+				dword Offset() const
+				{
+					return Tell() - (4+4);
+				}
 			};
 
 			NES_DECL_PEEK( Port );
@@ -306,14 +596,28 @@ namespace Nes
 			const Io::Port* ports[2];
 			ibool resync;
 			dword frame;
+			dword recorded;
+			const ibool appended;
+			const dword hashInterval;
+			const dword keyInterval;
+			Vector<dword> hashes;
+			Vector<dword> index;
 			Buffer buffers[2];
 			Saver state;
 			Cpu& cpu;
 
 		public:
 
-			Recorder(std::iostream& stream,Cpu& c,const dword prgCrc,const bool append)
-			: resync(true), frame(0), state(stream,append ? Player::Validate(stream,c,prgCrc) : 0), cpu(c)
+			Recorder(std::iostream& stream,Cpu& c,const dword prgCrc,const bool append,const dword hInterval,const dword kInterval)
+			:
+			resync       (true),
+			frame        (0),
+			recorded     (0),
+			appended     (append),
+			hashInterval (hInterval),
+			keyInterval  (kInterval),
+			state        (stream,append ? Player::Validate(stream,c,prgCrc) : 0),
+			cpu          (c)
 			{
 				if (!append)
 				{
@@ -343,6 +647,18 @@ namespace Nes
 			{
 				EndKey();
 
+				// trailing seek index, the count is repeated last so it can be found from the end
+
+				if (index.Size() && !appended)
+				{
+					state.Begin( AsciiId<'I','D','X'>::V ).Write32( index.Size() / 2 );
+
+					for (dword i=0; i < index.Size(); ++i)
+						state.Write32( index[i] );
+
+					state.Write32( index.Size() / 2 ).End();
+				}
+
 				state.End();
 			}
 
@@ -353,12 +669,26 @@ namespace Nes
 				if (frame == BAD_FRAME)
 					throw RESULT_ERR_OUT_OF_MEMORY;
 
+				if (keyInterval && recorded && recorded % keyInterval == 0)
+					resync = true;
+
 				if (resync || buffers[0].Size() >= MAX_BUFFER_BLOCK || buffers[1].Size() >= MAX_BUFFER_BLOCK)
 				{
 					EndKey();
 					BeginKey( machine, saveState );
 				}
 
+				if (hashInterval && recorded % hashInterval == 0)
+				{
+					dword hi, lo;
+					HashState( machine, saveState, hi, lo );
+
+					hashes.Append( frame );
+					hashes.Append( hi );
+					hashes.Append( lo );
+				}
+
+				++recorded;
 				++frame;
 			}
 		};
@@ -377,6 +707,12 @@ namespace Nes
 
 		void Tracker::Movie::Recorder::BeginKey(Machine& machine,EmuSaveState saveState)
 		{
+			if (resync)
+			{
+				index.Append( recorded );
+				index.Append( state.Offset() );
+			}
+
 			state.Begin( AsciiId<'K','E','Y'>::V );
 
 			if (resync)
@@ -408,6 +744,17 @@ namespace Nes
 					}
 				}
 
+				if (hashes.Size())
+				{
+					state.Begin( AsciiId<'H','S','H'>::V ).Write32( hashes.Size() / 3 );
+
+					for (dword i=0; i < hashes.Size(); ++i)
+						state.Write32( hashes[i] );
+
+					state.End();
+					hashes.Clear();
+				}
+
 				state.End();
 			}
 		}
@@ -461,7 +808,21 @@ namespace Nes
 			Stop();
 		}
 
-		bool Tracker::Movie::Record(std::iostream& stream,const bool append)
+		void Tracker::Movie::HashState(Machine& machine,EmuSaveState saveState,dword& hi,dword& lo)
+		{
+			// the controllers are fed by the movie on playback, leave them out
+
+			State::Hash hash( AsciiId<'P','R','T'>::V );
+
+			{
+				State::Saver saver( hash );
+				(machine.*saveState)( saver );
+			}
+
+			hash.Digest( hi, lo );
+		}
+
+		bool Tracker::Movie::Record(std::iostream& stream,const bool append,const dword hashInterval,const dword keyInterval)
 		{
 			if (!Zlib::AVAILABLE)
 				throw RESULT_ERR_UNSUPPORTED;
@@ -474,7 +835,7 @@ namespace Nes
 
 			Stop();
 
-			recorder = new Recorder( stream, cpu, prgCrc, append );
+			recorder = new Recorder( stream, cpu, prgCrc, append, hashInterval, keyInterval );
 
 			Api::Movie::eventCallback( Api::Movie::EVENT_RECORDING );
 
@@ -506,6 +867,30 @@ namespace Nes
 			Stop( RESULT_OK );
 		}
 
+		dword Tracker::Movie::Seek(const dword frame)
+		{
+			if (!player)
+				throw RESULT_ERR_NOT_READY;
+
+			return player->Seek( emulator, loadState, frame );
+		}
+
+		void Tracker::Movie::LoadIndex(std::istream& stream)
+		{
+			if (!player)
+				throw RESULT_ERR_NOT_READY;
+
+			player->LoadIndex( stream );
+		}
+
+		bool Tracker::Movie::SaveIndex(State::Saver& index)
+		{
+			if (!player)
+				throw RESULT_ERR_NOT_READY;
+
+			return player->SaveIndex( index, emulator, saveState );
+		}
+
 		bool Tracker::Movie::Stop(Result result)
 		{
 			if (recorder || player)
@@ -590,7 +975,7 @@ namespace Nes
 					recorder->Execute( emulator, saveState );
 					return true;
 				}
-				else if (player && player->Execute( emulator, loadState ))
+				else if (player && player->Execute( emulator, loadState, saveState ))
 				{
 					return true;
 				}
@@ -44,8 +44,11 @@ namespace Nes
 			~Movie();
 
 			bool Play(std::istream&);
-			bool Record(std::iostream&,bool);
+			bool Record(std::iostream&,bool,dword,dword);
 			void Stop();
+			dword Seek(dword);
+			void LoadIndex(std::istream&);
+			bool SaveIndex(State::Saver&);
 			void Resync();
 			void Reset();
 			bool Execute();
@@ -54,6 +57,8 @@ namespace Nes
 
 			bool Stop(Result);
 
+			static void HashState(Machine&,EmuSaveState,dword&,dword&);
+
 			class Player;
 			class Recorder;
 
@@ -333,7 +333,7 @@ namespace Nes
 				{
 					Buffer tmp( pos - 1 );
 
-					if (const dword size = Zlib::Compress( buffer.Begin(), buffer.Size(), tmp.Begin(), tmp.Size(), Zlib::NORMAL_COMPRESSION ))
+					if (const dword size = Zlib::Compress( buffer.Begin(), buffer.Size(), tmp.Begin(), tmp.Size(), Zlib::FAST_COMPRESSION ))
 					{
 						NST_ASSERT( size < pos );
 						tmp.SetTo( size );
@@ -28,6 +28,7 @@
 #include "NstCore.hpp"
 #include "NstAssert.hpp"
 #include "NstFpuPrecision.hpp"
+#include "NstProfiler.hpp"
 #include "api/NstApiVideo.hpp"
 #include "NstVideoRenderer.hpp"
 #include "NstVideoFilterNone.hpp"
@@ -817,10 +818,16 @@ namespace Nes
 			{
 				if (filter)
 				{
+					NST_PROFILE_SCOPE( Profiler::SECTION_BLIT );
+
 					if (state.update)
 						UpdateFilter( input );
 
-					if (Output::lockCallback( output ))
+					NST_PROFILE_ENTER( Profiler::SECTION_VIDEO_LOCK );
+					const bool locked = Output::lockCallback( output );
+					NST_PROFILE_LEAVE();
+
+					if (locked)
 					{
 						NST_VERIFY( std::labs(output.pitch) >= dword(state.width) << (filter->format.bpp / 16) );
 						
@@ -829,7 +836,9 @@ namespace Nes
 						if (std::labs(output.pitch) >= dword(state.width) << (filter->format.bpp / 16))
 							filter->Blit( input, output, burstPhase );
 
+						NST_PROFILE_ENTER( Profiler::SECTION_VIDEO_LOCK );
 						Output::unlockCallback( output );
+						NST_PROFILE_LEAVE();
 					}
 				}
 			}
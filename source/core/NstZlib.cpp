@@ -59,6 +59,8 @@ namespace Nes
 
 					if (compression == BEST_COMPRESSION)
 						result = compress2( dst, &dstSize, src, srcSize, Z_BEST_COMPRESSION );
+					else if (compression == FAST_COMPRESSION)
+						result = compress2( dst, &dstSize, src, srcSize, Z_BEST_SPEED );
 					else
 						result = compress( dst, &dstSize, src, srcSize );
 
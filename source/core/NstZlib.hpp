@@ -47,7 +47,8 @@ namespace Nes
 			enum Compression
 			{
 				NORMAL_COMPRESSION,
-				BEST_COMPRESSION
+				BEST_COMPRESSION,
+				FAST_COMPRESSION
 			};
 
 			ulong NST_CALL Compress(const byte*,ulong,byte*,ulong,Compression);
@@ -29,6 +29,7 @@
 #include "../NstCartridge.hpp"
 #include "../NstImageDatabase.hpp"
 #include "../NstCartridgeInes.hpp"
+#include "NstApiEmulator.hpp"
 #include "NstApiMachine.hpp"
 
 namespace Nes
@@ -371,6 +372,12 @@ namespace Nes
 
 		bool Cartridge::Database::Create()
 		{
+			if (emulator.imageDatabaseShared)
+			{
+				emulator.imageDatabase = NULL;
+				emulator.imageDatabaseShared = false;
+			}
+
 			if (emulator.imageDatabase == NULL)
 				emulator.imageDatabase = new (std::nothrow) Core::ImageDatabase;
 
@@ -387,14 +394,29 @@ namespace Nes
 			return Create() ? emulator.imageDatabase->Load( baseStream, overloadStream ) : RESULT_ERR_OUT_OF_MEMORY;
 		}
 
+		Result Cartridge::Database::Share(Emulator& source) throw()
+		{
+			return emulator.ShareImageDatabase( source );
+		}
+
 		void Cartridge::Database::Unload() throw()
 		{
-			if (emulator.imageDatabase)
+			if (emulator.imageDatabaseShared)
+			{
+				emulator.imageDatabase = NULL;
+				emulator.imageDatabaseShared = false;
+			}
+			else if (emulator.imageDatabase)
+			{
 				emulator.imageDatabase->Unload();
+			}
 		}
 
 		Result Cartridge::Database::Enable(bool state) throw()
 		{
+			if (emulator.imageDatabaseShared)
+				return emulator.imageDatabase->Enabled() == state ? RESULT_NOP : RESULT_ERR_NOT_READY;
+
 			if (Create())
 			{
 				if (emulator.imageDatabase->Enabled() != state)
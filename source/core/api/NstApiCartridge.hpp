@@ -44,6 +44,8 @@ namespace Nes
 {
 	namespace Api
 	{
+		class Emulator;
+
 		/**
 		* Cartridge interface.
 		*/
@@ -1020,6 +1022,20 @@ namespace Nes
 				*/
 				Result Load(std::istream& streamInternal,std::istream& streamExternal) throw();
 
+				/**
+				* Uses the databases of another emulator instance.
+				*
+				* The databases are only read from while shared, so any number of
+				* emulators running on separate threads may share them. The source
+				* must outlive the sharing emulators and must not load, unload or
+				* enable its databases in the meantime. Loading or unloading
+				* databases in a sharing emulator stops the sharing.
+				*
+				* @param source emulator instance with loaded databases
+				* @return result code
+				*/
+				Result Share(Emulator& source) throw();
+
 				/**
 				* Removes all databases from the system.
 				*/
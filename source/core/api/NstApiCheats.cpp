@@ -347,6 +347,11 @@ namespace Nes
 			return emulator.cpu.GetRam();
 		}
 
+		uint Cheats::Peek(ushort address) const throw()
+		{
+			return emulator.cpu.Peek( address );
+		}
+
 		#ifdef NST_MSVC_OPTIMIZE
 		#pragma optimize("", on)
 		#endif
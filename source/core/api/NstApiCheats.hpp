@@ -163,6 +163,17 @@ namespace Nes
 			*/
 			Ram GetRam() const throw();
 
+			/**
+			* Reads a byte from the CPU address space.
+			*
+			* The read goes through the same memory map as the CPU's, so
+			* registers may react to it. Meant for RAM and ROM.
+			*
+			* @param address CPU address
+			* @return value
+			*/
+			uint Peek(ushort address) const throw();
+
 			/**
 			* Encodes into a Game Genie code.
 			*
@@ -0,0 +1,190 @@
+////////////////////////////////////////////////////////////////////////////////////////
+//
+// Nestopia - NES/Famicom emulator written in C++
+//
+// Copyright (C) 2003-2008 Martin Freij
+//
+// This file is part of Nestopia.
+//
+// Nestopia is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Nestopia is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Nestopia; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////////////
+
+
+#include <new>
+#include "../NstMachine.hpp"
+#include "../NstCartridge.hpp"
+#include "../NstCodeDataLogger.hpp"
+#include "NstApiMachine.hpp"
+#include "NstApiCodeDataLogger.hpp"
+
+namespace Nes
+{
+	namespace Api
+	{
+		#ifdef NST_MSVC_OPTIMIZE
+		#pragma optimize("s", on)
+		#endif
+
+		Result CodeDataLogger::Start() throw()
+		{
+			if (!emulator.Is(Machine::CARTRIDGE))
+				return RESULT_ERR_NOT_READY;
+
+			if (emulator.cdl && emulator.cdl->IsRunning())
+				return RESULT_NOP;
+
+			try
+			{
+				if (emulator.cdl == NULL)
+					emulator.cdl = new Core::CodeDataLogger( emulator.cpu, emulator.ppu, *static_cast<const Core::Cartridge*>(emulator.image) );
+
+				emulator.cdl->Start();
+			}
+			catch (const std::bad_alloc&)
+			{
+				return RESULT_ERR_OUT_OF_MEMORY;
+			}
+			catch (...)
+			{
+				return RESULT_ERR_GENERIC;
+			}
+
+			return RESULT_OK;
+		}
+
+		Result CodeDataLogger::Stop() throw()
+		{
+			if (!emulator.cdl || !emulator.cdl->IsRunning())
+				return RESULT_NOP;
+
+			emulator.cdl->Stop();
+
+			return RESULT_OK;
+		}
+
+		bool CodeDataLogger::IsRunning() const throw()
+		{
+			return emulator.cdl && emulator.cdl->IsRunning();
+		}
+
+		Result CodeDataLogger::Clear() throw()
+		{
+			if (!emulator.cdl)
+				return RESULT_NOP;
+
+			emulator.cdl->Clear();
+
+			return RESULT_OK;
+		}
+
+		Result CodeDataLogger::Save(std::ostream& stream) const throw()
+		{
+			if (!emulator.cdl)
+				return RESULT_ERR_NOT_READY;
+
+			try
+			{
+				emulator.cdl->Save( &stream );
+			}
+			catch (Result result)
+			{
+				return result;
+			}
+			catch (const std::bad_alloc&)
+			{
+				return RESULT_ERR_OUT_OF_MEMORY;
+			}
+			catch (...)
+			{
+				return RESULT_ERR_GENERIC;
+			}
+
+			return RESULT_OK;
+		}
+
+		Result CodeDataLogger::Load(std::istream& stream) throw()
+		{
+			if (!emulator.Is(Machine::CARTRIDGE))
+				return RESULT_ERR_NOT_READY;
+
+			try
+			{
+				if (emulator.cdl == NULL)
+					emulator.cdl = new Core::CodeDataLogger( emulator.cpu, emulator.ppu, *static_cast<const Core::Cartridge*>(emulator.image) );
+
+				emulator.cdl->Load( &stream );
+			}
+			catch (Result result)
+			{
+				return result;
+			}
+			catch (const std::bad_alloc&)
+			{
+				return RESULT_ERR_OUT_OF_MEMORY;
+			}
+			catch (...)
+			{
+				return RESULT_ERR_GENERIC;
+			}
+
+			return RESULT_OK;
+		}
+
+		uint CodeDataLogger::NumBanks(Rom rom) const throw()
+		{
+			if (!emulator.Is(Machine::CARTRIDGE))
+				return 0;
+
+			const Core::Cartridge& cartridge = *static_cast<const Core::Cartridge*>(emulator.image);
+
+			if (rom == PRG)
+				return (cartridge.GetPrg().Size() + (PRG_BANK_SIZE-1)) / PRG_BANK_SIZE;
+			else
+				return (cartridge.GetChr().Size() + (CHR_BANK_SIZE-1)) / CHR_BANK_SIZE;
+		}
+
+		Result CodeDataLogger::GetCoverage(Rom rom,Coverage& coverage) const throw()
+		{
+			if (!emulator.cdl)
+				return RESULT_ERR_NOT_READY;
+
+			emulator.cdl->GetCoverage( rom, 0, emulator.cdl->GetSize(rom), coverage );
+
+			return RESULT_OK;
+		}
+
+		Result CodeDataLogger::GetCoverage(Rom rom,uint bank,Coverage& coverage) const throw()
+		{
+			if (!emulator.cdl)
+				return RESULT_ERR_NOT_READY;
+
+			const dword size = emulator.cdl->GetSize( rom );
+			const dword length = (rom == PRG ? PRG_BANK_SIZE : CHR_BANK_SIZE);
+			const dword offset = bank * length;
+
+			if (offset >= size)
+				return RESULT_ERR_INVALID_PARAM;
+
+			emulator.cdl->GetCoverage( rom, offset, NST_MIN(length,size - offset), coverage );
+
+			return RESULT_OK;
+		}
+
+		#ifdef NST_MSVC_OPTIMIZE
+		#pragma optimize("", on)
+		#endif
+	}
+}
@@ -0,0 +1,281 @@
+////////////////////////////////////////////////////////////////////////////////////////
+//
+// Nestopia - NES/Famicom emulator written in C++
+//
+// Copyright (C) 2003-2008 Martin Freij
+//
+// This file is part of Nestopia.
+//
+// Nestopia is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Nestopia is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Nestopia; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef NST_API_CODEDATALOGGER_H
+#define NST_API_CODEDATALOGGER_H
+
+#include <iosfwd>
+#include "NstApi.hpp"
+
+#ifdef NST_PRAGMA_ONCE
+#pragma once
+#endif
+
+#if NST_ICC >= 810
+#pragma warning( push )
+#pragma warning( disable : 444 )
+#elif NST_MSVC >= 1200
+#pragma warning( push )
+#pragma warning( disable : 4512 )
+#endif
+
+namespace Nes
+{
+	namespace Api
+	{
+		/**
+		* Code/data logger interface.
+		*
+		* Flags every byte of PRG-ROM and CHR-ROM by how the game used it,
+		* e.g. to tell code from data when disassembling or to see which
+		* parts of a ROM a test run never reached. Flags are kept per
+		* loaded cartridge and saved in the common .cdl layout, PRG-ROM
+		* flags first followed by CHR-ROM flags. Emulation costs nothing
+		* extra while the logger is stopped.
+		*/
+		class CodeDataLogger : public Base
+		{
+		public:
+
+			/**
+			* Interface constructor.
+			*
+			* @param instance emulator instance
+			*/
+			template<typename T>
+			CodeDataLogger(T& instance)
+			: Base(instance) {}
+
+			/**
+			* PRG-ROM byte flags.
+			*/
+			enum PrgFlag
+			{
+				/**
+				* Executed, as opcode or operand.
+				*/
+				PRG_CODE = 0x01,
+				/**
+				* Read as data.
+				*/
+				PRG_DATA = 0x02,
+				/**
+				* CPU bank the byte was last mapped to, 0 for $8000 up to 3 for $E000.
+				*/
+				PRG_BANK = 0x0C,
+				/**
+				* Executed as the target of an indirect jump.
+				*/
+				PRG_INDIRECT_CODE = 0x10,
+				/**
+				* Read as data through a pointer.
+				*/
+				PRG_INDIRECT_DATA = 0x20,
+				/**
+				* Fetched by the DMC as a sample.
+				*/
+				PRG_PCM = 0x40,
+				/**
+				* Executed as opcode. Not part of the common layout.
+				*/
+				PRG_OPCODE = 0x80
+			};
+
+			/**
+			* CHR-ROM byte flags.
+			*/
+			enum ChrFlag
+			{
+				/**
+				* Fetched by the PPU for rendering.
+				*/
+				CHR_DRAWN = 0x01,
+				/**
+				* Read by the CPU through $2007.
+				*/
+				CHR_READ = 0x02,
+				/**
+				* Fetched as background. Not part of the common layout.
+				*/
+				CHR_BG = 0x04,
+				/**
+				* Fetched as sprite. Not part of the common layout.
+				*/
+				CHR_SPRITE = 0x08
+			};
+
+			/**
+			* ROM type.
+			*/
+			enum Rom
+			{
+				/**
+				* PRG-ROM, in 8k banks.
+				*/
+				PRG,
+				/**
+				* CHR-ROM, in 1k banks.
+				*/
+				CHR
+			};
+
+			enum
+			{
+				/**
+				* Size of a PRG-ROM bank in coverage stats.
+				*/
+				PRG_BANK_SIZE = 0x2000,
+				/**
+				* Size of a CHR-ROM bank in coverage stats.
+				*/
+				CHR_BANK_SIZE = 0x0400
+			};
+
+			/**
+			* Coverage stats.
+			*
+			* Number of bytes in a bank or ROM with each kind of flag set.
+			*/
+			struct Coverage
+			{
+				/**
+				* Size in bytes.
+				*/
+				dword size;
+
+				/**
+				* Bytes with any flag set.
+				*/
+				dword logged;
+
+				/**
+				* PRG-ROM bytes executed.
+				*/
+				dword code;
+
+				/**
+				* PRG-ROM bytes read as data.
+				*/
+				dword data;
+
+				/**
+				* PRG-ROM bytes fetched as DMC samples.
+				*/
+				dword pcm;
+
+				/**
+				* CHR-ROM bytes fetched for rendering.
+				*/
+				dword drawn;
+
+				/**
+				* CHR-ROM bytes read through $2007.
+				*/
+				dword read;
+			};
+
+			/**
+			* Starts logging.
+			*
+			* Flags already logged for the cartridge are kept.
+			*
+			* @return result code
+			*/
+			Result Start() throw();
+
+			/**
+			* Stops logging.
+			*
+			* @return result code
+			*/
+			Result Stop() throw();
+
+			/**
+			* Checks if logging.
+			*
+			* @return true if logging
+			*/
+			bool IsRunning() const throw();
+
+			/**
+			* Clears all flags.
+			*
+			* @return result code
+			*/
+			Result Clear() throw();
+
+			/**
+			* Saves the flags.
+			*
+			* @param stream output stream
+			* @return result code
+			*/
+			Result Save(std::ostream& stream) const throw();
+
+			/**
+			* Loads flags, replacing the current ones.
+			*
+			* The file must have been logged with a ROM of the same PRG and CHR size.
+			*
+			* @param stream input stream
+			* @return result code
+			*/
+			Result Load(std::istream& stream) throw();
+
+			/**
+			* Returns the number of banks of a ROM.
+			*
+			* @param rom ROM type
+			* @return number, 0 if there's no such ROM or no cartridge
+			*/
+			uint NumBanks(Rom rom) const throw();
+
+			/**
+			* Returns coverage stats for a whole ROM.
+			*
+			* @param rom ROM type
+			* @param coverage stats to be filled
+			* @return result code
+			*/
+			Result GetCoverage(Rom rom,Coverage& coverage) const throw();
+
+			/**
+			* Returns coverage stats for a bank.
+			*
+			* @param rom ROM type
+			* @param bank bank number
+			* @param coverage stats to be filled
+			* @return result code
+			*/
+			Result GetCoverage(Rom rom,uint bank,Coverage& coverage) const throw();
+		};
+	}
+}
+
+#if NST_MSVC >= 1200 || NST_ICC >= 810
+#pragma warning( pop )
+#endif
+
+#endif
@@ -130,5 +130,10 @@
 //
 // NST_NO_2XSAI   - 2xSaI video filter
 //
+// Define to enable a particular feature.
+//
+// NST_PROFILE    - Frame time and event counters, see Api::Machine::GetStats().
+//                  Left out of the emulation paths entirely when undefined.
+//
 ////////////////////////////////////////////////////////////////////////////////////////
 */
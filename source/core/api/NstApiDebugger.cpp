@@ -0,0 +1,131 @@
+////////////////////////////////////////////////////////////////////////////////////////
+//
+// Nestopia - NES/Famicom emulator written in C++
+//
+// Copyright (C) 2003-2008 Martin Freij
+//
+// This file is part of Nestopia.
+//
+// Nestopia is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Nestopia is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Nestopia; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////////////
+
+
+#include <new>
+#include "../NstMachine.hpp"
+#include "../NstDebugger.hpp"
+#include "NstApiDebugger.hpp"
+
+namespace Nes
+{
+	namespace Api
+	{
+		#ifdef NST_MSVC_OPTIMIZE
+		#pragma optimize("s", on)
+		#endif
+
+		Result Debugger::SetCallback(Callback callback,UserData userData) throw()
+		{
+			if (emulator.debugger && emulator.debugger->IsBusy())
+				return RESULT_ERR_NOT_READY;
+
+			if (emulator.debugger == NULL)
+			{
+				if (callback == NULL)
+					return RESULT_NOP;
+
+				emulator.debugger = new (std::nothrow) Core::Debugger( emulator.cpu );
+
+				if (emulator.debugger == NULL)
+					return RESULT_ERR_OUT_OF_MEMORY;
+			}
+
+			emulator.debugger->SetCallback( callback, userData );
+
+			return RESULT_OK;
+		}
+
+		Result Debugger::SetBreakpoint(ushort first,ushort last,uint flags) throw()
+		{
+			if (first > last || !(flags & BREAK_ALL))
+				return RESULT_ERR_INVALID_PARAM;
+
+			if (emulator.debugger && emulator.debugger->IsBusy())
+				return RESULT_ERR_NOT_READY;
+
+			if (emulator.debugger == NULL)
+			{
+				emulator.debugger = new (std::nothrow) Core::Debugger( emulator.cpu );
+
+				if (emulator.debugger == NULL)
+					return RESULT_ERR_OUT_OF_MEMORY;
+			}
+
+			emulator.debugger->Set( first, last, flags );
+
+			return RESULT_OK;
+		}
+
+		Result Debugger::ClearBreakpoint(ushort first,ushort last,uint flags) throw()
+		{
+			if (first > last)
+				return RESULT_ERR_INVALID_PARAM;
+
+			if (!emulator.debugger)
+				return RESULT_NOP;
+
+			if (emulator.debugger->IsBusy())
+				return RESULT_ERR_NOT_READY;
+
+			emulator.debugger->Clear( first, last, flags );
+
+			return RESULT_OK;
+		}
+
+		Result Debugger::ClearBreakpoints() throw()
+		{
+			return ClearBreakpoint( 0x0000, 0xFFFF, BREAK_ALL );
+		}
+
+		uint Debugger::GetBreakpoint(ushort address) const throw()
+		{
+			return emulator.debugger ? emulator.debugger->Get( address ) : 0;
+		}
+
+		uint Debugger::NumBreakpoints() const throw()
+		{
+			return emulator.debugger ? emulator.debugger->NumBreakpoints() : 0;
+		}
+
+		Result Debugger::GetRegisters(Registers& registers) const throw()
+		{
+			Core::Cpu::Registers cpu;
+			emulator.cpu.GetRegisters( cpu );
+
+			registers.pc = cpu.pc;
+			registers.a = cpu.a;
+			registers.x = cpu.x;
+			registers.y = cpu.y;
+			registers.sp = cpu.sp;
+			registers.p = cpu.p;
+
+			return RESULT_OK;
+		}
+
+		#ifdef NST_MSVC_OPTIMIZE
+		#pragma optimize("", on)
+		#endif
+	}
+}
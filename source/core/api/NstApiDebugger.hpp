@@ -0,0 +1,249 @@
+////////////////////////////////////////////////////////////////////////////////////////
+//
+// Nestopia - NES/Famicom emulator written in C++
+//
+// Copyright (C) 2003-2008 Martin Freij
+//
+// This file is part of Nestopia.
+//
+// Nestopia is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Nestopia is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Nestopia; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef NST_API_DEBUGGER_H
+#define NST_API_DEBUGGER_H
+
+#include "NstApi.hpp"
+
+#ifdef NST_PRAGMA_ONCE
+#pragma once
+#endif
+
+#if NST_ICC >= 810
+#pragma warning( push )
+#pragma warning( disable : 444 )
+#elif NST_MSVC >= 1200
+#pragma warning( push )
+#pragma warning( disable : 4512 )
+#endif
+
+namespace Nes
+{
+	namespace Api
+	{
+		/**
+		* Debugger interface.
+		*
+		* Breaks on reads, writes or execution of CPU addresses. Only the
+		* watched addresses are trapped, by wrapping their memory ports, so
+		* emulation costs nothing extra while no breakpoint is set and stays
+		* close to full speed with a few.
+		*
+		* Breaks are reported through a callback at an instruction boundary,
+		* with emulation suspended until it returns. Execution breaks are
+		* reported before the instruction is executed, reads and writes once
+		* the instruction doing them has completed. Breakpoints are kept across
+		* resets and loaded games. Neither they nor the callback can be changed
+		* from within the callback, where SetCallback(), SetBreakpoint() and
+		* ClearBreakpoint() return RESULT_ERR_NOT_READY.
+		*
+		* The CPU reads and writes zero page and stack RAM directly. Writes
+		* there are still caught when they change the value, reads are not.
+		*/
+		class Debugger : public Base
+		{
+		public:
+
+			/**
+			* Interface constructor.
+			*
+			* @param instance emulator instance
+			*/
+			template<typename T>
+			Debugger(T& instance)
+			: Base(instance) {}
+
+			/**
+			* Breakpoint flags.
+			*/
+			enum Break
+			{
+				/**
+				* Break on reads.
+				*/
+				BREAK_READ = 0x1,
+				/**
+				* Break on writes.
+				*/
+				BREAK_WRITE = 0x2,
+				/**
+				* Break on execution of an instruction starting at the address.
+				*/
+				BREAK_EXEC = 0x4,
+				/**
+				* All of the above.
+				*/
+				BREAK_ALL = BREAK_READ|BREAK_WRITE|BREAK_EXEC
+			};
+
+			/**
+			* Break event.
+			*/
+			struct Event
+			{
+				/**
+				* What caused the break, one of BREAK_READ, BREAK_WRITE and BREAK_EXEC.
+				*/
+				Break type;
+
+				/**
+				* Address accessed.
+				*/
+				ushort address;
+
+				/**
+				* Data read or written, the opcode for BREAK_EXEC.
+				*/
+				uchar data;
+
+				/**
+				* Address of the instruction that did the access.
+				*/
+				ushort pc;
+
+				/**
+				* Number of further reads and writes by the same instruction that
+				* were dropped after this one, such as during a sprite DMA.
+				*/
+				uint dropped;
+			};
+
+			/**
+			* CPU registers.
+			*/
+			struct Registers
+			{
+				/**
+				* Program counter.
+				*/
+				ushort pc;
+
+				/**
+				* Accumulator.
+				*/
+				uchar a;
+
+				/**
+				* X register.
+				*/
+				uchar x;
+
+				/**
+				* Y register.
+				*/
+				uchar y;
+
+				/**
+				* Stack pointer.
+				*/
+				uchar sp;
+
+				/**
+				* Status register.
+				*/
+				uchar p;
+			};
+
+			/**
+			* Break callback prototype.
+			*
+			* @param userData optional user data
+			* @param event what caused the break
+			*/
+			typedef void (NST_CALLBACK *Callback) (UserData userData,const Event& event);
+
+			/**
+			* Sets the callback breaks are reported to.
+			*
+			* @param callback callback, NULL to stop reporting
+			* @param userData optional user data
+			* @return result code
+			*/
+			Result SetCallback(Callback callback,UserData userData=NULL) throw();
+
+			/**
+			* Sets breakpoints on a range of addresses.
+			*
+			* Flags already set on the addresses are kept.
+			*
+			* @param first first address
+			* @param last last address
+			* @param flags combination of BREAK_READ, BREAK_WRITE and BREAK_EXEC
+			* @return result code
+			*/
+			Result SetBreakpoint(ushort first,ushort last,uint flags) throw();
+
+			/**
+			* Clears breakpoints on a range of addresses.
+			*
+			* @param first first address
+			* @param last last address
+			* @param flags flags to clear
+			* @return result code
+			*/
+			Result ClearBreakpoint(ushort first,ushort last,uint flags=BREAK_ALL) throw();
+
+			/**
+			* Clears all breakpoints.
+			*
+			* @return result code
+			*/
+			Result ClearBreakpoints() throw();
+
+			/**
+			* Returns the breakpoint flags of an address.
+			*
+			* @param address address
+			* @return flags
+			*/
+			uint GetBreakpoint(ushort address) const throw();
+
+			/**
+			* Returns the number of addresses with a breakpoint.
+			*
+			* @return number
+			*/
+			uint NumBreakpoints() const throw();
+
+			/**
+			* Returns the CPU registers.
+			*
+			* Inside the callback these are the registers at the instruction
+			* boundary the break is reported at.
+			*
+			* @param registers registers to be filled
+			* @return result code
+			*/
+			Result GetRegisters(Registers& registers) const throw();
+		};
+	}
+}
+
+#if NST_MSVC >= 1200 || NST_ICC >= 810
+#pragma warning( pop )
+#endif
+
+#endif
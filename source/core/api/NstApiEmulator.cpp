@@ -22,8 +22,13 @@
 //
 ////////////////////////////////////////////////////////////////////////////////////////
 
+#include <new>
 #include "../NstMachine.hpp"
+#include "../input/NstInpDevice.hpp"
+#include "../input/NstInpAdapter.hpp"
 #include "NstApiEmulator.hpp"
+#include "NstApiMachine.hpp"
+#include "NstApiInput.hpp"
 
 namespace Nes
 {
@@ -61,5 +66,64 @@ namespace Nes
 		{
 			return machine.tracker.Frame();
 		}
+
+		#ifdef NST_MSVC_OPTIMIZE
+		#pragma optimize("s", on)
+		#endif
+
+		Result Emulator::Clone(Emulator& target) const throw()
+		{
+			if (&target == this)
+				return RESULT_ERR_INVALID_PARAM;
+
+			if (!machine.Is(Machine::GAME,Machine::ON) || target.machine.tracker.IsLocked())
+				return RESULT_ERR_NOT_READY;
+
+			try
+			{
+				target.machine.CloneImage( machine );
+
+				if (machine.imageDatabase)
+					target.machine.ShareImageDatabase( machine );
+
+				Input input( target );
+				input.ConnectAdapter( machine.extPort->GetType() );
+
+				for (uint i=0; i < Input::NUM_PORTS; ++i)
+				{
+					Input::Type type = Input::UNCONNECTED;
+
+					if (i == Input::EXPANSION_PORT)
+						type = machine.expPort->GetType();
+					else if (i < machine.extPort->NumPorts())
+						type = machine.extPort->GetDevice( i ).GetType();
+
+					if (i != Input::EXPANSION_PORT && i >= target.machine.extPort->NumPorts())
+						continue;
+
+					input.ConnectController( i, type );
+				}
+
+				target.machine.CloneState( machine );
+			}
+			catch (Result result)
+			{
+				return result;
+			}
+			catch (const std::bad_alloc&)
+			{
+				return RESULT_ERR_OUT_OF_MEMORY;
+			}
+			catch (...)
+			{
+				return RESULT_ERR_GENERIC;
+			}
+
+			return RESULT_OK;
+		}
+
+		#ifdef NST_MSVC_OPTIMIZE
+		#pragma optimize("", on)
+		#endif
 	}
 }
@@ -93,6 +93,22 @@ namespace Nes
 			*/
 			ulong Frame() const throw();
 
+			/**
+			* Makes another emulator instance a clone of this one.
+			*
+			* The clone gets its own copy of the machine state and the connected
+			* controllers, and runs on independently from then on. The ROM and the
+			* image databases are shared rather than copied, so this instance must
+			* outlive the clone and must not load or unload an image in the meantime.
+			* Cloning into the same target again only copies the state. Cheats,
+			* movies, rewinding and output settings are not carried over. Only
+			* cartridges can be cloned.
+			*
+			* @param target emulator instance to become the clone
+			* @return result code
+			*/
+			Result Clone(Emulator& target) const throw();
+
 		private:
 
 			Core::Machine& machine;
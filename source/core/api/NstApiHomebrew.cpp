@@ -217,6 +217,36 @@ namespace Nes
 			return RESULT_OK;
 		}
 
+		Result Homebrew::Capture(std::ostream* stream) throw()
+		{
+			if (emulator.tracker.IsLocked( true ))
+				return RESULT_ERR_NOT_READY;
+
+			try
+			{
+				if (emulator.homebrew == NULL)
+					emulator.homebrew = new Core::Homebrew( emulator.cpu );
+
+				emulator.homebrew->Capture( stream );
+			}
+			catch (const std::bad_alloc&)
+			{
+				return RESULT_ERR_OUT_OF_MEMORY;
+			}
+			catch (...)
+			{
+				return RESULT_ERR_GENERIC;
+			}
+
+			return RESULT_OK;
+		}
+
+		bool Homebrew::GetExitCode(uint& code) const throw()
+		{
+			code = 0;
+			return emulator.homebrew && emulator.homebrew->GetExitCode( code );
+		}
+
 		#ifdef NST_MSVC_OPTIMIZE
 		#pragma optimize("", on)
 		#endif
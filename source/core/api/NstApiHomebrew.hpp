@@ -25,6 +25,7 @@
 #ifndef NST_API_HOMEBREW_H
 #define NST_API_HOMEBREW_H
 
+#include <iosfwd>
 #include "NstApi.hpp"
 
 #ifdef NST_PRAGMA_ONCE
@@ -120,6 +121,29 @@ namespace Nes
 			* @return result code
 			*/
 			Result ClearPorts() throw();
+
+			/**
+			* Captures the ports instead of passing them on to the process.
+			*
+			* While capturing, bytes written to the standard out and standard
+			* error ports go to the given stream, and a write to the exit port
+			* is recorded rather than ending the process. Useful for running
+			* several emulator instances in one process, e.g. for test ROMs.
+			*
+			* @param stream stream for the output, NULL to stop capturing
+			* @return result code
+			*/
+			Result Capture(std::ostream* stream) throw();
+
+			/**
+			* Returns the exit code recorded while capturing.
+			*
+			* The code is cleared by a machine reset or a new capture.
+			*
+			* @param code exit code to be filled
+			* @return true if the exit port has been written to
+			*/
+			bool GetExitCode(uint& code) const throw();
 		};
 	}
 }
@@ -126,6 +126,10 @@ namespace Nes
 
 					typedef bool (NST_CALLBACK *PollCallback) (void*,Pad&,uint);
 
+					/**
+					* Invoked at most once per frame for each pad, on the first strobe or
+					* read of its port, so the host input may be sampled that late.
+					*/
 					static PollCaller2<Pad> callback;
 				};
 
@@ -23,6 +23,8 @@
 ////////////////////////////////////////////////////////////////////////////////////////
 
 #include <new>
+#include <cstring>
+#include <sstream>
 #include "../NstMachine.hpp"
 #include "../NstImage.hpp"
 #include "../NstState.hpp"
@@ -275,6 +277,167 @@ namespace Nes
 			return RESULT_OK;
 		}
 
+		Result Machine::SaveState(Snapshot& snapshot) const throw()
+		{
+			if (!Is(GAME,ON))
+				return RESULT_ERR_NOT_READY;
+
+			try
+			{
+				snapshot.stream.clear();
+				snapshot.stream.str( std::string() );
+
+				Core::State::Saver saver( &static_cast<std::ostream&>(snapshot.stream), snapshot.layout );
+				emulator.SaveState( saver );
+
+				return RESULT_OK;
+			}
+			catch (Result result)
+			{
+				snapshot.stream.str( std::string() );
+				return result;
+			}
+			catch (const std::bad_alloc&)
+			{
+				snapshot.stream.str( std::string() );
+				return RESULT_ERR_OUT_OF_MEMORY;
+			}
+			catch (...)
+			{
+				snapshot.stream.str( std::string() );
+				return RESULT_ERR_GENERIC;
+			}
+		}
+
+		Result Machine::GetStats(Stats& stats) const throw()
+		{
+			std::memset( &stats, 0, sizeof(stats) );
+
+		#ifdef NST_PROFILE
+
+			NST_COMPILE_ASSERT
+			(
+				uint(Stats::NUM_SECTIONS) == uint(Core::Profiler::NUM_SECTIONS) &&
+				uint(Stats::NUM_REGIONS) == uint(Core::Profiler::NUM_REGIONS)
+			);
+
+			if (!Is(ON))
+				return RESULT_ERR_NOT_READY;
+
+			const Core::Profiler& profiler = emulator.profiler;
+			const Core::Profiler::Counters& last = profiler.last;
+
+			stats.frames = profiler.frames;
+			stats.frameTime = dword(profiler.lastTime);
+
+			for (uint i=0; i < Stats::NUM_SECTIONS; ++i)
+			{
+				stats.cycles[i] = dword(last.ticks[i]);
+
+				if (profiler.totalTicks)
+					stats.time[i] = dword(double(last.ticks[i]) * double(profiler.totalTime) / double(profiler.totalTicks));
+			}
+
+			for (uint i=0; i < Stats::NUM_REGIONS; ++i)
+			{
+				stats.reads[i] = last.reads[i];
+				stats.writes[i] = last.writes[i];
+			}
+
+			stats.instructions = last.events[Core::Profiler::EVENT_INSTRUCTIONS];
+			stats.bankSwitches = last.events[Core::Profiler::EVENT_BANK_SWITCHES];
+			stats.irqs = last.events[Core::Profiler::EVENT_IRQS];
+			stats.nmis = last.events[Core::Profiler::EVENT_NMIS];
+			stats.dmcDmas = last.events[Core::Profiler::EVENT_DMC_DMAS];
+
+			return RESULT_OK;
+
+		#else
+
+			return RESULT_ERR_UNSUPPORTED;
+
+		#endif
+		}
+
+		Result Machine::GetStateHash(StateHash& stateHash) const throw()
+		{
+			stateHash.hi = 0;
+			stateHash.lo = 0;
+
+			if (!Is(GAME,ON))
+				return RESULT_ERR_NOT_READY;
+
+			try
+			{
+				Core::State::Hash hash;
+
+				{
+					Core::State::Saver saver( hash );
+					emulator.SaveState( saver );
+				}
+
+				hash.Digest( stateHash.hi, stateHash.lo );
+			}
+			catch (Result result)
+			{
+				return result;
+			}
+			catch (const std::bad_alloc&)
+			{
+				return RESULT_ERR_OUT_OF_MEMORY;
+			}
+			catch (...)
+			{
+				return RESULT_ERR_GENERIC;
+			}
+
+			return RESULT_OK;
+		}
+
+		Machine::Snapshot::Snapshot()
+		:
+		stream (*new std::stringstream),
+		layout (*new Core::State::Layout)
+		{
+		}
+
+		Machine::Snapshot::~Snapshot() throw()
+		{
+			delete &stream;
+			delete &layout;
+		}
+
+		bool Machine::Snapshot::IsEmpty() const throw()
+		{
+			return stream.tellp() <= 0;
+		}
+
+		Result Machine::Snapshot::Write(std::ostream& out,Compression compression) const throw()
+		{
+			if (IsEmpty())
+				return RESULT_ERR_NOT_READY;
+
+			try
+			{
+				const std::string data( stream.str() );
+				layout.Write( reinterpret_cast<const byte*>(data.data()), data.size(), &out, compression != NO_COMPRESSION );
+			}
+			catch (Result result)
+			{
+				return result;
+			}
+			catch (const std::bad_alloc&)
+			{
+				return RESULT_ERR_OUT_OF_MEMORY;
+			}
+			catch (...)
+			{
+				return RESULT_ERR_GENERIC;
+			}
+
+			return RESULT_OK;
+		}
+
 		#ifdef NST_MSVC_OPTIMIZE
 		#pragma optimize("", on)
 		#endif
@@ -42,6 +42,14 @@
 
 namespace Nes
 {
+	namespace Core
+	{
+		namespace State
+		{
+			class Layout;
+		}
+	}
+
 	namespace Api
 	{
 		/**
@@ -301,6 +309,50 @@ namespace Nes
 				USE_COMPRESSION
 			};
 
+			/**
+			* Uncompressed state snapshot.
+			*
+			* Taken on the emulation thread without doing any compression work.
+			* The snapshot can then be written out as a regular state from any
+			* other thread while the emulation carries on.
+			*/
+			class Snapshot
+			{
+			public:
+
+				Snapshot();
+				~Snapshot() throw();
+
+				/**
+				* Writes the snapshot as a regular state.
+				*
+				* The machine is not accessed so this may be called from
+				* a thread other than the one running the emulator.
+				*
+				* @param stream output stream which the state will be written to
+				* @param compression to allow internal compression in the state, default is USE_COMPRESSION
+				* @return result code
+				*/
+				Result Write(std::ostream& stream,Compression compression=USE_COMPRESSION) const throw();
+
+				/**
+				* Tells if the snapshot is empty.
+				*
+				* @return true if no state has been saved into it
+				*/
+				bool IsEmpty() const throw();
+
+			private:
+
+				friend class Machine;
+
+				Snapshot(const Snapshot&);
+				void operator = (const Snapshot&);
+
+				std::stringstream& stream;
+				Core::State::Layout& layout;
+			};
+
 			/**
 			* Loads a state.
 			*
@@ -318,6 +370,225 @@ namespace Nes
 			*/
 			Result SaveState(std::ostream& stream,Compression compression=USE_COMPRESSION) const throw();
 
+			/**
+			* Saves a state into a snapshot.
+			*
+			* The state is stored uncompressed in memory. Compression and any file
+			* output are left to Snapshot::Write() which can be done elsewhere.
+			*
+			* @param snapshot snapshot which the state will be saved to
+			* @return result code
+			*/
+			Result SaveState(Snapshot& snapshot) const throw();
+
+			/**
+			* State hash.
+			*
+			* 64-bit non-cryptographic hash of the machine state.
+			*/
+			struct StateHash
+			{
+				/**
+				* Upper 32 bits.
+				*/
+				dword hi;
+
+				/**
+				* Lower 32 bits.
+				*/
+				dword lo;
+
+				bool operator == (const StateHash& h) const
+				{
+					return hi == h.hi && lo == h.lo;
+				}
+
+				bool operator != (const StateHash& h) const
+				{
+					return hi != h.hi || lo != h.lo;
+				}
+			};
+
+			/**
+			* Computes a hash of the current machine state.
+			*
+			* Covers everything a state save would, CPU, RAM, PPU, APU, board
+			* and input devices, but nothing is serialized or compressed. Two
+			* machines in the same state yield the same hash, which makes it
+			* suitable for desync detection.
+			*
+			* @param hash hash to be filled
+			* @return result code
+			*/
+			Result GetStateHash(StateHash& hash) const throw();
+
+			/**
+			* Frame statistics.
+			*
+			* Where the time of the last frame went and what the emulated
+			* hardware did in it. Only available in builds with NST_PROFILE
+			* defined.
+			*/
+			struct Stats
+			{
+				/**
+				* Parts of a frame that are timed.
+				*
+				* Time is counted in the innermost part only, so the CPU time
+				* excludes any PPU catch-up and APU sync done on its behalf.
+				*/
+				enum Section
+				{
+					/**
+					* Everything not covered below.
+					*/
+					SECTION_OTHER,
+					/**
+					* CPU emulation, including board and input port logic.
+					*/
+					SECTION_CPU,
+					/**
+					* PPU catch-up.
+					*/
+					SECTION_PPU,
+					/**
+					* APU sync and sound rendering.
+					*/
+					SECTION_APU,
+					/**
+					* Video filter, the one set in Video::RenderState.
+					*/
+					SECTION_BLIT,
+					/**
+					* Video::Output lock and unlock callbacks.
+					*/
+					SECTION_VIDEO_LOCK,
+					/**
+					* Sound::Output lock and unlock callbacks.
+					*/
+					SECTION_SOUND_LOCK,
+					/**
+					* Rewinder bookkeeping.
+					*/
+					SECTION_REWINDER,
+					/**
+					* Movie recording or playback.
+					*/
+					SECTION_MOVIE,
+					/**
+					* Number of sections.
+					*/
+					NUM_SECTIONS
+				};
+
+				/**
+				* CPU address space regions, 8k each.
+				*/
+				enum Region
+				{
+					/**
+					* $0000-$1FFF, RAM. Zero page and stack accesses are not counted.
+					*/
+					REGION_RAM,
+					/**
+					* $2000-$3FFF, PPU registers.
+					*/
+					REGION_PPU,
+					/**
+					* $4000-$5FFF, APU, I/O and expansion.
+					*/
+					REGION_APU,
+					/**
+					* $6000-$7FFF, usually WRAM.
+					*/
+					REGION_WRAM,
+					/**
+					* $8000-$9FFF.
+					*/
+					REGION_PRG_8000,
+					/**
+					* $A000-$BFFF.
+					*/
+					REGION_PRG_A000,
+					/**
+					* $C000-$DFFF.
+					*/
+					REGION_PRG_C000,
+					/**
+					* $E000-$FFFF.
+					*/
+					REGION_PRG_E000,
+					/**
+					* Number of regions.
+					*/
+					NUM_REGIONS
+				};
+
+				/**
+				* Number of frames measured since power-on.
+				*/
+				dword frames;
+
+				/**
+				* Wall time of the frame in nanoseconds.
+				*/
+				dword frameTime;
+
+				/**
+				* Host clock cycles per section, from the time stamp counter
+				* where there is one, otherwise same as time.
+				*/
+				dword cycles[NUM_SECTIONS];
+
+				/**
+				* Wall time per section in nanoseconds.
+				*/
+				dword time[NUM_SECTIONS];
+
+				/**
+				* Instructions executed.
+				*/
+				dword instructions;
+
+				/**
+				* Bus reads per region, opcode fetches included.
+				*/
+				dword reads[NUM_REGIONS];
+
+				/**
+				* Bus writes per region.
+				*/
+				dword writes[NUM_REGIONS];
+
+				/**
+				* PRG, CHR and nametable bank switches.
+				*/
+				dword bankSwitches;
+
+				/**
+				* IRQs taken.
+				*/
+				dword irqs;
+
+				/**
+				* NMIs taken.
+				*/
+				dword nmis;
+
+				/**
+				* DMC sample fetches.
+				*/
+				dword dmcDmas;
+			};
+
+			/**
+			* Returns statistics of the last frame.
+			*
+			* @param stats statistics to be filled
+			* @return result code, RESULT_ERR_UNSUPPORTED if NST_PROFILE wasn't defined
+			*/
+			Result GetStats(Stats& stats) const throw();
+
 			/**
 			* Returns a machine state.
 			*
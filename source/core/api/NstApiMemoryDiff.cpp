@@ -0,0 +1,120 @@
+////////////////////////////////////////////////////////////////////////////////////////
+//
+// Nestopia - NES/Famicom emulator written in C++
+//
+// Copyright (C) 2003-2008 Martin Freij
+//
+// This file is part of Nestopia.
+//
+// Nestopia is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Nestopia is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Nestopia; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////////////
+
+
+#include <new>
+#include "../NstMachine.hpp"
+#include "../NstCartridge.hpp"
+#include "../board/NstBoard.hpp"
+#include "../NstMemoryDiff.hpp"
+#include "NstApiMachine.hpp"
+#include "NstApiMemoryDiff.hpp"
+
+namespace Nes
+{
+	namespace Api
+	{
+		#ifdef NST_MSVC_OPTIMIZE
+		#pragma optimize("s", on)
+		#endif
+
+		Result MemoryDiff::Start(const uint regions,const Callback callback,const UserData userData,const uint gap) throw()
+		{
+			if (!callback || !(regions & REGION_ALL) || (regions & ~uint(REGION_ALL)))
+				return RESULT_ERR_INVALID_PARAM;
+
+			if (!emulator.Is(Machine::GAME) || (emulator.diff && emulator.diff->IsBusy()))
+				return RESULT_ERR_NOT_READY;
+
+			Stop();
+
+			try
+			{
+				emulator.diff = new Core::MemoryDiff( callback, userData, gap );
+
+				if (regions & REGION_CPU_RAM)
+					emulator.diff->Add( REGION_CPU_RAM, emulator.cpu.GetRam(), Core::Cpu::RAM_SIZE );
+
+				if ((regions & REGION_WRAM) && emulator.Is(Machine::CARTRIDGE))
+				{
+					const Core::Boards::Board& board = static_cast<const Core::Cartridge*>(emulator.image)->GetBoard();
+
+					if (const dword size = board.GetType().GetWram())
+						emulator.diff->Add( REGION_WRAM, board.GetWrk().Source().Mem(), size );
+				}
+
+				if (regions & REGION_OAM)
+					emulator.diff->Add( REGION_OAM, emulator.ppu.GetOam().ram, sizeof(emulator.ppu.GetOam().ram) );
+
+				if (regions & REGION_PALETTE)
+					emulator.diff->Add( REGION_PALETTE, emulator.ppu.GetPalette().ram, sizeof(emulator.ppu.GetPalette().ram) );
+			}
+			catch (const std::bad_alloc&)
+			{
+				Stop();
+				return RESULT_ERR_OUT_OF_MEMORY;
+			}
+			catch (...)
+			{
+				Stop();
+				return RESULT_ERR_GENERIC;
+			}
+
+			return RESULT_OK;
+		}
+
+		Result MemoryDiff::Stop() throw()
+		{
+			if (!emulator.diff)
+				return RESULT_NOP;
+
+			if (emulator.diff->IsBusy())
+				return RESULT_ERR_NOT_READY;
+
+			delete emulator.diff;
+			emulator.diff = NULL;
+
+			return RESULT_OK;
+		}
+
+		bool MemoryDiff::IsRunning() const throw()
+		{
+			return emulator.diff != NULL;
+		}
+
+		Result MemoryDiff::Resync() throw()
+		{
+			if (!emulator.diff || emulator.diff->IsBusy())
+				return RESULT_ERR_NOT_READY;
+
+			emulator.diff->Resync();
+
+			return RESULT_OK;
+		}
+
+		#ifdef NST_MSVC_OPTIMIZE
+		#pragma optimize("", on)
+		#endif
+	}
+}
@@ -0,0 +1,184 @@
+////////////////////////////////////////////////////////////////////////////////////////
+//
+// Nestopia - NES/Famicom emulator written in C++
+//
+// Copyright (C) 2003-2008 Martin Freij
+//
+// This file is part of Nestopia.
+//
+// Nestopia is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Nestopia is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Nestopia; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef NST_API_MEMORYDIFF_H
+#define NST_API_MEMORYDIFF_H
+
+#include "NstApi.hpp"
+
+#ifdef NST_PRAGMA_ONCE
+#pragma once
+#endif
+
+#if NST_ICC >= 810
+#pragma warning( push )
+#pragma warning( disable : 444 )
+#elif NST_MSVC >= 1200
+#pragma warning( push )
+#pragma warning( disable : 4512 )
+#endif
+
+namespace Nes
+{
+	namespace Api
+	{
+		/**
+		* Memory diff interface.
+		*
+		* Reports what changed in the selected memory regions at the end of
+		* every frame, as a list of spans of bytes. The regions are compared
+		* with copies kept from the previous frame, so only the changed bytes
+		* need to be looked at or copied by the caller. The first frame after
+		* starting reports the regions whole.
+		*/
+		class MemoryDiff : public Base
+		{
+		public:
+
+			/**
+			* Interface constructor.
+			*
+			* @param instance emulator instance
+			*/
+			template<typename T>
+			MemoryDiff(T& instance)
+			: Base(instance) {}
+
+			/**
+			* Memory regions.
+			*/
+			enum Region
+			{
+				/**
+				* 2k CPU RAM.
+				*/
+				REGION_CPU_RAM = 0x1,
+				/**
+				* Cartridge work RAM, left out if the cartridge has none.
+				*/
+				REGION_WRAM = 0x2,
+				/**
+				* 256 byte sprite memory.
+				*/
+				REGION_OAM = 0x4,
+				/**
+				* 32 byte palette memory.
+				*/
+				REGION_PALETTE = 0x8,
+				/**
+				* All of the above.
+				*/
+				REGION_ALL = REGION_CPU_RAM|REGION_WRAM|REGION_OAM|REGION_PALETTE
+			};
+
+			enum
+			{
+				/**
+				* Default number of unchanged bytes a span may bridge.
+				*/
+				DEFAULT_GAP = 8
+			};
+
+			/**
+			* Changed span.
+			*/
+			struct Span
+			{
+				/**
+				* Region the span is in.
+				*/
+				Region region;
+
+				/**
+				* Offset of the first byte in the region.
+				*/
+				uint offset;
+
+				/**
+				* Number of bytes.
+				*/
+				uint length;
+
+				/**
+				* New contents, only valid during the callback.
+				*/
+				const uchar* data;
+			};
+
+			/**
+			* Frame callback prototype.
+			*
+			* Called at the end of each frame in which anything changed. Start(),
+			* Stop() and Resync() return RESULT_ERR_NOT_READY from within it.
+			*
+			* @param userData optional user data
+			* @param frame number of the frame, as counted by the machine
+			* @param spans changed spans, in region and offset order
+			* @param count number of spans
+			*/
+			typedef void (NST_CALLBACK *Callback) (UserData userData,ulong frame,const Span* spans,uint count);
+
+			/**
+			* Starts reporting changes.
+			*
+			* Any previous diff is replaced.
+			*
+			* @param regions combination of REGION_CPU_RAM, REGION_WRAM, REGION_OAM and REGION_PALETTE
+			* @param callback callback
+			* @param userData optional user data
+			* @param gap unchanged bytes between two changes below which they are joined in one span
+			* @return result code
+			*/
+			Result Start(uint regions,Callback callback,UserData userData=NULL,uint gap=DEFAULT_GAP) throw();
+
+			/**
+			* Stops reporting changes and releases the copies.
+			*
+			* @return result code
+			*/
+			Result Stop() throw();
+
+			/**
+			* Checks if changes are being reported.
+			*
+			* @return true if running
+			*/
+			bool IsRunning() const throw();
+
+			/**
+			* Reports the regions whole at the end of the next frame.
+			*
+			* @return result code
+			*/
+			Result Resync() throw();
+		};
+	}
+}
+
+#if NST_MSVC >= 1200 || NST_ICC >= 810
+#pragma warning( pop )
+#endif
+
+#endif
@@ -42,9 +42,24 @@ namespace Nes
 			return emulator.tracker.PlayMovie( emulator, stream );
 		}
 
-		Result Movie::Record(std::iostream& stream,How how) throw()
+		Result Movie::Record(std::iostream& stream,How how,uint hashInterval,uint keyInterval) throw()
 		{
-			return emulator.tracker.RecordMovie( emulator, stream, how == APPEND );
+			return emulator.tracker.RecordMovie( emulator, stream, how == APPEND, hashInterval, keyInterval );
+		}
+
+		Result Movie::Seek(ulong frame) throw()
+		{
+			return emulator.tracker.SeekMovie( emulator, frame );
+		}
+
+		Result Movie::LoadIndex(std::istream& stream) throw()
+		{
+			return emulator.tracker.LoadMovieIndex( stream );
+		}
+
+		Result Movie::SaveIndex(std::ostream& stream,uint interval) throw()
+		{
+			return emulator.tracker.SaveMovieIndex( emulator, stream, interval );
 		}
 
 		void Movie::Stop() throw()
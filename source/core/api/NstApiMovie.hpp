@@ -88,11 +88,53 @@ namespace Nes
 			/**
 			* Records movie.
 			*
+			* When a hash interval is given, the machine state hash is recorded
+			* every so many frames and checked again on playback. Mismatches are
+			* reported through the log.
+			*
+			* When a key interval is given, a state is embedded every so many
+			* frames together with a seek index at the end, see Seek().
+			*
 			* @param stream stream to record movie to
 			* @param how CLEAN to erase any previous content, APPEND to keep content, default is CLEAN
+			* @param hashInterval frames between recorded state hashes, default is 0 for none
+			* @param keyInterval frames between embedded states, default is 0 for none
+			* @return result code
+			*/
+			Result Record(std::iostream& stream,How how=CLEAN,uint hashInterval=0,uint keyInterval=0) throw();
+
+			/**
+			* Seeks to a frame in the movie being played.
+			*
+			* The nearest state at or before the frame is restored and the
+			* remaining frames are emulated without any output. States come from
+			* the movie itself and from any index loaded with LoadIndex().
+			*
+			* @param frame frame to seek to, counted from the start of the movie
+			* @return result code
+			*/
+			Result Seek(ulong frame) throw();
+
+			/**
+			* Loads a sidecar index for the movie being played.
+			*
+			* @param stream input stream to an index written by SaveIndex()
+			* @return result code
+			*/
+			Result LoadIndex(std::istream& stream) throw();
+
+			/**
+			* Writes a sidecar index for the movie being played.
+			*
+			* Plays the movie through to the end without any output while saving
+			* a state every given number of frames. Meant for movies recorded
+			* without embedded states.
+			*
+			* @param stream output stream to write the index to
+			* @param interval frames between saved states
 			* @return result code
 			*/
-			Result Record(std::iostream& stream,How how=CLEAN) throw();
+			Result SaveIndex(std::ostream& stream,uint interval) throw();
 
 			/**
 			* Stops movie.
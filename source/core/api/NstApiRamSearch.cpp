@@ -0,0 +1,192 @@
+////////////////////////////////////////////////////////////////////////////////////////
+//
+// Nestopia - NES/Famicom emulator written in C++
+//
+// Copyright (C) 2003-2008 Martin Freij
+//
+// This file is part of Nestopia.
+//
+// Nestopia is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Nestopia is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Nestopia; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////////////
+
+
+#include <new>
+#include "../NstMachine.hpp"
+#include "../NstCartridge.hpp"
+#include "../board/NstBoard.hpp"
+#include "../NstRamSearch.hpp"
+#include "NstApiMachine.hpp"
+#include "NstApiRamSearch.hpp"
+
+namespace Nes
+{
+	namespace Api
+	{
+		#ifdef NST_MSVC_OPTIMIZE
+		#pragma optimize("s", on)
+		#endif
+
+		Result RamSearch::Start(const Region region,const uint size,const bool sign) throw()
+		{
+			if (size != 1 && size != 2 && size != 4)
+				return RESULT_ERR_INVALID_PARAM;
+
+			const byte* mem = NULL;
+			dword length = 0;
+
+			if (region == REGION_CPU_RAM)
+			{
+				if (!emulator.Is(Machine::GAME))
+					return RESULT_ERR_NOT_READY;
+
+				mem = emulator.cpu.GetRam();
+				length = Core::Cpu::RAM_SIZE;
+			}
+			else if (region == REGION_WRAM || region == REGION_CHR_RAM)
+			{
+				if (!emulator.Is(Machine::CARTRIDGE))
+					return RESULT_ERR_NOT_READY;
+
+				const Core::Boards::Board& board = static_cast<const Core::Cartridge*>(emulator.image)->GetBoard();
+
+				if (region == REGION_WRAM)
+				{
+					mem = board.GetWrk().Source().Mem();
+					length = board.GetType().GetWram();
+				}
+				else
+				{
+					mem = board.GetVram().Mem();
+					length = board.GetType().GetChrRam();
+				}
+
+				if (!length)
+					return RESULT_ERR_UNSUPPORTED;
+			}
+			else
+			{
+				return RESULT_ERR_INVALID_PARAM;
+			}
+
+			Stop();
+
+			try
+			{
+				emulator.search = new Core::RamSearch( mem, length, size, sign );
+			}
+			catch (const std::bad_alloc&)
+			{
+				return RESULT_ERR_OUT_OF_MEMORY;
+			}
+			catch (...)
+			{
+				return RESULT_ERR_GENERIC;
+			}
+
+			return RESULT_OK;
+		}
+
+		Result RamSearch::Stop() throw()
+		{
+			if (!emulator.search)
+				return RESULT_NOP;
+
+			delete emulator.search;
+			emulator.search = NULL;
+
+			return RESULT_OK;
+		}
+
+		bool RamSearch::IsRunning() const throw()
+		{
+			return emulator.search != NULL;
+		}
+
+		Result RamSearch::Filter(const Compare compare,const Operand operand,const long value) throw()
+		{
+			if (!emulator.search)
+				return RESULT_ERR_NOT_READY;
+
+			if (uint(compare) > COMPARE_CHANGED_BY || uint(operand) > OPERAND_VALUE)
+				return RESULT_ERR_INVALID_PARAM;
+
+			emulator.search->Filter( compare, operand, value );
+
+			return RESULT_OK;
+		}
+
+		Result RamSearch::Schedule(const ulong frames,const Compare compare,const Operand operand,const long value) throw()
+		{
+			if (!emulator.search)
+				return RESULT_ERR_NOT_READY;
+
+			if (uint(compare) > COMPARE_CHANGED_BY || uint(operand) > OPERAND_VALUE)
+				return RESULT_ERR_INVALID_PARAM;
+
+			emulator.search->Schedule( frames, compare, operand, value );
+
+			return RESULT_OK;
+		}
+
+		ulong RamSearch::NumScheduled() const throw()
+		{
+			return emulator.search ? emulator.search->NumScheduled() : 0;
+		}
+
+		Result RamSearch::Snapshot() throw()
+		{
+			if (!emulator.search)
+				return RESULT_ERR_NOT_READY;
+
+			emulator.search->Snapshot();
+
+			return RESULT_OK;
+		}
+
+		ulong RamSearch::NumCandidates() const throw()
+		{
+			return emulator.search ? emulator.search->NumCandidates() : 0;
+		}
+
+		long RamSearch::NextCandidate(const long address) const throw()
+		{
+			if (!emulator.search || address >= long(emulator.search->Size()))
+				return -1;
+
+			const dword next = emulator.search->Next( address < 0 ? 0 : address + 1 );
+
+			return next != Core::RamSearch::NONE ? long(next) : -1;
+		}
+
+		long RamSearch::GetValue(const ulong address,const bool previous) const throw()
+		{
+			if (!emulator.search || address + emulator.search->Width() > emulator.search->Size())
+				return 0;
+
+			const dword value = emulator.search->GetValue( address, previous );
+			const uint bits = emulator.search->Width() * 8;
+
+			if (emulator.search->IsSigned() && (value >> (bits - 1) & 0x1))
+				return -long((bits < 32 ? (1UL << bits) - 1 : 0xFFFFFFFF) - value) - 1;
+
+			return long(value);
+		}
+
+		#ifdef NST_MSVC_OPTIMIZE
+		#pragma optimize("", on)
+		#endif
+	}
+}
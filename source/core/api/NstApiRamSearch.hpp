@@ -0,0 +1,238 @@
+////////////////////////////////////////////////////////////////////////////////////////
+//
+// Nestopia - NES/Famicom emulator written in C++
+//
+// Copyright (C) 2003-2008 Martin Freij
+//
+// This file is part of Nestopia.
+//
+// Nestopia is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Nestopia is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Nestopia; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef NST_API_RAMSEARCH_H
+#define NST_API_RAMSEARCH_H
+
+#include "NstApi.hpp"
+
+#ifdef NST_PRAGMA_ONCE
+#pragma once
+#endif
+
+#if NST_ICC >= 810
+#pragma warning( push )
+#pragma warning( disable : 444 )
+#elif NST_MSVC >= 1200
+#pragma warning( push )
+#pragma warning( disable : 4512 )
+#endif
+
+namespace Nes
+{
+	namespace Api
+	{
+		/**
+		* RAM search interface.
+		*
+		* Narrows down the addresses of a memory region holding a value,
+		* e.g. a score or a number of lives, by filtering a set of candidate
+		* addresses against a condition over and over. Each filter compares
+		* the values against a constant or against the values at the last
+		* filter, which are then remembered for the next one. Filters can
+		* also be scheduled to run at the end of each of a number of frames.
+		*
+		* Values are little-endian and may start at any address. A search
+		* ends when the game is unloaded.
+		*/
+		class RamSearch : public Base
+		{
+		public:
+
+			/**
+			* Interface constructor.
+			*
+			* @param instance emulator instance
+			*/
+			template<typename T>
+			RamSearch(T& instance)
+			: Base(instance) {}
+
+			/**
+			* Memory region.
+			*/
+			enum Region
+			{
+				/**
+				* 2k CPU RAM.
+				*/
+				REGION_CPU_RAM,
+				/**
+				* Cartridge work RAM.
+				*/
+				REGION_WRAM,
+				/**
+				* Cartridge CHR-RAM.
+				*/
+				REGION_CHR_RAM
+			};
+
+			/**
+			* Comparison a candidate must pass to be kept.
+			*/
+			enum Compare
+			{
+				/**
+				* Value equal to the operand.
+				*/
+				COMPARE_EQUAL,
+				/**
+				* Value not equal to the operand.
+				*/
+				COMPARE_NOT_EQUAL,
+				/**
+				* Value less than the operand.
+				*/
+				COMPARE_LESS,
+				/**
+				* Value less than or equal to the operand.
+				*/
+				COMPARE_LESS_EQUAL,
+				/**
+				* Value greater than the operand.
+				*/
+				COMPARE_GREATER,
+				/**
+				* Value greater than or equal to the operand.
+				*/
+				COMPARE_GREATER_EQUAL,
+				/**
+				* Value changed by the given amount since the last filter, wrapping around.
+				*/
+				COMPARE_CHANGED_BY
+			};
+
+			/**
+			* What a value is compared against.
+			*/
+			enum Operand
+			{
+				/**
+				* The value at the same address at the last filter.
+				*/
+				OPERAND_PREVIOUS,
+				/**
+				* A constant.
+				*/
+				OPERAND_VALUE
+			};
+
+			/**
+			* Starts a search.
+			*
+			* Every address a value fits at becomes a candidate and the
+			* values are remembered for the first filter. Any previous
+			* search is discarded.
+			*
+			* @param region memory region to search
+			* @param size value size in bytes, 1, 2 or 4
+			* @param sign true if values are signed
+			* @return result code
+			*/
+			Result Start(Region region,uint size=1,bool sign=false) throw();
+
+			/**
+			* Ends the search and releases its memory.
+			*
+			* @return result code
+			*/
+			Result Stop() throw();
+
+			/**
+			* Checks if a search is going on.
+			*
+			* @return true if searching
+			*/
+			bool IsRunning() const throw();
+
+			/**
+			* Filters the candidates.
+			*
+			* @param compare comparison
+			* @param operand what to compare against, ignored for COMPARE_CHANGED_BY
+			* @param value constant for OPERAND_VALUE, amount for COMPARE_CHANGED_BY
+			* @return result code
+			*/
+			Result Filter(Compare compare,Operand operand=OPERAND_PREVIOUS,long value=0) throw();
+
+			/**
+			* Filters the candidates at the end of each of the next frames.
+			*
+			* Replaces any filter already scheduled.
+			*
+			* @param frames number of frames, 0 to cancel
+			* @param compare comparison
+			* @param operand what to compare against, ignored for COMPARE_CHANGED_BY
+			* @param value constant for OPERAND_VALUE, amount for COMPARE_CHANGED_BY
+			* @return result code
+			*/
+			Result Schedule(ulong frames,Compare compare,Operand operand=OPERAND_PREVIOUS,long value=0) throw();
+
+			/**
+			* Returns the number of frames left of the scheduled filter.
+			*
+			* @return number
+			*/
+			ulong NumScheduled() const throw();
+
+			/**
+			* Remembers the current values for the next filter without filtering.
+			*
+			* @return result code
+			*/
+			Result Snapshot() throw();
+
+			/**
+			* Returns the number of candidates left.
+			*
+			* @return number
+			*/
+			ulong NumCandidates() const throw();
+
+			/**
+			* Returns the next candidate.
+			*
+			* @param address address to search from, -1 for the first candidate
+			* @return address of the next candidate after the given one, or -1 if none
+			*/
+			long NextCandidate(long address=-1) const throw();
+
+			/**
+			* Returns a value.
+			*
+			* @param address address in the region
+			* @param previous true for the value remembered at the last filter
+			* @return value, sign-extended for a signed search
+			*/
+			long GetValue(ulong address,bool previous=false) const throw();
+		};
+	}
+}
+
+#if NST_MSVC >= 1200 || NST_ICC >= 810
+#pragma warning( pop )
+#endif
+
+#endif
@@ -0,0 +1,187 @@
+////////////////////////////////////////////////////////////////////////////////////////
+//
+// Nestopia - NES/Famicom emulator written in C++
+//
+// Copyright (C) 2003-2008 Martin Freij
+//
+// This file is part of Nestopia.
+//
+// Nestopia is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Nestopia is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Nestopia; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////////////
+
+#include <new>
+#include "../NstMachine.hpp"
+#include "../NstTracer.hpp"
+#include "NstApiTracer.hpp"
+
+namespace Nes
+{
+	namespace Api
+	{
+		#ifdef NST_MSVC_OPTIMIZE
+		#pragma optimize("s", on)
+		#endif
+
+		Result Tracer::Start(ulong size,const Trigger& trigger,ulong count) throw()
+		{
+			if (emulator.tracer && emulator.tracer->IsBusy())
+				return RESULT_ERR_NOT_READY;
+
+			if (!size || size > 0x8000000 || (trigger.type == TRIGGER_CONDITION && !trigger.condition))
+				return RESULT_ERR_INVALID_PARAM;
+
+			try
+			{
+				if (emulator.tracer == NULL)
+					emulator.tracer = new Core::Tracer;
+
+				emulator.tracer->Start( size, trigger, count );
+			}
+			catch (const std::bad_alloc&)
+			{
+				Release();
+				return RESULT_ERR_OUT_OF_MEMORY;
+			}
+			catch (...)
+			{
+				Release();
+				return RESULT_ERR_GENERIC;
+			}
+
+			return RESULT_OK;
+		}
+
+		Result Tracer::Stop() throw()
+		{
+			if (emulator.tracer && emulator.tracer->IsBusy())
+				return RESULT_ERR_NOT_READY;
+
+			if (!emulator.tracer || !emulator.tracer->IsRunning())
+				return RESULT_NOP;
+
+			emulator.tracer->Stop();
+			emulator.cpu.SetTracer( NULL );
+
+			return RESULT_OK;
+		}
+
+		Result Tracer::Release() throw()
+		{
+			if (emulator.tracer && emulator.tracer->IsBusy())
+				return RESULT_ERR_NOT_READY;
+
+			if (!emulator.tracer)
+				return RESULT_NOP;
+
+			emulator.cpu.SetTracer( NULL );
+
+			delete emulator.tracer;
+			emulator.tracer = NULL;
+
+			return RESULT_OK;
+		}
+
+		bool Tracer::IsRunning() const throw()
+		{
+			return emulator.tracer && emulator.tracer->IsRunning();
+		}
+
+		bool Tracer::IsTriggered() const throw()
+		{
+			return emulator.tracer && emulator.tracer->IsTriggered();
+		}
+
+		ulong Tracer::NumEntries() const throw()
+		{
+			return emulator.tracer ? emulator.tracer->NumEntries() : 0;
+		}
+
+		Result Tracer::GetEntry(ulong index,Entry& entry) const throw()
+		{
+			if (index >= NumEntries())
+				return RESULT_ERR_INVALID_PARAM;
+
+			entry = emulator.tracer->GetEntry( index );
+
+			return RESULT_OK;
+		}
+
+		Result Tracer::Save(std::ostream& stream) const throw()
+		{
+			if (!emulator.tracer)
+				return RESULT_ERR_NOT_READY;
+
+			try
+			{
+				emulator.tracer->Save( &stream );
+			}
+			catch (Result result)
+			{
+				return result;
+			}
+			catch (const std::bad_alloc&)
+			{
+				return RESULT_ERR_OUT_OF_MEMORY;
+			}
+			catch (...)
+			{
+				return RESULT_ERR_GENERIC;
+			}
+
+			return RESULT_OK;
+		}
+
+		Result Tracer::ReadHeader(std::istream& stream,Header& header) throw()
+		{
+			try
+			{
+				Core::Tracer::ReadHeader( &stream, header );
+			}
+			catch (Result result)
+			{
+				return result;
+			}
+			catch (...)
+			{
+				return RESULT_ERR_GENERIC;
+			}
+
+			return RESULT_OK;
+		}
+
+		Result Tracer::ReadEntry(std::istream& stream,Entry& entry) throw()
+		{
+			try
+			{
+				Core::Tracer::ReadEntry( &stream, entry );
+			}
+			catch (Result result)
+			{
+				return result;
+			}
+			catch (...)
+			{
+				return RESULT_ERR_GENERIC;
+			}
+
+			return RESULT_OK;
+		}
+
+		#ifdef NST_MSVC_OPTIMIZE
+		#pragma optimize("", on)
+		#endif
+	}
+}
@@ -0,0 +1,331 @@
+////////////////////////////////////////////////////////////////////////////////////////
+//
+// Nestopia - NES/Famicom emulator written in C++
+//
+// Copyright (C) 2003-2008 Martin Freij
+//
+// This file is part of Nestopia.
+//
+// Nestopia is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Nestopia is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Nestopia; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef NST_API_TRACER_H
+#define NST_API_TRACER_H
+
+#include <iosfwd>
+#include "NstApi.hpp"
+
+#ifdef NST_PRAGMA_ONCE
+#pragma once
+#endif
+
+#if NST_ICC >= 810
+#pragma warning( push )
+#pragma warning( disable : 444 )
+#elif NST_MSVC >= 1200
+#pragma warning( push )
+#pragma warning( disable : 4512 )
+#endif
+
+namespace Nes
+{
+	namespace Api
+	{
+		/**
+		* CPU trace interface.
+		*
+		* Records every instruction the CPU executes into a fixed-size ring
+		* buffer, keeping the most recent ones. Recording begins when the
+		* trigger fires and goes on until stopped or until the given number
+		* of instructions have been recorded. Emulation is not affected and
+		* costs nothing extra while no trace is running.
+		*/
+		class Tracer : public Base
+		{
+		public:
+
+			/**
+			* Interface constructor.
+			*
+			* @param instance emulator instance
+			*/
+			template<typename T>
+			Tracer(T& instance)
+			: Base(instance) {}
+
+			enum
+			{
+				/**
+				* Default number of entries in the ring buffer.
+				*/
+				DEFAULT_SIZE = 0x100000,
+				/**
+				* Size of an entry in a saved trace.
+				*/
+				ENTRY_SIZE = 20
+			};
+
+			/**
+			* Trace entry.
+			*
+			* The state of the CPU just before an instruction is executed.
+			*/
+			struct Entry
+			{
+				/**
+				* Frame number, as counted by the machine.
+				*/
+				dword frame;
+
+				/**
+				* Master clock cycle in the frame the instruction begins at.
+				*/
+				dword cycle;
+
+				/**
+				* Program counter.
+				*/
+				ushort pc;
+
+				/**
+				* Opcode.
+				*/
+				uchar opcode;
+
+				/**
+				* Accumulator.
+				*/
+				uchar a;
+
+				/**
+				* X register.
+				*/
+				uchar x;
+
+				/**
+				* Y register.
+				*/
+				uchar y;
+
+				/**
+				* Stack pointer.
+				*/
+				uchar sp;
+
+				/**
+				* Status register.
+				*/
+				uchar p;
+
+				/**
+				* PPU scanline, -1 for the pre-render line.
+				*/
+				short scanline;
+
+				/**
+				* PPU dot in the scanline.
+				*/
+				ushort dot;
+			};
+
+			/**
+			* Condition callback prototype.
+			*
+			* Called before every instruction until it returns true. Start(),
+			* Stop() and Release() return RESULT_ERR_NOT_READY from within it.
+			*
+			* @param userData optional user data
+			* @param entry the instruction about to be executed
+			* @return true to start recording with this instruction
+			*/
+			typedef bool (NST_CALLBACK *Condition) (UserData userData,const Entry& entry);
+
+			/**
+			* Trigger type.
+			*/
+			enum TriggerType
+			{
+				/**
+				* Record from the next instruction on.
+				*/
+				TRIGGER_NOW,
+				/**
+				* Record from the first instruction at an address.
+				*/
+				TRIGGER_ADDRESS,
+				/**
+				* Record from the start of a frame.
+				*/
+				TRIGGER_FRAME,
+				/**
+				* Record from the first instruction a condition callback accepts.
+				*/
+				TRIGGER_CONDITION
+			};
+
+			/**
+			* Trigger.
+			*/
+			struct Trigger
+			{
+				/**
+				* Default constructor, records right away.
+				*/
+				Trigger()
+				: type(TRIGGER_NOW), address(0), frame(0), condition(NULL), userData(NULL) {}
+
+				/**
+				* Type.
+				*/
+				TriggerType type;
+
+				/**
+				* Address for TRIGGER_ADDRESS.
+				*/
+				ushort address;
+
+				/**
+				* Frame number for TRIGGER_FRAME.
+				*/
+				dword frame;
+
+				/**
+				* Callback for TRIGGER_CONDITION.
+				*/
+				Condition condition;
+
+				/**
+				* User data passed to the callback.
+				*/
+				UserData userData;
+			};
+
+			/**
+			* Starts a trace.
+			*
+			* Any previous trace is discarded.
+			*
+			* @param size number of entries in the ring buffer
+			* @param trigger when to begin recording
+			* @param count number of entries to record before stopping, 0 to go on until stopped
+			* @return result code
+			*/
+			Result Start(ulong size=DEFAULT_SIZE,const Trigger& trigger=Trigger(),ulong count=0) throw();
+
+			/**
+			* Stops the trace.
+			*
+			* The entries are kept until the next trace is started or the
+			* buffer is released.
+			*
+			* @return result code
+			*/
+			Result Stop() throw();
+
+			/**
+			* Stops the trace and releases the buffer.
+			*
+			* @return result code
+			*/
+			Result Release() throw();
+
+			/**
+			* Checks if a trace is waiting for its trigger or recording.
+			*
+			* @return true if running
+			*/
+			bool IsRunning() const throw();
+
+			/**
+			* Checks if the trigger has fired.
+			*
+			* @return true if triggered
+			*/
+			bool IsTriggered() const throw();
+
+			/**
+			* Returns the number of entries in the buffer.
+			*
+			* @return number
+			*/
+			ulong NumEntries() const throw();
+
+			/**
+			* Returns an entry.
+			*
+			* @param index index of the entry, 0 being the oldest
+			* @param entry entry to be filled
+			* @return result code
+			*/
+			Result GetEntry(ulong index,Entry& entry) const throw();
+
+			/**
+			* Saves the entries, oldest first.
+			*
+			* Can be done while the trace is running.
+			*
+			* @param stream output stream
+			* @return result code
+			*/
+			Result Save(std::ostream& stream) const throw();
+
+			/**
+			* Saved trace header.
+			*/
+			struct Header
+			{
+				/**
+				* Number of entries that follow.
+				*/
+				dword count;
+
+				/**
+				* Master clock cycles per CPU cycle.
+				*/
+				uint clock;
+
+				/**
+				* CPU model the trace was taken on, one of Cartridge::Profile::System::Cpu.
+				*/
+				uint model;
+			};
+
+			/**
+			* Reads the header of a saved trace.
+			*
+			* @param stream input stream
+			* @param header header to be filled
+			* @return result code
+			*/
+			static Result ReadHeader(std::istream& stream,Header& header) throw();
+
+			/**
+			* Reads the next entry of a saved trace.
+			*
+			* @param stream input stream, past the header
+			* @param entry entry to be filled
+			* @return result code
+			*/
+			static Result ReadEntry(std::istream& stream,Entry& entry) throw();
+		};
+	}
+}
+
+#if NST_MSVC >= 1200 || NST_ICC >= 810
+#pragma warning( pop )
+#endif
+
+#endif
@@ -24,6 +24,7 @@
 
 #include "../NstMachine.hpp"
 #include "../NstVideoRenderer.hpp"
+#include "NstApiMachine.hpp"
 #include "NstApiVideo.hpp"
 
 namespace Nes
@@ -214,6 +215,22 @@ namespace Nes
 			return RESULT_ERR_NOT_READY;
 		}
 
+		Result Video::GetPixels(ushort* pixels) const throw()
+		{
+			if (pixels == NULL)
+				return RESULT_ERR_INVALID_PARAM;
+
+			if (!emulator.Is(Api::Machine::GAME))
+				return RESULT_ERR_NOT_READY;
+
+			const Core::Video::Screen::Pixel* NST_RESTRICT src = emulator.ppu.GetScreen().pixels;
+
+			for (uint i=0; i < Core::Video::Screen::PIXELS; ++i)
+				pixels[i] = src[i];
+
+			return RESULT_OK;
+		}
+
 		Video::RenderState::RenderState() throw()
 		:
 		width  (0),
@@ -415,6 +415,17 @@ namespace Nes
 			*/
 			Result Blit(Output& output) throw();
 
+			/**
+			* Copies out the unfiltered picture of the last frame.
+			*
+			* Each pixel is a 9 bit value with the palette index in the lower 6 bits
+			* and the color emphasis in the upper 3 bits.
+			*
+			* @param pixels buffer of at least Output::WIDTH * Output::HEIGHT entries
+			* @return result code
+			*/
+			Result GetPixels(ushort* pixels) const throw();
+
 			/**
 			* YUV decoder presets.
 			*/
@@ -3758,6 +3758,48 @@ namespace Nes
 				delete board;
 			}
 
+			Board* Board::Clone(Cpu& c,Apu& a,Ppu& p,Ram& prgRom,Ram& chrRom,const Ram& trainer,Chips& chips) const
+			{
+				// same type on another machine, the state is carried over separately
+
+				Context context( &c, &a, &p, prgRom, chrRom, trainer, board.GetStartupNmt(), board.HasBattery(), false, chips );
+				context.type = board;
+
+				return Create( context );
+			}
+
+			bool Board::WritesTo(const Ram& rom) const
+			{
+				if (!rom.Size())
+					return false;
+
+				const Chr& chrMem = chr;
+				const Nmt& nmtMem = nmt;
+
+				const Ram* const sources[] =
+				{
+					&prg.Source(0),
+					&prg.Source(1),
+					&wrk.Source(0),
+					&wrk.Source(1),
+					&chrMem.Source(0),
+					&chrMem.Source(1),
+					&nmtMem.Source(0),
+					&nmtMem.Source(1)
+				};
+
+				const byte* const begin = rom.Mem();
+				const byte* const end = begin + rom.Masking() + 1;
+
+				for (uint i=0; i < sizeof(array(sources)); ++i)
+				{
+					if (sources[i]->Writable() && sources[i]->Size() && sources[i]->Mem() >= begin && sources[i]->Mem() < end)
+						return true;
+				}
+
+				return false;
+			}
+
 			#ifdef NST_MSVC_OPTIMIZE
 			#pragma optimize("", on)
 			#endif
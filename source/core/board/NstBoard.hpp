@@ -672,6 +672,9 @@ namespace Nes
 				static Board* Create(const Context&);
 				static void Destroy(Board*);
 
+				Board* Clone(Cpu&,Apu&,Ppu&,Ram&,Ram&,const Ram&,Chips&) const;
+				bool WritesTo(const Ram&) const;
+
 				void Reset(bool);
 
 				virtual void Load(File&);
@@ -877,6 +880,28 @@ namespace Nes
 				{
 					cpu.Map( address ).Set( t, u );
 				}
+
+			public:
+
+				const Prg& GetPrg() const
+				{
+					return prg;
+				}
+
+				const Wrk& GetWrk() const
+				{
+					return wrk;
+				}
+
+				const Vram& GetVram() const
+				{
+					return vram;
+				}
+
+				const Type& GetType() const
+				{
+					return board;
+				}
 			};
 		}
 	}
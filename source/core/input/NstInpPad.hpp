@@ -55,6 +55,7 @@ namespace Nes
 				uint stream;
 				uint state;
 
+				uint unfiltered_buttons;
 				uint unfiltered_buttons_last;
 				uint lurd_lr, lurd_ud;
 
@@ -32,6 +32,11 @@
 #include "audio.h"
 #include "video.h"
 #include "input.h"
+#include "savestate.h"
+#include "capture.h"
+#include "shmout.h"
+#include "netplay.h"
+#include "pacer.h"
 
 #include "sdlinput.h"
 
@@ -47,30 +52,90 @@ GtkWidget *gtkwindow;
 static GtkWidget *menubar;
 static GtkWidget *drawingarea;
 
+// With the emulation thread running, the interface holds emumutex at all
+// times except while it sleeps waiting for events and while it presents a
+// frame. Anything touching the emulator from either thread is serialized.
 static GThread *emuthread;
+static GMutex emumutex;
+static gint emurunning;
+static gint emuwaiting;
 
 char iconpath[512];
 char padpath[512];
 
 extern bool (*nst_archive_select)(const char*, char*, size_t);
+extern void (*nst_input_poll)();
 
 extern Input::Controllers *cNstPads;
 extern nstpaths_t nstpaths;
 int nst_quit = 1;
 
+static void gtkui_input_poll() {
+	// Read the joysticks
+	SDL_Event event;
+	while (SDL_PollEvent(&event)) {
+		switch (event.type) {
+			case SDL_JOYHATMOTION:
+			case SDL_JOYAXISMOTION:
+			case SDL_JOYBUTTONDOWN:
+			case SDL_JOYBUTTONUP:
+				nstsdl_input_process(cNstPads, event);
+				break;
+			default: break;
+		}	
+	}
+}
+
+static void gtkui_emulock() {
+	// Take the lock ahead of the emulation thread
+	g_atomic_int_inc(&emuwaiting);
+	g_mutex_lock(&emumutex);
+	g_atomic_int_add(&emuwaiting, -1);
+}
+
+static gint gtkui_emupoll(GPollFD *fds, guint nfds, gint timeout) {
+	// Let the emulation thread run while the interface sleeps
+	g_mutex_unlock(&emumutex);
+	gint ret = g_poll(fds, nfds, timeout);
+	gtkui_emulock();
+	return ret;
+}
+
 gpointer gtkui_emuloop(gpointer data) {
-	while(!nst_quit) { nst_emuloop(); }
-	g_thread_exit(emuthread);
+	while (g_atomic_int_get(&emurunning)) {
+		// Hold off until the frame is due, outside the lock
+		if (nst_timing_paced()) { nst_pacer_wait(); }
+		else if (!nst_playing()) { g_usleep(10000); }
+		
+		// The interface always goes first
+		while (g_atomic_int_get(&emuwaiting)) { g_thread_yield(); }
+		
+		// Input is sampled once, right before the frame that uses it
+		g_mutex_lock(&emumutex);
+		gtkui_input_poll();
+		nst_emuloop();
+		g_mutex_unlock(&emumutex);
+	}
 	return NULL;
 }
 
 void gtkui_emuloop_start() {
-	nst_quit = 0;
+	// Move emulation off the interface thread
+	if (emuthread) { return; }
+	g_mutex_lock(&emumutex);
+	g_main_context_set_poll_func(NULL, gtkui_emupoll);
+	g_atomic_int_set(&emurunning, 1);
 	emuthread = g_thread_new("emuloop", gtkui_emuloop, NULL);
 }
 
 void gtkui_emuloop_stop() {
-	nst_quit = true;
+	// Bring the emulation thread to a halt, the interface keeps the lock
+	if (!emuthread) { return; }
+	g_atomic_int_set(&emurunning, 0);
+	g_mutex_unlock(&emumutex);
+	g_thread_join(emuthread);
+	g_mutex_lock(&emumutex);
+	emuthread = NULL;
 }
 
 void gtkui_quit() {
@@ -87,22 +152,19 @@ static void gtkui_glarea_realize(GtkGLArea *glarea) {
 static void gtkui_swapbuffers() {
 	gtk_widget_queue_draw(drawingarea);
 	gtk_widget_queue_draw(menubar); // Needed on some builds of GTK3
-	nst_ogl_render();
-	nst_emuloop();
 	
-	// Move this later FIXME
-	SDL_Event event;
-	while (SDL_PollEvent(&event)) {
-		switch (event.type) {
-			case SDL_JOYHATMOTION:
-			case SDL_JOYAXISMOTION:
-			case SDL_JOYBUTTONDOWN:
-			case SDL_JOYBUTTONUP:
-				nstsdl_input_process(cNstPads, event);
-				break;
-			default: break;
-		}	
+	if (emuthread) {
+		// Present the newest frame while emulation carries on
+		g_mutex_unlock(&emumutex);
+		nst_ogl_render();
+		gtkui_emulock();
+		return;
 	}
+	
+	nst_ogl_render();
+	if (conf.timing_pacer && nst_timing_paced()) { nst_pacer_wait(); }
+	nst_emuloop();
+	gtkui_input_poll();
 }
 
 void gtkui_state_quickload(GtkWidget *widget, gpointer userdata) {
@@ -185,11 +247,18 @@ void gtkui_create() {
 	GtkWidget *palette = gtk_menu_item_new_with_label("Open Palette...");
 	GtkWidget *sep_palette = gtk_separator_menu_item_new();
 	GtkWidget *screenshot = gtk_menu_item_new_with_label("Screenshot...");
+	GtkWidget *dumpstart = gtk_menu_item_new_with_label("Start Frame Dump");
+	GtkWidget *dumpstop = gtk_menu_item_new_with_label("Stop Frame Dump");
 	GtkWidget *sep_screenshot = gtk_separator_menu_item_new();
 	GtkWidget *movieload = gtk_menu_item_new_with_label("Load Movie...");
 	GtkWidget *moviesave = gtk_menu_item_new_with_label("Record Movie...");
 	GtkWidget *moviestop = gtk_menu_item_new_with_label("Stop Movie");
 	GtkWidget *sep_movie = gtk_separator_menu_item_new();
+	GtkWidget *videosave = gtk_menu_item_new_with_label("Record Video...");
+	GtkWidget *videostop = gtk_menu_item_new_with_label("Stop Video");
+	GtkWidget *audiosave = gtk_menu_item_new_with_label("Record Audio...");
+	GtkWidget *audiostop = gtk_menu_item_new_with_label("Stop Audio");
+	GtkWidget *sep_video = gtk_separator_menu_item_new();
 	GtkWidget *quit = gtk_menu_item_new_with_label("Quit");
 	
 	// Set up the recently used items
@@ -239,11 +308,18 @@ void gtkui_create() {
 	gtk_menu_shell_append(GTK_MENU_SHELL(filemenu), palette);
 	gtk_menu_shell_append(GTK_MENU_SHELL(filemenu), sep_palette);
 	gtk_menu_shell_append(GTK_MENU_SHELL(filemenu), screenshot);
+	gtk_menu_shell_append(GTK_MENU_SHELL(filemenu), dumpstart);
+	gtk_menu_shell_append(GTK_MENU_SHELL(filemenu), dumpstop);
 	gtk_menu_shell_append(GTK_MENU_SHELL(filemenu), sep_screenshot);
 	gtk_menu_shell_append(GTK_MENU_SHELL(filemenu), movieload);
 	gtk_menu_shell_append(GTK_MENU_SHELL(filemenu), moviesave);
 	gtk_menu_shell_append(GTK_MENU_SHELL(filemenu), moviestop);
 	gtk_menu_shell_append(GTK_MENU_SHELL(filemenu), sep_movie);
+	gtk_menu_shell_append(GTK_MENU_SHELL(filemenu), videosave);
+	gtk_menu_shell_append(GTK_MENU_SHELL(filemenu), videostop);
+	gtk_menu_shell_append(GTK_MENU_SHELL(filemenu), audiosave);
+	gtk_menu_shell_append(GTK_MENU_SHELL(filemenu), audiostop);
+	gtk_menu_shell_append(GTK_MENU_SHELL(filemenu), sep_video);
 	gtk_menu_shell_append(GTK_MENU_SHELL(filemenu), quit);
 	
 	// Define the Emulator menu
@@ -379,6 +455,12 @@ void gtkui_create() {
 	g_signal_connect(G_OBJECT(screenshot), "activate",
 		G_CALLBACK(gtkui_screenshot_save), NULL);
 	
+	g_signal_connect(G_OBJECT(dumpstart), "activate",
+		G_CALLBACK(gtkui_dump_start), NULL);
+	
+	g_signal_connect(G_OBJECT(dumpstop), "activate",
+		G_CALLBACK(gtkui_dump_stop), NULL);
+	
 	g_signal_connect(G_OBJECT(palette), "activate",
 		G_CALLBACK(gtkui_palette_load), NULL);
 	
@@ -391,6 +473,18 @@ void gtkui_create() {
 	g_signal_connect(G_OBJECT(moviestop), "activate",
 		G_CALLBACK(gtkui_movie_stop), NULL);
 	
+	g_signal_connect(G_OBJECT(videosave), "activate",
+		G_CALLBACK(gtkui_video_save), NULL);
+	
+	g_signal_connect(G_OBJECT(videostop), "activate",
+		G_CALLBACK(gtkui_video_stop), NULL);
+	
+	g_signal_connect(G_OBJECT(audiosave), "activate",
+		G_CALLBACK(gtkui_audio_save), NULL);
+	
+	g_signal_connect(G_OBJECT(audiostop), "activate",
+		G_CALLBACK(gtkui_audio_stop), NULL);
+	
 	g_signal_connect(G_OBJECT(quit), "activate",
 		G_CALLBACK(gtkui_quit), NULL);
 	
@@ -636,9 +730,18 @@ int main(int argc, char *argv[]) {
 		return 1;
 	}
 	
+	// Start the save state worker
+	nst_savestate_init();
+	
+	// Start the screenshot and frame dump worker
+	nst_capture_init();
+	
 	// Set archive handler function pointer
 	nst_archive_select = &gtkui_archive_select;
 	
+	// Set the late input polling function pointer
+	nst_input_poll = &gtkui_input_poll;
+	
 	// Set audio function pointers
 	audio_set_funcs();
 	
@@ -658,15 +761,34 @@ int main(int argc, char *argv[]) {
 	// Load a rom from the command line
 	if (argc > 1 && argv[argc - 1][0] != '-') {
 		nst_load(argv[argc - 1]);
+		nst_netplay_start();
 		if (conf.video_fullscreen) { gtkui_video_toggle_fullscreen(); }
 		gtkui_play();
 		gtkui_set_title(nstpaths.gamename);
 	}
 	else if (conf.video_fullscreen) { conf.video_fullscreen = 0; }
 	
+	// Start the emulation thread
+	if (conf.timing_emuthread) { gtkui_emuloop_start(); }
+	
 	// Start GTK main loop
 	gtk_main();
 	
+	// Stop the emulation thread
+	gtkui_emuloop_stop();
+	
+	// Finish writing any pending save states
+	nst_savestate_deinit();
+	
+	// Finish writing any pending screenshots and frame dumps
+	nst_capture_deinit();
+	
+	// End any netplay session
+	nst_netplay_stop();
+	
+	// Remove the shared memory output
+	nst_shmout_stop();
+	
 	// Remove the cartridge and shut down the NES
 	nst_unload();
 	
@@ -222,6 +222,11 @@ void gtkui_cb_timing_ffspeed(GtkRange *range, gpointer userdata) {
 	conf.timing_ffspeed = (int)gtk_range_get_value(range);
 }
 
+void gtkui_cb_timing_ffunbounded(GtkToggleButton *togglebutton, gpointer userdata) {
+	// Fast-forward as fast as possible or at the set speed
+	conf.timing_ffunbounded = gtk_toggle_button_get_active(togglebutton);
+}
+
 void gtkui_cb_timing_vsync(GtkToggleButton *togglebutton, gpointer userdata) {
 	// Toggle vsync
 	conf.timing_vsync = gtk_toggle_button_get_active(togglebutton);
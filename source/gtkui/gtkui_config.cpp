@@ -982,6 +982,20 @@ GtkWidget *gtkui_config() {
 	g_signal_connect(G_OBJECT(scale_timing_ffspeed), "value-changed",
 		G_CALLBACK(gtkui_cb_timing_ffspeed), NULL);
 	
+	// Unbounded Fast-Forward
+	GtkWidget *check_timing_ffunbounded = gtk_widget_new(
+				GTK_TYPE_CHECK_BUTTON,
+				"label", "Unbounded Fast-Forward",
+				"halign", GTK_ALIGN_START,
+				"margin-left", MARGIN_LR,
+				NULL);
+	gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(check_timing_ffunbounded), conf.timing_ffunbounded);
+	
+	gtk_box_pack_start(GTK_BOX(box_misc), check_timing_ffunbounded, FALSE, FALSE, 0);
+	
+	g_signal_connect(G_OBJECT(check_timing_ffunbounded), "toggled",
+		G_CALLBACK(gtkui_cb_timing_ffunbounded), NULL);
+	
 	// Vsync
 	GtkWidget *check_timing_vsync = gtk_widget_new(
 				GTK_TYPE_CHECK_BUTTON,
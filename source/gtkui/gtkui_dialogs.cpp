@@ -24,6 +24,9 @@
 
 #include "nstcommon.h"
 #include "video.h"
+#include "capture.h"
+#include "nvr.h"
+#include "wavrec.h"
 #include "config.h"
 
 #include "gtkui.h"
@@ -156,6 +159,15 @@ void gtkui_screenshot_save() {
 	gtk_widget_destroy(dialog);
 }
 
+void gtkui_dump_start() {
+	// Dump every frame from now on, next to the screenshots
+	if (nst_playing()) { nst_capture_dump_start(NULL, conf.misc_capture_format); }
+}
+
+void gtkui_dump_stop() {
+	nst_capture_dump_stop();
+}
+
 void gtkui_movie_save() {
 	// Save a movie from the GUI
 	GtkWidget *dialog = gtk_file_chooser_dialog_new("Save movie (.nsv)",
@@ -207,6 +219,64 @@ void gtkui_movie_stop() {
 	nst_movie_stop();
 }
 
+void gtkui_video_save() {
+	// Record lossless video from the GUI
+	if (!nst_playing()) { return; }
+	
+	GtkWidget *dialog = gtk_file_chooser_dialog_new("Record video (.nvr)",
+				GTK_WINDOW(gtkwindow),
+				GTK_FILE_CHOOSER_ACTION_SAVE,
+				"Cancel", GTK_RESPONSE_CANCEL,
+				"Save", GTK_RESPONSE_ACCEPT,
+				NULL);
+	
+	char videopath[512];
+	snprintf(videopath, sizeof(videopath), "%s%s.nvr", nstpaths.nstdir, nstpaths.gamename);
+	gtk_file_chooser_set_current_name(GTK_FILE_CHOOSER(dialog), videopath);
+	gtk_file_chooser_set_current_folder(GTK_FILE_CHOOSER(dialog), nstpaths.nstdir);
+	
+	if (gtk_dialog_run(GTK_DIALOG (dialog)) == GTK_RESPONSE_ACCEPT) {
+		char *filename = gtk_file_chooser_get_filename(GTK_FILE_CHOOSER(dialog));
+		nst_nvr_start(filename);
+		g_free(filename);
+	}
+	
+	gtk_widget_destroy(dialog);
+}
+
+void gtkui_video_stop() {
+	nst_nvr_stop();
+}
+
+void gtkui_audio_save() {
+	// Record the sound from the GUI
+	if (!nst_playing()) { return; }
+	
+	GtkWidget *dialog = gtk_file_chooser_dialog_new("Record audio (.wav)",
+				GTK_WINDOW(gtkwindow),
+				GTK_FILE_CHOOSER_ACTION_SAVE,
+				"Cancel", GTK_RESPONSE_CANCEL,
+				"Save", GTK_RESPONSE_ACCEPT,
+				NULL);
+	
+	char audiopath[512];
+	snprintf(audiopath, sizeof(audiopath), "%s%s.wav", nstpaths.nstdir, nstpaths.gamename);
+	gtk_file_chooser_set_current_name(GTK_FILE_CHOOSER(dialog), audiopath);
+	gtk_file_chooser_set_current_folder(GTK_FILE_CHOOSER(dialog), nstpaths.nstdir);
+	
+	if (gtk_dialog_run(GTK_DIALOG (dialog)) == GTK_RESPONSE_ACCEPT) {
+		char *filename = gtk_file_chooser_get_filename(GTK_FILE_CHOOSER(dialog));
+		nst_wavrec_start(filename);
+		g_free(filename);
+	}
+	
+	gtk_widget_destroy(dialog);
+}
+
+void gtkui_audio_stop() {
+	nst_wavrec_stop();
+}
+
 void gtkui_cheats_load() {
 	// Load cheats from the GUI
 	GtkWidget *dialog = gtk_file_chooser_dialog_new("Load cheats (.xml)",
@@ -6,11 +6,18 @@ void gtkui_state_save();
 void gtkui_state_load();
 
 void gtkui_screenshot_save();
+void gtkui_dump_start();
+void gtkui_dump_stop();
 
 void gtkui_movie_save();
 void gtkui_movie_load();
 void gtkui_movie_stop();
 
+void gtkui_video_save();
+void gtkui_video_stop();
+void gtkui_audio_save();
+void gtkui_audio_stop();
+
 void gtkui_cheats_load();
 
 void gtkui_palette_load();
@@ -26,6 +26,7 @@
 
 #include "nstcommon.h"
 #include "config.h"
+#include "resampler.h"
 #include "audio.h"
 
 extern Emulator emulator;
@@ -39,57 +40,152 @@ static int framerate, channels, bufsize;
 
 static bool paused = false;
 
-void (*audio_output)();
+// Single producer, single consumer ring between the emulator and the audio
+// callback. Positions count samples and wrap freely, the emulator only moves
+// the write position and the callback only moves the read position.
+static int16_t ring[AUDIO_RING_SIZE];
+static SDL_atomic_t ringread, ringwrite;
+static SDL_atomic_t primed; // Set once the ring first reaches the target latency
+static SDL_atomic_t underruns, overruns;
+static int16_t lastsample[2];
+static int latency; // Target fill in samples
+
+static resampler_t resampler;
+static double fillavg;
+
+bool (*audio_output)();
 void (*audio_deinit)();
 
-void audio_output_sdl() {
-	while (SDL_GetQueuedAudioSize(dev) > (Uint32)bufsize) {
-		if (conf.timing_limiter) { SDL_Delay(1); }
+static int audio_ring_fill() {
+	return (unsigned)SDL_AtomicGet(&ringwrite) - (unsigned)SDL_AtomicGet(&ringread);
+}
+
+static int audio_drc(const int16_t **samples) {
+	// Stretch or squeeze the frame a little to steer the ring towards the
+	// target latency, so the speed can follow the display instead of audio
+	static int16_t drcbuf[6400 + 64];
+	int frames = bufsize / 2 / channels;
+	
+	fillavg += (audio_ring_fill() - fillavg) / 8;
+	
+	double ratio = 1.0 + AUDIO_DRC_MAX * (latency - fillavg) / latency;
+	if (ratio > 1.0 + AUDIO_DRC_MAX) { ratio = 1.0 + AUDIO_DRC_MAX; }
+	if (ratio < 1.0 - AUDIO_DRC_MAX) { ratio = 1.0 - AUDIO_DRC_MAX; }
+	
+	*samples = drcbuf;
+	return nst_resampler_run(&resampler, audiobuf, frames, drcbuf, sizeof(drcbuf) / 2 / channels, ratio) * channels;
+}
+
+bool audio_output_sdl() {
+	// Hand the last frame to the callback, never waits
+	const int16_t *buf = audiobuf;
+	int samples = bufsize / 2;
+	unsigned write = SDL_AtomicGet(&ringwrite);
+	
+	// Nothing drains the ring without a device
+	if (!dev) { return true; }
+	
+	// Rate control keeps the fill near the target, leave it room either way
+	if (audio_ring_fill() >= (conf.audio_drc ? latency * 2 : latency)) {
+		// Let the device catch up before emulating more when limiting speed
+		if (conf.timing_limiter) { return false; }
+		
+		SDL_AtomicAdd(&overruns, 1);
+		return true;
 	}
-	SDL_QueueAudio(dev, (const void*)audiobuf, bufsize);
-	// Clear the audio queue arbitrarily to avoid it backing up too far
-	if (SDL_GetQueuedAudioSize(dev) > (Uint32)(bufsize * 3)) { SDL_ClearQueuedAudio(dev); }
+	
+	if (conf.audio_drc) { samples = audio_drc(&buf); }
+	
+	for (int i = 0; i < samples; i++) {
+		ring[(write + i) & (AUDIO_RING_SIZE - 1)] = buf[i];
+	}
+	
+	SDL_AtomicSet(&ringwrite, write + samples);
+	
+	if (audio_ring_fill() >= latency) { SDL_AtomicSet(&primed, 1); }
+	
+	return true;
 }
 
 void audio_deinit_sdl() {
 	if (dev) { SDL_CloseAudioDevice(dev); }
+	dev = 0;
+	
+	if (SDL_AtomicGet(&underruns) || SDL_AtomicGet(&overruns)) {
+		fprintf(stderr, "Audio: %d underruns, %d overruns\n", SDL_AtomicGet(&underruns), SDL_AtomicGet(&overruns));
+	}
 }
 
-void audio_play() {
-	if (paused) { return; }
+bool audio_play() {
+	if (paused) { return true; }
 	bufsize = 2 * channels * (conf.audio_sample_rate / framerate);
-	audio_output();
+	return audio_output();
 }
 
 void audio_cb_sdl(void *data, uint8_t *stream, int len) {
-	uint8_t *soundbuf = (uint8_t*)audiobuf;
+	int16_t *out = (int16_t*)stream;
+	int samples = len / 2;
+	int avail = 0;
+	
+	// Stay quiet until there is enough to play without running dry at once
+	if (SDL_AtomicGet(&primed)) {
+		unsigned read = SDL_AtomicGet(&ringread);
+		avail = audio_ring_fill();
+		if (avail > samples) { avail = samples; }
+		
+		for (int i = 0; i < avail; i++) {
+			out[i] = ring[(read + i) & (AUDIO_RING_SIZE - 1)];
+		}
+		
+		SDL_AtomicSet(&ringread, read + avail);
+		
+		if (avail < samples) { SDL_AtomicAdd(&underruns, 1); }
+	}
+	
+	// Hold the last sample of each channel over a gap rather than clicking
+	for (int i = avail; i < samples; i++) {
+		out[i] = i >= channels ? out[i - channels] : lastsample[i];
+	}
 	
-	for (int i = 0; i < len; i++) {
-		stream[i] = soundbuf[i];
+	if (samples >= channels) {
+		for (int i = 0; i < channels; i++) { lastsample[i] = out[samples - channels + i]; }
 	}
 }
 
 void audio_init_sdl() {
+	// Callback buffers of a power of two no larger than a frame
+	int frame = conf.audio_sample_rate / framerate;
+	int cbsamples = 64;
+	while (cbsamples * 2 <= frame) { cbsamples *= 2; }
+	
 	spec.freq = conf.audio_sample_rate;
 	spec.format = AUDIO_S16SYS;
 	spec.channels = channels;
 	spec.silence = 0;
-	spec.samples = (conf.audio_sample_rate / framerate);
+	spec.samples = cbsamples;
 	spec.userdata = 0;
-	spec.callback = NULL; // Use SDL_QueueAudio instead
-	//spec.callback = audio_cb_sdl;
+	spec.callback = audio_cb_sdl;
 	
-	dev = SDL_OpenAudioDevice(NULL, 0, &spec, &obtained, SDL_AUDIO_ALLOW_ANY_CHANGE);
+	// Only take a device that plays exactly what the ring holds
+	dev = SDL_OpenAudioDevice(NULL, 0, &spec, &obtained, 0);
 	if (!dev) {
 		fprintf(stderr, "Error opening audio device.\n");
 	}
 	else {
-		fprintf(stderr, "Audio: SDL - %dHz %d-bit, %d channel(s)\n", spec.freq, 16, spec.channels);
+		fprintf(stderr, "Audio: SDL - %dHz %d-bit, %d channel(s), %dms latency\n",
+			spec.freq, 16, spec.channels, conf.audio_latency);
 	}
 	
 	SDL_PauseAudioDevice(dev, 1);  // Setting to 0 unpauses
 }
 
+void audio_stats(int *fill, int *underrun, int *overrun) {
+	// Report the ring fill in milliseconds and the counters
+	*fill = audio_ring_fill() * 1000 / (conf.audio_sample_rate * channels);
+	*underrun = SDL_AtomicGet(&underruns);
+	*overrun = SDL_AtomicGet(&overruns);
+}
+
 void audio_set_funcs() {
 	// SDL
 	audio_output = &audio_output_sdl;
@@ -102,6 +198,20 @@ void audio_init() {
 	framerate = nst_pal() ? (conf.timing_speed / 6) * 5 : conf.timing_speed;
 	channels = conf.audio_stereo ? 2 : 1;
 	memset(audiobuf, 0, sizeof(audiobuf));
+	
+	// Start over with an empty ring
+	int ms = conf.audio_latency < 10 ? 10 : conf.audio_latency > 250 ? 250 : conf.audio_latency;
+	latency = conf.audio_sample_rate * channels * ms / 1000;
+	SDL_AtomicSet(&ringread, 0);
+	SDL_AtomicSet(&ringwrite, 0);
+	SDL_AtomicSet(&primed, 0);
+	SDL_AtomicSet(&underruns, 0);
+	SDL_AtomicSet(&overruns, 0);
+	lastsample[0] = lastsample[1] = 0;
+	
+	nst_resampler_init(&resampler, channels);
+	fillavg = latency;
+	
 	audio_set_funcs();
 	audio_init_sdl();
 	paused = false;
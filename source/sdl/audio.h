@@ -7,14 +7,19 @@
 
 using namespace Nes::Api;
 
+// Samples in the ring, enough for twice 250ms of 96kHz stereo plus a frame
+#define AUDIO_RING_SIZE 131072
+#define AUDIO_DRC_MAX 0.005 // Largest rate adjustment
+
 extern void (*audio_deinit)();
 
 void audio_set_funcs();
 void audio_init();
-void audio_play();
+bool audio_play();
 void audio_pause();
 void audio_unpause();
 void audio_set_params(Sound::Output *soundoutput);
 void audio_adj_volume();
+void audio_stats(int *fill, int *underrun, int *overrun);
 
 #endif